@@ -0,0 +1,271 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "BSPNeighborGraph.h"
+#include "BSPNeighborSearcher.h"
+
+// STL
+#include <iostream>
+#include <vector>
+
+// VTK
+#include <vtkIdList.h>
+#include <vtkTimerLog.h>
+
+// Custom
+#include "BuildNeighborGraph.h"
+#include "SpaceFillingCurve.h"
+
+namespace
+{
+// One BSP neighbor query per point, see BuildNeighborGraph.h. The candidates are the
+// k nearest points, within the searcher's budget, or the points within Radius if it
+// is not negative. Query i is about the point QueryIds[i] if there are query ids,
+// about the location at QueryPoints[3*i] if there are query points and about the
+// point i otherwise.
+//
+// The queries call the core search directly with scratch storage that every thread
+// keeps, rather than going through the vtkIdList methods of the searcher, which
+// allocate on every query. The search and the halfspace filter run as one call, so
+// their time is recorded together as the k nearest phase. The debug sink is not
+// given these queries.
+template <typename TIndex, typename TSearch>
+class BSPNeighborQuery
+{
+public:
+  typedef typename TSearch::IndexType::ScalarType ScalarType;
+
+  BSPNeighborQuery(const TSearch* search, const SmartNeighbors::SearchBudget& budget, unsigned int k, double radius,
+                   SmartNeighbors::NeighborSearchStats* stats, const vtkIdType* queryIds = 0,
+                   const double* queryPoints = 0)
+    : Search(search), Budget(budget), K(k), Radius(radius), Stats(stats), QueryIds(queryIds), QueryPoints(queryPoints)
+  {
+  }
+
+  // Every thread gets its own scratch storage, the search is shared read-only
+  BSPNeighborQuery(const BSPNeighborQuery& other)
+    : Search(other.Search), Budget(other.Budget), K(other.K), Radius(other.Radius), Stats(other.Stats),
+      QueryIds(other.QueryIds), QueryPoints(other.QueryPoints)
+  {
+  }
+
+  void operator()(std::size_t queryId, std::vector<TIndex>& neighborIds)
+  {
+    double startTime = this->Stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+    if(this->QueryPoints)
+      {
+      // The location in the precision of the points
+      const double* queryPoint = this->QueryPoints + 3 * queryId;
+      ScalarType point[3] = {static_cast<ScalarType>(queryPoint[0]), static_cast<ScalarType>(queryPoint[1]),
+                             static_cast<ScalarType>(queryPoint[2])};
+      this->Search->QueryPoint(point, this->K, this->Budget, this->BSPNeighborIds, this->Candidates);
+      }
+    else
+      {
+      std::size_t pointId = this->QueryIds ? static_cast<std::size_t>(this->QueryIds[queryId]) : queryId;
+      if(this->Radius >= 0)
+        {
+        // K caps the candidates, 0 means no cap
+        this->Search->QueryInRadius(pointId, static_cast<ScalarType>(this->Radius), this->K, this->BSPNeighborIds,
+                                    this->Candidates);
+        }
+      else
+        {
+        this->Search->Query(pointId, this->K, this->Budget, this->BSPNeighborIds, this->Candidates);
+        }
+      }
+    for(std::size_t i = 0; i < this->BSPNeighborIds.size(); ++i)
+      {
+      neighborIds.push_back(static_cast<TIndex>(this->BSPNeighborIds[i]));
+      }
+
+    if(this->Stats)
+      {
+      this->ThreadStats.PhaseTime[SmartNeighbors::NeighborSearchStats::KNearestPhase] +=
+        vtkTimerLog::GetUniversalTime() - startTime;
+      this->ThreadStats.NumberOfQueries++;
+      this->ThreadStats.NumberOfCandidates += this->Candidates.size();
+      this->ThreadStats.NumberOfAccepted += this->BSPNeighborIds.size();
+      }
+  }
+
+  void Finish()
+  {
+    if(this->Stats)
+      {
+      this->Stats->Accumulate(this->ThreadStats);
+      }
+  }
+
+private:
+  const TSearch* Search;
+  SmartNeighbors::SearchBudget Budget;
+  unsigned int K;
+  double Radius;
+  SmartNeighbors::NeighborSearchStats* Stats;
+  const vtkIdType* QueryIds;
+  const double* QueryPoints;
+
+  std::vector<typename TSearch::NeighborType> Candidates;
+  std::vector<std::size_t> BSPNeighborIds;
+  SmartNeighbors::NeighborSearchStats ThreadStats;
+};
+
+// The order of the query locations along a Morton curve, so that consecutive queries
+// search the same part of the index while it is in the caches
+void ComputeQueryOrder(const std::vector<double>& queryPoints, std::vector<std::size_t>& order,
+                       SmartNeighbors::NeighborSearchStats* stats)
+{
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  SmartNeighbors::ComputeMortonOrder<double, 3>(queryPoints.empty() ? 0 : &queryPoints[0], queryPoints.size() / 3, 3,
+                                                order);
+
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::CopyPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    }
+}
+
+// Run 'numberOfQueries' queries in the order 'queryOrder' with the core search of
+// 'searcher', whichever precision it has. The graph is in the order of the queries.
+template <typename TIndex>
+void ComputeGraph(BSPNeighborSearcher* searcher, unsigned int k, double radius, const vtkIdType* queryIds,
+                  const double* queryPoints, std::size_t numberOfQueries, const std::size_t* queryOrder,
+                  SmartNeighbors::NeighborGraph<TIndex>* graph, int numberOfThreads,
+                  SmartNeighbors::NeighborSearchStats* stats)
+{
+  if(searcher->GetFloatSearch())
+    {
+    BSPNeighborQuery<TIndex, SmartNeighbors::BSPNeighborSearch<float, 3> > query(
+      searcher->GetFloatSearch(), searcher->GetSearchBudget(), k, radius, stats, queryIds, queryPoints);
+    SmartNeighbors::BuildNeighborGraph(numberOfQueries, query, graph, numberOfThreads, queryOrder);
+    }
+  else
+    {
+    BSPNeighborQuery<TIndex, SmartNeighbors::BSPNeighborSearch<double, 3> > query(
+      searcher->GetDoubleSearch(), searcher->GetSearchBudget(), k, radius, stats, queryIds, queryPoints);
+    SmartNeighbors::BuildNeighborGraph(numberOfQueries, query, graph, numberOfThreads, queryOrder);
+    }
+}
+
+// Query every point of the searcher
+template <typename TIndex>
+void ComputeGraph(BSPNeighborSearcher* searcher, SmartNeighbors::NeighborGraph<TIndex>* graph,
+                  unsigned int k, double radius, int numberOfThreads, SmartNeighbors::NeighborSearchStats* stats)
+{
+  // The order comes from the points of the index, the cloud is not copied for it
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+  std::vector<std::size_t> order;
+  const std::size_t* queryOrder = searcher->GetQueryOrder(order);
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::CopyPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    }
+
+  ComputeGraph(searcher, k, radius, 0, 0, static_cast<std::size_t>(searcher->GetPoints()->GetNumberOfPoints()),
+               queryOrder, graph, numberOfThreads, stats);
+}
+}
+
+void AllBSPNeighbors(vtkPoints* points, BSPNeighborGraph* graph, unsigned int k, int numberOfThreads,
+                     SmartNeighbors::NeighborSearchStats* stats)
+{
+  BSPNeighborSearcher searcher(points, stats);
+  ComputeGraph(&searcher, graph, k, -1.0, numberOfThreads, stats);
+}
+
+void AllBSPNeighbors(BSPNeighborSearcher* searcher, BSPNeighborGraph* graph, unsigned int k, int numberOfThreads,
+                     SmartNeighbors::NeighborSearchStats* stats)
+{
+  ComputeGraph(searcher, graph, k, -1.0, numberOfThreads, stats);
+}
+
+void AllBSPNeighbors(vtkPoints* points, BSPNeighborGraph32* graph, unsigned int k, int numberOfThreads,
+                     SmartNeighbors::NeighborSearchStats* stats)
+{
+  BSPNeighborSearcher searcher(points, stats);
+  AllBSPNeighbors(&searcher, graph, k, numberOfThreads, stats);
+}
+
+void AllBSPNeighbors(BSPNeighborSearcher* searcher, BSPNeighborGraph32* graph, unsigned int k, int numberOfThreads,
+                     SmartNeighbors::NeighborSearchStats* stats)
+{
+  if(searcher->GetPoints()->GetNumberOfPoints() > static_cast<vtkIdType>(VTK_UNSIGNED_INT_MAX))
+    {
+    std::cerr << "The input has " << searcher->GetPoints()->GetNumberOfPoints()
+              << " points, which is too many for 32 bit neighbor ids!" << std::endl;
+    exit(-1);
+    }
+  ComputeGraph(searcher, graph, k, -1.0, numberOfThreads, stats);
+}
+
+void AllBSPNeighborsInRadius(vtkPoints* points, BSPNeighborGraph* graph, double radius, unsigned int maxCandidates,
+                             int numberOfThreads, SmartNeighbors::NeighborSearchStats* stats)
+{
+  BSPNeighborSearcher searcher(points, stats);
+  AllBSPNeighborsInRadius(&searcher, graph, radius, maxCandidates, numberOfThreads, stats);
+}
+
+void AllBSPNeighborsInRadius(BSPNeighborSearcher* searcher, BSPNeighborGraph* graph, double radius,
+                             unsigned int maxCandidates, int numberOfThreads, SmartNeighbors::NeighborSearchStats* stats)
+{
+  if(!(radius >= 0))
+    {
+    std::cerr << "The radius must not be negative!" << std::endl;
+    exit(-1);
+    }
+  ComputeGraph(searcher, graph, maxCandidates, radius, numberOfThreads, stats);
+}
+
+void BSPNeighborsBatch(BSPNeighborSearcher* searcher, vtkIdList* queryIds, BSPNeighborGraph* graph, unsigned int k,
+                       int numberOfThreads, SmartNeighbors::NeighborSearchStats* stats)
+{
+  vtkPoints* points = searcher->GetPoints();
+  std::vector<double> queryPoints(3 * queryIds->GetNumberOfIds());
+  for(vtkIdType i = 0; i < queryIds->GetNumberOfIds(); ++i)
+    {
+    if(queryIds->GetId(i) < 0 || queryIds->GetId(i) >= points->GetNumberOfPoints())
+      {
+      std::cerr << "Query " << i << " is about point " << queryIds->GetId(i) << ", but there are only "
+                << points->GetNumberOfPoints() << " points!" << std::endl;
+      exit(-1);
+      }
+    points->GetPoint(queryIds->GetId(i), &queryPoints[3*i]);
+    }
+  std::vector<std::size_t> order;
+  ComputeQueryOrder(queryPoints, order, stats);
+  ComputeGraph(searcher, k, -1.0, queryIds->GetPointer(0), 0, order.size(), order.empty() ? 0 : &order[0], graph,
+               numberOfThreads, stats);
+}
+
+void BSPNeighborsBatch(BSPNeighborSearcher* searcher, vtkPoints* queryPoints, BSPNeighborGraph* graph, unsigned int k,
+                       int numberOfThreads, SmartNeighbors::NeighborSearchStats* stats)
+{
+  // A copy in double, which is also safe to read from several threads at once
+  std::vector<double> coordinates(3 * queryPoints->GetNumberOfPoints());
+  for(vtkIdType i = 0; i < queryPoints->GetNumberOfPoints(); ++i)
+    {
+    queryPoints->GetPoint(i, &coordinates[3*i]);
+    }
+  std::vector<std::size_t> order;
+  ComputeQueryOrder(coordinates, order, stats);
+  ComputeGraph(searcher, k, -1.0, 0, coordinates.empty() ? 0 : &coordinates[0], order.size(),
+               order.empty() ? 0 : &order[0], graph, numberOfThreads, stats);
+}
@@ -0,0 +1,77 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef BSPNEIGHBORGRAPH_H
+#define BSPNEIGHBORGRAPH_H
+
+// VTK
+#include <vtkIdList.h>
+#include <vtkPoints.h>
+#include <vtkType.h>
+
+// Custom
+#include "NeighborGraph.h"
+#include "NeighborSearchStats.h"
+#include "SymmetrizeNeighborGraph.h"
+
+class BSPNeighborSearcher;
+
+// The BSP neighbors of every point of a cloud, see NeighborGraph.h for the layout.
+// j can be a BSP neighbor of i without i being one of j, use
+// SmartNeighbors::SymmetrizeNeighborGraph() to get an undirected graph.
+typedef SmartNeighbors::NeighborGraph<vtkIdType> BSPNeighborGraph;
+
+// The same graph with 32 bit neighbor ids, for clouds with fewer than 2^32 points
+typedef SmartNeighbors::NeighborGraph<vtkTypeUInt32> BSPNeighborGraph32;
+
+// Compute the BSP neighbors of every point. The queries are split across
+// 'numberOfThreads' threads (0 means use all available cores), all sharing one
+// index, and run in the order of the points along a Morton curve as for
+// BSPNeighborsBatch(). The result does not depend on the number of threads. If 'stats' is
+// given, the timings of all threads are summed into it, so the phase times are
+// CPU seconds rather than elapsed time.
+void AllBSPNeighbors(vtkPoints* points, BSPNeighborGraph* graph, unsigned int k = 10, int numberOfThreads = 0,
+                     SmartNeighbors::NeighborSearchStats* stats = 0);
+void AllBSPNeighbors(BSPNeighborSearcher* searcher, BSPNeighborGraph* graph, unsigned int k = 10, int numberOfThreads = 0,
+                     SmartNeighbors::NeighborSearchStats* stats = 0);
+void AllBSPNeighbors(vtkPoints* points, BSPNeighborGraph32* graph, unsigned int k = 10, int numberOfThreads = 0,
+                     SmartNeighbors::NeighborSearchStats* stats = 0);
+void AllBSPNeighbors(BSPNeighborSearcher* searcher, BSPNeighborGraph32* graph, unsigned int k = 10, int numberOfThreads = 0,
+                     SmartNeighbors::NeighborSearchStats* stats = 0);
+
+// Compute the BSP neighbors of many points at once, row i of 'graph' holding those of
+// the point queryIds->GetId(i). The queries do not run in the order given but in the
+// order of the points along a Morton curve, so consecutive queries search the same
+// part of the index while it is in the caches. On large batches this is much faster
+// than calling BSPNeighbors() for one point after another, and the result is the
+// same. The second version does the same for arbitrary locations, which need not be
+// points of the cloud.
+void BSPNeighborsBatch(BSPNeighborSearcher* searcher, vtkIdList* queryIds, BSPNeighborGraph* graph, unsigned int k = 10,
+                       int numberOfThreads = 0, SmartNeighbors::NeighborSearchStats* stats = 0);
+void BSPNeighborsBatch(BSPNeighborSearcher* searcher, vtkPoints* queryPoints, BSPNeighborGraph* graph, unsigned int k = 10,
+                       int numberOfThreads = 0, SmartNeighbors::NeighborSearchStats* stats = 0);
+
+// Compute the BSP neighbors of every point among the points within 'radius' of it,
+// at most 'maxCandidates' of them unless that is 0, see BSPNeighborsInRadius().
+void AllBSPNeighborsInRadius(vtkPoints* points, BSPNeighborGraph* graph, double radius, unsigned int maxCandidates = 0,
+                             int numberOfThreads = 0, SmartNeighbors::NeighborSearchStats* stats = 0);
+void AllBSPNeighborsInRadius(BSPNeighborSearcher* searcher, BSPNeighborGraph* graph, double radius,
+                             unsigned int maxCandidates = 0, int numberOfThreads = 0,
+                             SmartNeighbors::NeighborSearchStats* stats = 0);
+
+#endif
@@ -0,0 +1,427 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// This algorithm is explained in "Point Primitives for Interactive Modeling and Processing of 3D Geometry"
+
+#include "BSPNeighborSearcher.h"
+
+// VTK
+#include <vtkTimerLog.h>
+
+namespace
+{
+template <typename TNeighbor>
+void CopyIds(const std::vector<TNeighbor>& neighbors, vtkIdList* ids)
+{
+  ids->SetNumberOfIds(static_cast<vtkIdType>(neighbors.size()));
+  for(std::size_t i = 0; i < neighbors.size(); ++i)
+    {
+    ids->SetId(static_cast<vtkIdType>(i), static_cast<vtkIdType>(neighbors[i].Id));
+    }
+}
+
+template <typename TSearch>
+void FindKNearest(const TSearch* search, vtkIdType centerPointId, unsigned int k,
+                  const SmartNeighbors::SearchBudget& budget, vtkIdList* kNearest)
+{
+  std::vector<typename TSearch::NeighborType> nearest;
+  const std::size_t id = static_cast<std::size_t>(centerPointId);
+  search->GetIndex().FindKNearestApproximate(search->GetIndex().GetPoint(id), k, budget, nearest, id);
+  CopyIds(nearest, kNearest);
+}
+
+template <typename TSearch>
+void FindKNearestToPoint(const TSearch* search, const double queryPoint[3], unsigned int k,
+                         const SmartNeighbors::SearchBudget& budget, vtkIdList* kNearest)
+{
+  // The location in the precision of the points
+  typedef typename TSearch::IndexType::ScalarType ScalarType;
+  ScalarType point[3] = {static_cast<ScalarType>(queryPoint[0]), static_cast<ScalarType>(queryPoint[1]),
+                         static_cast<ScalarType>(queryPoint[2])};
+  std::vector<typename TSearch::NeighborType> nearest;
+  search->GetIndex().FindKNearestApproximate(point, k, budget, nearest);
+  CopyIds(nearest, kNearest);
+}
+
+template <typename TSearch>
+void ComputeNormals(const TSearch* search, unsigned int k, double* normals, double* curvatures, int numberOfThreads)
+{
+  typedef typename TSearch::IndexType::ScalarType ScalarType;
+  if(normals)
+    {
+    search->ReduceAll(k, SmartNeighbors::NormalReducer<ScalarType>(normals, curvatures), numberOfThreads);
+    }
+  else if(curvatures)
+    {
+    search->ReduceAll(k, SmartNeighbors::CurvatureReducer<ScalarType>(curvatures), numberOfThreads);
+    }
+}
+
+template <typename TSearch>
+void FindInRadius(const TSearch* search, vtkIdType centerPointId, double radius, unsigned int maxCandidates,
+                  vtkIdList* candidateIds)
+{
+  std::vector<typename TSearch::NeighborType> candidates;
+  search->FindNeighborsInRadius(static_cast<std::size_t>(centerPointId), radius, maxCandidates, candidates);
+  CopyIds(candidates, candidateIds);
+}
+}
+
+BSPNeighborSearcher::BSPNeighborSearcher(vtkPoints* points, SmartNeighbors::NeighborSearchStats* stats,
+                                         SmartNeighbors::PointIndexType indexType, bool reorderPoints)
+  : DebugSink(0), FloatSearch(0), DoubleSearch(0)
+{
+  this->Points = points;
+
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  // The tree is built over the input itself, so its ids are the input ids
+  std::size_t numberOfPoints = static_cast<std::size_t>(this->Points->GetNumberOfPoints());
+  if(this->Points->GetDataType() == VTK_FLOAT && numberOfPoints > 0)
+    {
+    this->FloatSearch = new SmartNeighbors::BSPNeighborSearch<float, 3>(
+      static_cast<const float*>(this->Points->GetVoidPointer(0)), numberOfPoints, 3, indexType, reorderPoints);
+    }
+  else if(this->Points->GetDataType() == VTK_DOUBLE && numberOfPoints > 0)
+    {
+    this->DoubleSearch = new SmartNeighbors::BSPNeighborSearch<double, 3>(
+      static_cast<const double*>(this->Points->GetVoidPointer(0)), numberOfPoints, 3, indexType, reorderPoints);
+    }
+  else
+    {
+    this->Coordinates.resize(3 * numberOfPoints);
+    for(vtkIdType i = 0; i < this->Points->GetNumberOfPoints(); ++i)
+      {
+      this->Points->GetPoint(i, &this->Coordinates[3*i]);
+      }
+    this->DoubleSearch = new SmartNeighbors::BSPNeighborSearch<double, 3>(
+      this->Coordinates.empty() ? 0 : &this->Coordinates[0], numberOfPoints, 3, indexType, reorderPoints);
+    }
+
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::IndexBuildPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    }
+}
+
+BSPNeighborSearcher::~BSPNeighborSearcher()
+{
+  delete this->FloatSearch;
+  delete this->DoubleSearch;
+}
+
+void BSPNeighborSearcher::SetDebugSink(BSPNeighborsDebugSink* debugSink)
+{
+  this->DebugSink = debugSink;
+}
+
+BSPNeighborsDebugSink* BSPNeighborSearcher::GetDebugSink()
+{
+  return this->DebugSink;
+}
+
+void BSPNeighborSearcher::SetSearchBudget(const SmartNeighbors::SearchBudget& budget)
+{
+  this->Budget = budget;
+}
+
+const SmartNeighbors::SearchBudget& BSPNeighborSearcher::GetSearchBudget()
+{
+  return this->Budget;
+}
+
+vtkPoints* BSPNeighborSearcher::GetPoints()
+{
+  return this->Points;
+}
+
+const std::size_t* BSPNeighborSearcher::GetPermutation()
+{
+  if(this->Points->GetNumberOfPoints() == 0)
+    {
+    return 0;
+    }
+  if(this->FloatSearch && this->FloatSearch->GetReorderedIndex())
+    {
+    return &this->FloatSearch->GetReorderedIndex()->GetPermutation()[0];
+    }
+  if(this->DoubleSearch && this->DoubleSearch->GetReorderedIndex())
+    {
+    return &this->DoubleSearch->GetReorderedIndex()->GetPermutation()[0];
+    }
+  return 0;
+}
+
+const std::size_t* BSPNeighborSearcher::GetQueryOrder(std::vector<std::size_t>& order)
+{
+  if(this->FloatSearch)
+    {
+    return this->FloatSearch->GetQueryOrder(order);
+    }
+  return this->DoubleSearch ? this->DoubleSearch->GetQueryOrder(order) : 0;
+}
+
+const SmartNeighbors::BSPNeighborSearch<float, 3>* BSPNeighborSearcher::GetFloatSearch()
+{
+  return this->FloatSearch;
+}
+
+const SmartNeighbors::BSPNeighborSearch<double, 3>* BSPNeighborSearcher::GetDoubleSearch()
+{
+  return this->DoubleSearch;
+}
+
+void BSPNeighborSearcher::FindKNearestNeighbors(vtkIdType centerPointId, unsigned int k, vtkIdList* kNearest,
+                                                SmartNeighbors::NeighborSearchStats* stats)
+{
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  // The search leaves the center point itself out, even where other points coincide with it
+  if(this->FloatSearch)
+    {
+    FindKNearest(this->FloatSearch, centerPointId, k, this->Budget, kNearest);
+    }
+  else
+    {
+    FindKNearest(this->DoubleSearch, centerPointId, k, this->Budget, kNearest);
+    }
+
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::KNearestPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    }
+
+  if(this->DebugSink)
+    {
+    this->DebugSink->KNearestNeighbors(this->Points, centerPointId, kNearest);
+    }
+}
+
+void BSPNeighborSearcher::FindKNearestToPoint(const double queryPoint[3], unsigned int k, vtkIdList* kNearest,
+                                              SmartNeighbors::NeighborSearchStats* stats)
+{
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  if(this->FloatSearch)
+    {
+    ::FindKNearestToPoint(this->FloatSearch, queryPoint, k, this->Budget, kNearest);
+    }
+  else
+    {
+    ::FindKNearestToPoint(this->DoubleSearch, queryPoint, k, this->Budget, kNearest);
+    }
+
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::KNearestPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    }
+}
+
+void BSPNeighborSearcher::FindNeighborsInRadius(vtkIdType centerPointId, double radius, unsigned int maxCandidates,
+                                                vtkIdList* candidateIds, SmartNeighbors::NeighborSearchStats* stats)
+{
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  if(this->FloatSearch)
+    {
+    FindInRadius(this->FloatSearch, centerPointId, radius, maxCandidates, candidateIds);
+    }
+  else
+    {
+    FindInRadius(this->DoubleSearch, centerPointId, radius, maxCandidates, candidateIds);
+    }
+
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::KNearestPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    }
+
+  if(this->DebugSink)
+    {
+    this->DebugSink->KNearestNeighbors(this->Points, centerPointId, candidateIds);
+    }
+}
+
+void BSPNeighborSearcher::FilterHalfSpaces(vtkIdType centerPointId, vtkIdList* candidateIds, vtkIdList* bspNeighborIds,
+                                           SmartNeighbors::NeighborSearchStats* stats)
+{
+  // This only allocates if the list has never held this many ids
+  bspNeighborIds->SetNumberOfIds(candidateIds->GetNumberOfIds());
+  vtkIdType numberOfNeighbors = this->FilterHalfSpaces(centerPointId, candidateIds, bspNeighborIds->GetPointer(0), stats);
+  bspNeighborIds->SetNumberOfIds(numberOfNeighbors);
+}
+
+vtkIdType BSPNeighborSearcher::FilterHalfSpaces(vtkIdType centerPointId, vtkIdList* candidateIds, vtkIdType* bspNeighborIds,
+                                                SmartNeighbors::NeighborSearchStats* stats)
+{
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  std::size_t numberOfCandidates = static_cast<std::size_t>(candidateIds->GetNumberOfIds());
+  std::size_t numberOfNeighbors = 0;
+  if(numberOfCandidates > 0)
+    {
+    // Keep the candidates that are in the halfspaces of all of the candidates, see HalfSpaceFilter.h
+    if(this->FloatSearch)
+      {
+      numberOfNeighbors = this->FloatSearch->FilterHalfSpaces(static_cast<std::size_t>(centerPointId),
+                                                              candidateIds->GetPointer(0), numberOfCandidates, bspNeighborIds);
+      }
+    else
+      {
+      numberOfNeighbors = this->DoubleSearch->FilterHalfSpaces(static_cast<std::size_t>(centerPointId),
+                                                               candidateIds->GetPointer(0), numberOfCandidates, bspNeighborIds);
+      }
+    }
+
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::HalfSpaceFilterPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    stats->NumberOfQueries++;
+    stats->NumberOfCandidates += numberOfCandidates;
+    stats->NumberOfAccepted += numberOfNeighbors;
+    }
+
+  return static_cast<vtkIdType>(numberOfNeighbors);
+}
+
+vtkIdType BSPNeighborSearcher::FilterHalfSpacesAt(const double queryPoint[3], vtkIdList* candidateIds,
+                                                  vtkIdType* bspNeighborIds, SmartNeighbors::NeighborSearchStats* stats)
+{
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  std::size_t numberOfCandidates = static_cast<std::size_t>(candidateIds->GetNumberOfIds());
+  std::size_t numberOfNeighbors = 0;
+  if(numberOfCandidates > 0)
+    {
+    if(this->FloatSearch)
+      {
+      float point[3] = {static_cast<float>(queryPoint[0]), static_cast<float>(queryPoint[1]),
+                        static_cast<float>(queryPoint[2])};
+      numberOfNeighbors = this->FloatSearch->FilterHalfSpacesAt(point, candidateIds->GetPointer(0), numberOfCandidates,
+                                                                bspNeighborIds);
+      }
+    else
+      {
+      numberOfNeighbors = this->DoubleSearch->FilterHalfSpacesAt(queryPoint, candidateIds->GetPointer(0),
+                                                                 numberOfCandidates, bspNeighborIds);
+      }
+    }
+
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::HalfSpaceFilterPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    stats->NumberOfQueries++;
+    stats->NumberOfCandidates += numberOfCandidates;
+    stats->NumberOfAccepted += numberOfNeighbors;
+    }
+
+  return static_cast<vtkIdType>(numberOfNeighbors);
+}
+
+void BSPNeighborSearcher::QueryPoint(const double queryPoint[3], unsigned int k, vtkIdList* bspNeighborIds,
+                                     SmartNeighbors::NeighborSearchStats* stats)
+{
+  vtkSmartPointer<vtkIdList> kNearest =
+    vtkSmartPointer<vtkIdList>::New();
+  this->FindKNearestToPoint(queryPoint, k, kNearest, stats);
+  bspNeighborIds->SetNumberOfIds(kNearest->GetNumberOfIds());
+  bspNeighborIds->SetNumberOfIds(this->FilterHalfSpacesAt(queryPoint, kNearest, bspNeighborIds->GetPointer(0), stats));
+}
+
+void BSPNeighborSearcher::Query(vtkIdType centerPointId, unsigned int k, vtkIdList* bspNeighborIds,
+                                SmartNeighbors::NeighborSearchStats* stats)
+{
+  vtkSmartPointer<vtkIdList> kNearest =
+    vtkSmartPointer<vtkIdList>::New();
+  this->FindKNearestNeighbors(centerPointId, k, kNearest, stats);
+  this->FilterHalfSpaces(centerPointId, kNearest, bspNeighborIds, stats);
+}
+
+vtkIdType BSPNeighborSearcher::Query(vtkIdType centerPointId, unsigned int k, vtkIdType* bspNeighborIds,
+                                     SmartNeighbors::NeighborSearchStats* stats)
+{
+  vtkSmartPointer<vtkIdList> kNearest =
+    vtkSmartPointer<vtkIdList>::New();
+  this->FindKNearestNeighbors(centerPointId, k, kNearest, stats);
+  return this->FilterHalfSpaces(centerPointId, kNearest, bspNeighborIds, stats);
+}
+
+void BSPNeighborSearcher::QueryInRadius(vtkIdType centerPointId, double radius, unsigned int maxCandidates,
+                                        vtkIdList* bspNeighborIds, SmartNeighbors::NeighborSearchStats* stats)
+{
+  vtkSmartPointer<vtkIdList> candidates =
+    vtkSmartPointer<vtkIdList>::New();
+  this->FindNeighborsInRadius(centerPointId, radius, maxCandidates, candidates, stats);
+  this->FilterHalfSpaces(centerPointId, candidates, bspNeighborIds, stats);
+}
+
+void BSPNeighborSearcher::Query(vtkIdType centerPointId, unsigned int k, vtkPoints* bspNeighbors,
+                                SmartNeighbors::NeighborSearchStats* stats)
+{
+  vtkSmartPointer<vtkIdList> bspNeighborIds =
+    vtkSmartPointer<vtkIdList>::New();
+  this->Query(centerPointId, k, bspNeighborIds, stats);
+
+  for(vtkIdType i = 0; i < bspNeighborIds->GetNumberOfIds(); ++i)
+    {
+    double p[3];
+    this->Points->GetPoint(bspNeighborIds->GetId(i), p);
+    bspNeighbors->InsertNextPoint(p);
+    }
+}
+
+void BSPNeighborSearcher::ComputeNormals(unsigned int k, vtkDoubleArray* normals, vtkDoubleArray* curvatures,
+                                         int numberOfThreads, SmartNeighbors::NeighborSearchStats* stats)
+{
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  vtkIdType numberOfPoints = this->Points->GetNumberOfPoints();
+  if(normals)
+    {
+    normals->SetNumberOfComponents(3);
+    normals->SetNumberOfTuples(numberOfPoints);
+    }
+  if(curvatures)
+    {
+    curvatures->SetNumberOfComponents(1);
+    curvatures->SetNumberOfTuples(numberOfPoints);
+    }
+  if(numberOfPoints == 0)
+    {
+    return;
+    }
+
+  double* normalValues = normals ? normals->GetPointer(0) : 0;
+  double* curvatureValues = curvatures ? curvatures->GetPointer(0) : 0;
+  if(this->FloatSearch)
+    {
+    ::ComputeNormals(this->FloatSearch, k, normalValues, curvatureValues, numberOfThreads);
+    }
+  else
+    {
+    ::ComputeNormals(this->DoubleSearch, k, normalValues, curvatureValues, numberOfThreads);
+    }
+
+  // The search and the filter are fused, so their time is counted as filtering
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::HalfSpaceFilterPhase] +=
+      vtkTimerLog::GetUniversalTime() - startTime;
+    stats->NumberOfQueries += static_cast<unsigned long long>(numberOfPoints);
+    }
+}
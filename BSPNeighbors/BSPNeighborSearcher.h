@@ -0,0 +1,161 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef BSPNEIGHBORSEARCHER_H
+#define BSPNEIGHBORSEARCHER_H
+
+// STL
+#include <vector>
+
+// VTK
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+
+// Custom
+#include "BSPNeighborSearch.h"
+#include "BSPNeighborsDebugSink.h"
+#include "NeighborSearchStats.h"
+
+// This class builds a spatial index over a point set once and then answers
+// any number of BSP neighbor queries against it. Use it instead of calling
+// BSPNeighbors() repeatedly on the same points.
+// Every method optionally records its timings and counts into 'stats'.
+//
+// This is a VTK adapter around SmartNeighbors::BSPNeighborSearch. Float and double
+// points are searched in place in their own precision, points of any other type
+// are copied to double first.
+class BSPNeighborSearcher
+{
+public:
+  // The points are referenced, so they must not be modified while the
+  // searcher is in use, and the index keeps a copy of the coordinates in
+  // its own order (see SmartNeighbors/PointIndex.h). Once constructed, the searcher only reads
+  // the points and the index, so queries may run concurrently from several
+  // threads as long as each thread passes its own output lists. The index is
+  // chosen from the points unless 'indexType' says otherwise, the neighbors
+  // found are the same either way (see SmartNeighbors/CreatePointIndex.h).
+  // With 'reorderPoints' the index keeps a copy of the points in Morton order,
+  // which the queries read instead of the input (see
+  // SmartNeighbors/ReorderedPointIndex.h). The ids are still those of the input.
+  BSPNeighborSearcher(vtkPoints* points, SmartNeighbors::NeighborSearchStats* stats = 0,
+                      SmartNeighbors::PointIndexType indexType = SmartNeighbors::AutomaticIndex,
+                      bool reorderPoints = false);
+  ~BSPNeighborSearcher();
+
+  // Nothing is passed to a sink unless one is set. The searcher does not own the sink.
+  void SetDebugSink(BSPNeighborsDebugSink* debugSink);
+  BSPNeighborsDebugSink* GetDebugSink();
+
+  // Limit the effort of every k nearest search, which bounds the cost of a query at
+  // the price of occasionally missing a neighbor, see SmartNeighbors::SearchBudget.
+  // Radius searches are not affected. The default budget searches exactly.
+  void SetSearchBudget(const SmartNeighbors::SearchBudget& budget);
+  const SmartNeighbors::SearchBudget& GetSearchBudget();
+
+  // Find the k nearest neighbors of the point 'centerPointId', not including the point itself,
+  // within the search budget.
+  void FindKNearestNeighbors(vtkIdType centerPointId, unsigned int k, vtkIdList* kNearest,
+                             SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // Find the k points nearest to the location 'queryPoint', which need not be one of the points.
+  // The debug sink is only given queries about points.
+  void FindKNearestToPoint(const double queryPoint[3], unsigned int k, vtkIdList* kNearest,
+                           SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // Find the points within 'radius' of the point 'centerPointId', nearest first, not
+  // including the point itself. If 'maxCandidates' is not 0 the search stops as
+  // soon as it has found that many, which bounds the work in dense regions.
+  void FindNeighborsInRadius(vtkIdType centerPointId, double radius, unsigned int maxCandidates, vtkIdList* candidates,
+                             SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // Keep the candidates that lie in the intersection of the halfspaces induced by all of the candidates.
+  // The second version writes into a caller owned buffer with room for every
+  // candidate and returns the number of ids written.
+  void FilterHalfSpaces(vtkIdType centerPointId, vtkIdList* candidates, vtkIdList* bspNeighborIds,
+                        SmartNeighbors::NeighborSearchStats* stats = 0);
+  vtkIdType FilterHalfSpaces(vtkIdType centerPointId, vtkIdList* candidates, vtkIdType* bspNeighborIds,
+                             SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // The same around the location 'queryPoint', which need not be one of the points
+  vtkIdType FilterHalfSpacesAt(const double queryPoint[3], vtkIdList* candidates, vtkIdType* bspNeighborIds,
+                               SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // Find the BSP neighbors of the point 'centerPointId' among its k nearest neighbors.
+  // The buffer version needs room for k ids and returns the number of ids written.
+  void Query(vtkIdType centerPointId, unsigned int k, vtkPoints* bspNeighbors,
+             SmartNeighbors::NeighborSearchStats* stats = 0);
+  void Query(vtkIdType centerPointId, unsigned int k, vtkIdList* bspNeighborIds,
+             SmartNeighbors::NeighborSearchStats* stats = 0);
+  vtkIdType Query(vtkIdType centerPointId, unsigned int k, vtkIdType* bspNeighborIds,
+                  SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // Find the BSP neighbors of the point 'centerPointId' among the points within 'radius'
+  // of it, see FindNeighborsInRadius().
+  void QueryInRadius(vtkIdType centerPointId, double radius, unsigned int maxCandidates, vtkIdList* bspNeighborIds,
+                     SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // Find the BSP neighbors of the location 'queryPoint' among its k nearest points
+  void QueryPoint(const double queryPoint[3], unsigned int k, vtkIdList* bspNeighborIds,
+                  SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // Compute the unit normal of the BSP neighborhood among the k nearest neighbors of
+  // every point, and its surface variation if 'curvatures' is given, in one pass that
+  // never stores the neighbors, see SmartNeighbors/NeighborhoodReducers.h. Either
+  // array may be 0. They are resized to one tuple per point, of 3 and 1 components.
+  // The work is split across 'numberOfThreads' threads (0 means use all available cores).
+  void ComputeNormals(unsigned int k, vtkDoubleArray* normals, vtkDoubleArray* curvatures = 0,
+                      int numberOfThreads = 0, SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  vtkPoints* GetPoints();
+
+  // The input id of the point at each position of the reordered copy, or 0 if the
+  // points are not reordered
+  const std::size_t* GetPermutation();
+
+  // The order in which to query every point for the best cache use, along a Morton
+  // curve. It is computed from the points of the index without copying them, into
+  // 'order' unless the points are reordered already. Returns the first id of the
+  // order, or 0 if there are no points.
+  const std::size_t* GetQueryOrder(std::vector<std::size_t>& order);
+
+  // The search of the core library, in the precision of the points. Exactly one
+  // is not null. Callers that run many queries can call it with scratch storage
+  // of their own, which saves the allocations of the methods above.
+  const SmartNeighbors::BSPNeighborSearch<float, 3>* GetFloatSearch();
+  const SmartNeighbors::BSPNeighborSearch<double, 3>* GetDoubleSearch();
+
+private:
+  // Not copyable, the searches are deleted by the destructor
+  BSPNeighborSearcher(const BSPNeighborSearcher&);
+  void operator=(const BSPNeighborSearcher&);
+
+  vtkSmartPointer<vtkPoints> Points;
+  BSPNeighborsDebugSink* DebugSink;
+  SmartNeighbors::SearchBudget Budget;
+
+  // Exactly one of these is set, depending on the type of the points
+  SmartNeighbors::BSPNeighborSearch<float, 3>* FloatSearch;
+  SmartNeighbors::BSPNeighborSearch<double, 3>* DoubleSearch;
+
+  // A double copy of points that are neither float nor double
+  std::vector<double> Coordinates;
+};
+
+#endif
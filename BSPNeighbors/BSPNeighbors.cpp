@@ -18,116 +18,53 @@
 
 // This algorithm is explained in "Point Primitives for Interactive Modeling and Processing of 3D Geometry"
 
+#include "BSPNeighbors.h"
+#include "BSPNeighborSearcher.h"
+
 #include <vtkIdList.h>
-#include <vtkKdTree.h>
-#include <vtkMath.h>
-#include <vtkPolyData.h>
 #include <vtkPoints.h>
 #include <vtkSmartPointer.h>
-#include <vtkVertexGlyphFilter.h>
-#include <vtkXMLPolyDataWriter.h>
 
-void BSPNeighbors(vtkPoints* inputPoints, unsigned int centerPointId, vtkPoints* bspNeighbors, unsigned int k)
+void BSPNeighbors(vtkPoints* inputPoints, unsigned int centerPointId, vtkPoints* bspNeighbors, unsigned int k,
+                  SmartNeighbors::NeighborSearchStats* stats, BSPNeighborsDebugSink* debugSink)
 {
-  double centerPoint[3];
-  inputPoints->GetPoint(centerPointId, centerPoint);
-  
-  // Create a vtkPoints of all points except the center point
-  vtkSmartPointer<vtkPoints> points = 
-    vtkSmartPointer<vtkPoints>::New();
-  for(vtkIdType i = 0; i < inputPoints->GetNumberOfPoints(); ++i)
-    {
-    if(i == centerPointId)
-      {
-      continue;
-      }
-    double p[3];
-    inputPoints->GetPoint(i, p);
-    points->InsertNextPoint(p);
-    }
-  
-  // Create the tree
-  vtkSmartPointer<vtkKdTree> pointTree = 
-    vtkSmartPointer<vtkKdTree>::New();
-  pointTree->BuildLocatorFromPoints(points);
-  
-  vtkSmartPointer<vtkIdList> result = 
+  vtkSmartPointer<vtkIdList> bspNeighborIds =
     vtkSmartPointer<vtkIdList>::New();
-     
-  // Find the k nearest neighbors
-  pointTree->FindClosestNPoints(k, centerPoint, result);
-  
-  // Create a polydata of the result
-  vtkSmartPointer<vtkPoints> kNearestPoints = 
-    vtkSmartPointer<vtkPoints>::New();
-  
-  for(vtkIdType i = 0; i < k; i++)
+  BSPNeighbors(inputPoints, centerPointId, bspNeighborIds, k, stats, debugSink);
+
+  for(vtkIdType i = 0; i < bspNeighborIds->GetNumberOfIds(); ++i)
     {
-    vtkIdType point_ind = result->GetId(i);
     double p[3];
-    points->GetPoint(point_ind, p);
-    kNearestPoints->InsertNextPoint(p);
+    inputPoints->GetPoint(bspNeighborIds->GetId(i), p);
+    bspNeighbors->InsertNextPoint(p);
     }
+}
 
-  vtkSmartPointer<vtkPolyData> kNearestPolydata = 
-    vtkSmartPointer<vtkPolyData>::New();
-  kNearestPolydata->SetPoints(kNearestPoints);
-
-  // For demonstration only, we output the K nearest neighbors
-  {
-  vtkSmartPointer<vtkVertexGlyphFilter> vertexGlyphFilter =
-    vtkSmartPointer<vtkVertexGlyphFilter>::New();
-  vertexGlyphFilter->SetInputConnection(kNearestPolydata->GetProducerPort());
-  vertexGlyphFilter->Update();
-
-  vtkSmartPointer<vtkXMLPolyDataWriter> writer =
-    vtkSmartPointer<vtkXMLPolyDataWriter>::New();
-  writer->SetFileName("kNearest.vtp");
-  writer->SetInputConnection(vertexGlyphFilter->GetOutputPort());
-  writer->Write();
-  }
-  
-  // Each nearest neighbor point defines a halfspace. The BSP neighbors are a subset of the KNearestNeighbors
-  // which are in the intersection of all of the halfspaces induced by the kNearestNeighbor points.
-  
-  // Each kNeighbor defines a halfspace as:
-  // (x-q_i).(p-q_i) >= 0
-  // x is a test point (the collection of x that fit this criterion is exacly the halfspace)
-  // q_i is the ith nearest neighbor point
-  // p is the center point (for which the kNearest points were found)
-  
-  for(unsigned int neighborId = 0; neighborId < k; ++neighborId) // test each kNeighbor point
-    {
-    bool valid = true;
-
-    double neighborPoint[3];
-    kNearestPoints->GetPoint(neighborId, neighborPoint);
+void BSPNeighbors(vtkPoints* inputPoints, unsigned int centerPointId, vtkIdList* bspNeighborIds, unsigned int k,
+                  SmartNeighbors::NeighborSearchStats* stats, BSPNeighborsDebugSink* debugSink)
+{
+  // This builds the index for a single query. To query many points of the
+  // same cloud, construct a BSPNeighborSearcher once and reuse it.
+  BSPNeighborSearcher searcher(inputPoints, stats);
+  searcher.SetDebugSink(debugSink);
+  searcher.Query(centerPointId, k, bspNeighborIds, stats);
+}
 
-    for(unsigned int halfSpaceId = 0; halfSpaceId < k; ++halfSpaceId) // against each halfspace
-      {
-      double halfSpacePoint[3];
-      kNearestPoints->GetPoint(halfSpaceId, halfSpacePoint);
-      
-      // (x-q_i).(p-q_i) >= 0
-      // A.B >= 0
-      double A[3];
-      vtkMath::Subtract(neighborPoint, halfSpacePoint, A);
-      
-      double B[3];
-      vtkMath::Subtract(centerPoint, halfSpacePoint, B);
-      
-      if(!(vtkMath::Dot(A,B) >= 0))
-	{
-	valid = false;
-	break;
-	}
-      } // end halfspace loop
-    
-    // Keep the point if all of the tests passed
-    if(valid)
-      {
-      bspNeighbors->InsertNextPoint(neighborPoint);
-      }
-    } // end kNeighbors loop
+void ApproximateBSPNeighbors(vtkPoints* inputPoints, unsigned int centerPointId, vtkIdList* bspNeighborIds,
+                             const SmartNeighbors::SearchBudget& budget, unsigned int k,
+                             SmartNeighbors::NeighborSearchStats* stats, BSPNeighborsDebugSink* debugSink)
+{
+  BSPNeighborSearcher searcher(inputPoints, stats);
+  searcher.SetDebugSink(debugSink);
+  searcher.SetSearchBudget(budget);
+  searcher.Query(centerPointId, k, bspNeighborIds, stats);
+}
 
+void BSPNeighborsInRadius(vtkPoints* inputPoints, unsigned int centerPointId, vtkIdList* bspNeighborIds, double radius,
+                          unsigned int maxCandidates, SmartNeighbors::NeighborSearchStats* stats,
+                          BSPNeighborsDebugSink* debugSink)
+{
+  BSPNeighborSearcher searcher(inputPoints, stats);
+  searcher.SetDebugSink(debugSink);
+  searcher.QueryInRadius(centerPointId, radius, maxCandidates, bspNeighborIds, stats);
 }
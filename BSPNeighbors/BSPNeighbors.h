@@ -19,8 +19,37 @@
 #ifndef BSPNEIGHBORS_H
 #define BSPNEIGHBORS_H
 
+#include <vtkIdList.h>
 #include <vtkPoints.h>
 
-void BSPNeighbors(vtkPoints* points, unsigned int centerPointId, vtkPoints* neighbors, unsigned int k = 10);
+// Custom
+#include "BSPNeighborsDebugSink.h"
+#include "NeighborSearchStats.h"
+#include "PointIndex.h"
+
+// Find the BSP neighbors of the point 'centerPointId' among its k nearest neighbors.
+// The first version copies the neighbor coordinates, the second returns the neighbor ids.
+// Timings and counts are recorded into 'stats' and intermediate geometry is
+// passed to 'debugSink' only if they are given.
+void BSPNeighbors(vtkPoints* points, unsigned int centerPointId, vtkPoints* neighbors, unsigned int k = 10,
+                  SmartNeighbors::NeighborSearchStats* stats = 0, BSPNeighborsDebugSink* debugSink = 0);
+void BSPNeighbors(vtkPoints* points, unsigned int centerPointId, vtkIdList* neighborIds, unsigned int k = 10,
+                  SmartNeighbors::NeighborSearchStats* stats = 0, BSPNeighborsDebugSink* debugSink = 0);
+
+// Find the BSP neighbors of the point 'centerPointId' among approximate k nearest
+// neighbors, found within the limits of 'budget'. This bounds the cost of a query for
+// previews that can accept an occasional missed or extra neighbor. BSPNeighborsRecall
+// measures how often that happens on a given cloud, to tune the budget.
+void ApproximateBSPNeighbors(vtkPoints* points, unsigned int centerPointId, vtkIdList* neighborIds,
+                             const SmartNeighbors::SearchBudget& budget, unsigned int k = 10,
+                             SmartNeighbors::NeighborSearchStats* stats = 0, BSPNeighborsDebugSink* debugSink = 0);
+
+// Find the BSP neighbors of the point 'centerPointId' among the points within 'radius'
+// of it instead of among a fixed number of nearest points. If 'maxCandidates' is not
+// 0, at most that many candidates are considered and the search for them stops as
+// soon as they are found.
+void BSPNeighborsInRadius(vtkPoints* points, unsigned int centerPointId, vtkIdList* neighborIds, double radius,
+                          unsigned int maxCandidates = 0, SmartNeighbors::NeighborSearchStats* stats = 0,
+                          BSPNeighborsDebugSink* debugSink = 0);
 
 #endif
@@ -0,0 +1,59 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "BSPNeighborsDebugSink.h"
+
+// VTK
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkVertexGlyphFilter.h>
+#include <vtkXMLPolyDataWriter.h>
+
+BSPNeighborsFileDebugSink::BSPNeighborsFileDebugSink(const std::string& kNearestFileName)
+  : KNearestFileName(kNearestFileName)
+{
+}
+
+void BSPNeighborsFileDebugSink::KNearestNeighbors(vtkPoints* points, vtkIdType, vtkIdList* kNearestIds)
+{
+  // Create a polydata of the result
+  vtkSmartPointer<vtkPoints> kNearestPoints = 
+    vtkSmartPointer<vtkPoints>::New();
+  
+  for(vtkIdType i = 0; i < kNearestIds->GetNumberOfIds(); i++)
+    {
+    double p[3];
+    points->GetPoint(kNearestIds->GetId(i), p);
+    kNearestPoints->InsertNextPoint(p);
+    }
+
+  vtkSmartPointer<vtkPolyData> kNearestPolydata = 
+    vtkSmartPointer<vtkPolyData>::New();
+  kNearestPolydata->SetPoints(kNearestPoints);
+
+  vtkSmartPointer<vtkVertexGlyphFilter> vertexGlyphFilter =
+    vtkSmartPointer<vtkVertexGlyphFilter>::New();
+  vertexGlyphFilter->SetInputConnection(kNearestPolydata->GetProducerPort());
+  vertexGlyphFilter->Update();
+
+  vtkSmartPointer<vtkXMLPolyDataWriter> writer =
+    vtkSmartPointer<vtkXMLPolyDataWriter>::New();
+  writer->SetFileName(this->KNearestFileName.c_str());
+  writer->SetInputConnection(vertexGlyphFilter->GetOutputPort());
+  writer->Write();
+}
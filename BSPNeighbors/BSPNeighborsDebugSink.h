@@ -0,0 +1,54 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef BSPNEIGHBORSDEBUGSINK_H
+#define BSPNEIGHBORSDEBUGSINK_H
+
+// STL
+#include <string>
+
+// VTK
+#include <vtkIdList.h>
+#include <vtkPoints.h>
+
+// Receives the intermediate geometry of BSP neighbor searches. Nothing is
+// produced unless a sink is given to the search. When the search runs on
+// several threads the sink is called from all of them, so it must be thread safe.
+class BSPNeighborsDebugSink
+{
+public:
+  virtual ~BSPNeighborsDebugSink() {}
+
+  // Called with the k nearest neighbors found for 'centerPointId'
+  virtual void KNearestNeighbors(vtkPoints* points, vtkIdType centerPointId, vtkIdList* kNearestIds) = 0;
+};
+
+// Writes the k nearest neighbors of every query to a .vtp file, as the
+// demos do. Each query overwrites the file. Not thread safe.
+class BSPNeighborsFileDebugSink : public BSPNeighborsDebugSink
+{
+public:
+  BSPNeighborsFileDebugSink(const std::string& kNearestFileName = "kNearest.vtp");
+
+  void KNearestNeighbors(vtkPoints* points, vtkIdType centerPointId, vtkIdList* kNearestIds);
+
+private:
+  std::string KNearestFileName;
+};
+
+#endif
@@ -0,0 +1,98 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "BSPTileNeighborQuery.h"
+#include "BSPNeighborSearcher.h"
+
+// STL
+#include <algorithm>
+#include <cmath>
+
+// VTK
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkMath.h>
+
+BSPTileNeighborQuery::BSPTileNeighborQuery(unsigned int k)
+  : K(k), Searcher(0)
+{
+}
+
+BSPTileNeighborQuery::~BSPTileNeighborQuery()
+{
+  delete this->Searcher;
+}
+
+unsigned int BSPTileNeighborQuery::GetDimension() const
+{
+  return 3;
+}
+
+std::size_t BSPTileNeighborQuery::GetBytesPerPoint() const
+{
+  // The kd-tree keeps a point id and a copy of the coordinates per point, plus its regions
+  return 64;
+}
+
+void BSPTileNeighborQuery::SetTilePoints(const std::vector<double>& xyz, const double*)
+{
+  delete this->Searcher;
+  this->Searcher = 0;
+
+  // The array only borrows the coordinates, it does not free them
+  vtkSmartPointer<vtkDoubleArray> coordinates =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  coordinates->SetNumberOfComponents(3);
+  if(!xyz.empty())
+    {
+    coordinates->SetArray(const_cast<double*>(&xyz[0]), static_cast<vtkIdType>(xyz.size()), 1);
+    }
+
+  this->Points = vtkSmartPointer<vtkPoints>::New();
+  this->Points->SetData(coordinates);
+  this->Searcher = new BSPNeighborSearcher(this->Points);
+}
+
+double BSPTileNeighborQuery::Query(std::size_t pointIndex, std::vector<std::size_t>& neighborIndices) const
+{
+  vtkSmartPointer<vtkIdList> kNearest =
+    vtkSmartPointer<vtkIdList>::New();
+  this->Searcher->FindKNearestNeighbors(static_cast<vtkIdType>(pointIndex), this->K, kNearest);
+
+  std::vector<vtkIdType> bspNeighborIds(kNearest->GetNumberOfIds());
+  vtkIdType numberOfNeighbors = bspNeighborIds.empty() ? 0 :
+    this->Searcher->FilterHalfSpaces(static_cast<vtkIdType>(pointIndex), kNearest, &bspNeighborIds[0]);
+  neighborIndices.assign(bspNeighborIds.begin(), bspNeighborIds.begin() + numberOfNeighbors);
+
+  // With fewer than k points in the tile, the true k nearest may be anywhere
+  if(kNearest->GetNumberOfIds() < static_cast<vtkIdType>(this->K))
+    {
+    return HUGE_VAL;
+    }
+
+  double center[3];
+  this->Points->GetPoint(static_cast<vtkIdType>(pointIndex), center);
+  double radius2 = 0.0;
+  for(vtkIdType i = 0; i < kNearest->GetNumberOfIds(); ++i)
+    {
+    double p[3];
+    this->Points->GetPoint(kNearest->GetId(i), p);
+    radius2 = std::max(radius2, vtkMath::Distance2BetweenPoints(center, p));
+    }
+  return std::sqrt(radius2);
+}
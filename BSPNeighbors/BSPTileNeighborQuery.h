@@ -0,0 +1,62 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef BSPTILENEIGHBORQUERY_H
+#define BSPTILENEIGHBORQUERY_H
+
+// STL
+#include <vector>
+
+// VTK
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+
+// Custom
+#include "TiledNeighborSearch.h"
+
+class BSPNeighborSearcher;
+
+// The BSP neighbor search run on each tile by TiledNeighborSearch. The result of a
+// point depends on its k nearest neighbors, so it is exact when the ball through the
+// kth nearest one lies inside the loaded region. The halo width should be at least
+// the largest kth nearest neighbor distance in the cloud.
+class BSPTileNeighborQuery : public SmartNeighbors::TileNeighborQuery
+{
+public:
+  BSPTileNeighborQuery(unsigned int k = 10);
+  ~BSPTileNeighborQuery();
+
+  unsigned int GetDimension() const;
+  std::size_t GetBytesPerPoint() const;
+
+  // The coordinates are wrapped rather than copied, so 'xyz' must outlive the queries
+  void SetTilePoints(const std::vector<double>& xyz, const double bounds[6]);
+
+  double Query(std::size_t pointIndex, std::vector<std::size_t>& neighborIndices) const;
+
+private:
+  // Not copyable, the searcher is deleted by the destructor
+  BSPTileNeighborQuery(const BSPTileNeighborQuery&);
+  void operator=(const BSPTileNeighborQuery&);
+
+  unsigned int K;
+  vtkSmartPointer<vtkPoints> Points;
+  BSPNeighborSearcher* Searcher;
+};
+
+#endif
@@ -0,0 +1,314 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Compute the BSP neighbors of every point of many clouds, such as the tiles of a
+// survey, one after another. The inputs are given either as a list file with one
+// "input [output]" per line or as a quoted pattern like "tiles/*.pts". Without an
+// explicit output, the neighbors of tile.pts are written next to it as
+// tile.neighbors.bin, in the format read by SmartNeighbors::NeighborRecordReader.
+//
+// The work is pipelined: while the neighbors of one tile are computed on all
+// cores, the next tile is read and the previous one written on another thread,
+// so the file I/O is hidden behind the computation.
+
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <glob.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// VTK
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+#include <vtkXMLPolyDataReader.h>
+
+// Custom
+#include "BSPNeighborGraph.h"
+#include "PointFileVTK.h"
+#include "TiledNeighborSearch.h"
+
+namespace
+{
+// One cloud passing through the pipeline
+struct Tile
+{
+  Tile() : PointFile(0) {}
+
+  std::string InputFileName;
+  std::string OutputFileName;
+  SmartNeighbors::MappedPointFile* PointFile;
+  vtkSmartPointer<vtkPoints> Points;
+  BSPNeighborGraph Graph;
+};
+
+// tiles/a.pts becomes tiles/a.neighbors.bin
+std::string GetDefaultOutputFileName(const std::string& inputFileName)
+{
+  std::string::size_type dot = inputFileName.find_last_of('.');
+  std::string::size_type slash = inputFileName.find_last_of("/\\");
+  if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+    dot = inputFileName.size();
+    }
+  return inputFileName.substr(0, dot) + ".neighbors.bin";
+}
+
+// The files matching 'pattern', sorted by name
+void ExpandPattern(const std::string& pattern, std::vector<std::string>& fileNames)
+{
+#ifdef _WIN32
+  // FindFirstFile only returns the file names, so the directory is put back
+  std::string::size_type slash = pattern.find_last_of("/\\");
+  std::string directory = slash == std::string::npos ? std::string() : pattern.substr(0, slash + 1);
+  std::vector<std::string> matches;
+  WIN32_FIND_DATAA data;
+  HANDLE search = FindFirstFileA(pattern.c_str(), &data);
+  if(search != INVALID_HANDLE_VALUE)
+    {
+    do
+      {
+      if(!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        {
+        matches.push_back(directory + data.cFileName);
+        }
+      } while(FindNextFileA(search, &data));
+    FindClose(search);
+    }
+  std::sort(matches.begin(), matches.end());
+  fileNames.insert(fileNames.end(), matches.begin(), matches.end());
+#else
+  glob_t matches;
+  if(glob(pattern.c_str(), 0, 0, &matches) == 0)
+    {
+    fileNames.insert(fileNames.end(), matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+    }
+  globfree(&matches);
+#endif
+}
+
+// Read the input and output file names from 'argument', a pattern or a list file
+void GetTiles(const std::string& argument, std::vector<Tile>& tiles)
+{
+  if(argument.find_first_of("*?") != std::string::npos)
+    {
+    std::vector<std::string> fileNames;
+    ExpandPattern(argument, fileNames);
+    tiles.resize(fileNames.size());
+    for(std::size_t i = 0; i < fileNames.size(); ++i)
+      {
+      tiles[i].InputFileName = fileNames[i];
+      tiles[i].OutputFileName = GetDefaultOutputFileName(fileNames[i]);
+      }
+    return;
+    }
+
+  std::ifstream list(argument.c_str());
+  if(!list)
+    {
+    std::cerr << "Could not open " << argument << "!" << std::endl;
+    exit(-1);
+    }
+  std::string line;
+  while(std::getline(list, line))
+    {
+    Tile tile;
+    std::stringstream fields(line);
+    fields >> tile.InputFileName >> tile.OutputFileName;
+    // Skip blank lines and comments
+    if(tile.InputFileName.empty() || tile.InputFileName[0] == '#')
+      {
+      continue;
+      }
+    if(tile.OutputFileName.empty())
+      {
+      tile.OutputFileName = GetDefaultOutputFileName(tile.InputFileName);
+      }
+    tiles.push_back(tile);
+    }
+}
+
+// Point files are mapped and used in place, anything else is parsed as XML. The
+// pages of a mapped file are touched here, so they are read now rather than when
+// the neighbor search first needs them. A file that cannot be read leaves the
+// points null, it is reported and skipped when the tile is written.
+void ReadTile(Tile& tile)
+{
+  if(SmartNeighbors::IsPointFile(tile.InputFileName))
+    {
+    tile.PointFile = new SmartNeighbors::MappedPointFile(tile.InputFileName, false);
+    if(!tile.PointFile->IsValid())
+      {
+      std::cerr << tile.PointFile->GetErrorMessage() << std::endl;
+      delete tile.PointFile;
+      tile.PointFile = 0;
+      return;
+      }
+    tile.Points = SmartNeighbors::WrapPointFile(tile.PointFile);
+
+    const char* begin = tile.PointFile->GetDoublePoints() ?
+      reinterpret_cast<const char*>(tile.PointFile->GetDoublePoints()) :
+      reinterpret_cast<const char*>(tile.PointFile->GetFloatPoints());
+    const std::size_t size = static_cast<std::size_t>(3 * tile.PointFile->GetScalarSize() *
+                                                      tile.PointFile->GetNumberOfPoints());
+    volatile char sink = 0;
+    for(std::size_t offset = 0; offset < size; offset += 4096)
+      {
+      sink = sink + begin[offset];
+      }
+    }
+  else
+    {
+    vtkSmartPointer<vtkXMLPolyDataReader> reader =
+      vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    reader->SetFileName( tile.InputFileName.c_str() );
+    reader->Update();
+    tile.Points = reader->GetOutput()->GetPoints();
+    }
+}
+
+// Write the neighbors and release everything the tile holds. Returns false if the
+// tile could not be read or its neighbors could not be written.
+bool WriteTile(Tile& tile)
+{
+  bool written = false;
+  if(tile.Points)
+    {
+    SmartNeighbors::NeighborRecordWriter writer(tile.OutputFileName, false);
+    std::vector<unsigned long long> neighborIds;
+    written = true;
+    for(std::size_t pointId = 0; written && pointId < tile.Graph.GetNumberOfPoints(); ++pointId)
+      {
+      neighborIds.assign(tile.Graph.NeighborsBegin(pointId), tile.Graph.NeighborsEnd(pointId));
+      written = writer.Write(pointId, neighborIds, true);
+      }
+    written = written && writer.Close();
+    if(written)
+      {
+      std::cout << tile.InputFileName << " -> " << tile.OutputFileName << ": " << tile.Graph.GetNumberOfPoints()
+                << " points, " << tile.Graph.GetNumberOfEdges() << " neighbors" << std::endl;
+      }
+    }
+  else
+    {
+    std::cerr << "Could not read any points from " << tile.InputFileName << "!" << std::endl;
+    }
+
+  // The points are wrapped around the mapping, so it is released last
+  tile.Points = 0;
+  delete tile.PointFile;
+  tile.PointFile = 0;
+  BSPNeighborGraph().Offsets.swap(tile.Graph.Offsets);
+  BSPNeighborGraph().NeighborIds.swap(tile.Graph.NeighborIds);
+  return written;
+}
+}
+
+int main(int argc, char *argv[])
+{
+  // Verify arguments
+  if(argc < 3)
+    {
+    std::cerr << "Required arguments: inputList.txt|\"pattern\" k [numberOfThreads]" << std::endl
+              << "Each line of the list is an input .vtp or .pts file, optionally followed by its output file."
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Parse arguments
+  unsigned int k;
+  int numberOfThreads = 0;
+  if(!(std::stringstream(argv[2]) >> k) || (argc > 3 && !(std::stringstream(argv[3]) >> numberOfThreads)))
+    {
+    std::cerr << "Invalid arguments!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::vector<Tile> tiles;
+  GetTiles(argv[1], tiles);
+  if(tiles.empty())
+    {
+    std::cerr << "No input files match " << argv[1] << "!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+#ifdef _OPENMP
+  // The neighbor search runs its own threads inside the compute stage
+  omp_set_nested(1);
+#endif
+
+  double startTime = vtkTimerLog::GetUniversalTime();
+
+  // At step i tile i is read, tile i - 1 computed and tile i - 2 written
+  const std::size_t numberOfTiles = tiles.size();
+  std::size_t numberOfFailures = 0;
+  for(std::size_t step = 0; step < numberOfTiles + 2; ++step)
+    {
+#ifdef _OPENMP
+#pragma omp parallel sections num_threads(2)
+#endif
+    {
+#ifdef _OPENMP
+#pragma omp section
+#endif
+    {
+    if(step >= 2)
+      {
+      numberOfFailures += WriteTile(tiles[step - 2]) ? 0 : 1;
+      }
+    if(step < numberOfTiles)
+      {
+      ReadTile(tiles[step]);
+      }
+    }
+#ifdef _OPENMP
+#pragma omp section
+#endif
+    {
+    if(step >= 1 && step <= numberOfTiles)
+      {
+      Tile& tile = tiles[step - 1];
+      if(tile.Points)
+        {
+        AllBSPNeighbors(tile.Points, &tile.Graph, k, numberOfThreads);
+        }
+      }
+    }
+    }
+    }
+
+  std::cout << numberOfTiles - numberOfFailures << " of " << numberOfTiles << " files in "
+            << vtkTimerLog::GetUniversalTime() - startTime << " s" << std::endl;
+
+  return numberOfFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,91 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Converts the points of a .vtp file to the binary point file format of PointFile.h,
+// which BSPNeighborsExample and BSPNeighborsTiled can map instead of parsing XML.
+
+// STL
+#include <iostream>
+#include <string>
+#include <vector>
+
+// VTK
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkXMLPolyDataReader.h>
+
+// Custom
+#include "PointFile.h"
+
+int main(int argc, char *argv[])
+{
+  // Verify arguments
+  if(argc < 3)
+    {
+    std::cerr << "Required arguments: input.vtp output.pts [float|double]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Parse arguments
+  std::string inputFileName = argv[1];
+  std::string outputFileName = argv[2];
+
+  vtkSmartPointer<vtkXMLPolyDataReader> reader =
+    vtkSmartPointer<vtkXMLPolyDataReader>::New();
+  reader->SetFileName( inputFileName.c_str() );
+  reader->Update();
+
+  vtkPoints* points = reader->GetOutput()->GetPoints();
+  vtkIdType numberOfPoints = points ? points->GetNumberOfPoints() : 0;
+
+  // Keep the precision of the input unless told otherwise
+  bool writeDouble = points && points->GetDataType() == VTK_DOUBLE;
+  if(argc > 3)
+    {
+    writeDouble = std::string(argv[3]) == "double";
+    }
+
+  if(writeDouble)
+    {
+    std::vector<double> xyz(3 * numberOfPoints);
+    for(vtkIdType i = 0; i < numberOfPoints; ++i)
+      {
+      points->GetPoint(i, &xyz[3*i]);
+      }
+    SmartNeighbors::WritePointFile(outputFileName, xyz.empty() ? 0 : &xyz[0], numberOfPoints);
+    }
+  else
+    {
+    std::vector<float> xyz(3 * numberOfPoints);
+    for(vtkIdType i = 0; i < numberOfPoints; ++i)
+      {
+      double p[3];
+      points->GetPoint(i, p);
+      xyz[3*i] = static_cast<float>(p[0]);
+      xyz[3*i + 1] = static_cast<float>(p[1]);
+      xyz[3*i + 2] = static_cast<float>(p[2]);
+      }
+    SmartNeighbors::WritePointFile(outputFileName, xyz.empty() ? 0 : &xyz[0], numberOfPoints);
+    }
+
+  std::cout << "Wrote " << numberOfPoints << (writeDouble ? " float64" : " float32")
+            << " points to " << outputFileName << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -87,7 +87,9 @@ int main(int argc, char *argv[])
   vtkSmartPointer<vtkPoints> bspNeighborPoints = 
     vtkSmartPointer<vtkPoints>::New();
     
-  BSPNeighbors(points2D, queryPointId, bspNeighborPoints);
+  // Also write the k nearest neighbors to kNearest.vtp
+  BSPNeighborsFileDebugSink debugSink;
+  BSPNeighbors(points2D, queryPointId, bspNeighborPoints, 10, 0, &debugSink);
     
   vtkSmartPointer<vtkPolyData> bspNeighborPolydata = 
     vtkSmartPointer<vtkPolyData>::New();
@@ -79,7 +79,9 @@ int main(int argc, char *argv[])
   vtkSmartPointer<vtkPoints> bspNeighborPoints = 
     vtkSmartPointer<vtkPoints>::New();
     
-  BSPNeighbors(pointSource->GetOutput()->GetPoints(), queryPointId, bspNeighborPoints);
+  // Also write the k nearest neighbors to kNearest.vtp
+  BSPNeighborsFileDebugSink debugSink;
+  BSPNeighbors(pointSource->GetOutput()->GetPoints(), queryPointId, bspNeighborPoints, 10, 0, &debugSink);
     
   vtkSmartPointer<vtkPolyData> bspNeighborPolydata = 
     vtkSmartPointer<vtkPolyData>::New();
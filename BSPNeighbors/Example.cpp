@@ -25,13 +25,14 @@
 
 // Custom
 #include "BSPNeighbors.h"
+#include "PointFileVTK.h"
 
 int main(int argc, char *argv[])
 {
   // Verify arguments
   if(argc < 3)
     {
-    std::cerr << "Required arguments: input.vtp output.vtp" << std::endl;
+    std::cerr << "Required arguments: input.vtp|input.pts output.vtp" << std::endl;
     return EXIT_FAILURE;
     }
 
@@ -39,10 +40,22 @@ int main(int argc, char *argv[])
   std::string inputFileName = argv[1];
   std::string outputFileName = argv[2];
 
-  vtkSmartPointer<vtkXMLPolyDataReader> reader =
-    vtkSmartPointer<vtkXMLPolyDataReader>::New();
-  reader->SetFileName( inputFileName.c_str() );
-  reader->Update();
+  // Point files are mapped and used in place, anything else is parsed as XML
+  SmartNeighbors::MappedPointFile* pointFile = 0;
+  vtkSmartPointer<vtkPoints> points;
+  if(SmartNeighbors::IsPointFile(inputFileName))
+    {
+    pointFile = new SmartNeighbors::MappedPointFile(inputFileName);
+    points = SmartNeighbors::WrapPointFile(pointFile);
+    }
+  else
+    {
+    vtkSmartPointer<vtkXMLPolyDataReader> reader =
+      vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    reader->SetFileName( inputFileName.c_str() );
+    reader->Update();
+    points = reader->GetOutput()->GetPoints();
+    }
     
   // Find the nearest neighbors of the 9th point
   unsigned int centerPointId = 9;
@@ -50,7 +63,7 @@ int main(int argc, char *argv[])
   vtkSmartPointer<vtkPoints> bspNeighborPoints = 
     vtkSmartPointer<vtkPoints>::New();
     
-  BSPNeighbors(reader->GetOutput()->GetPoints(), centerPointId, bspNeighborPoints);
+  BSPNeighbors(points, centerPointId, bspNeighborPoints);
     
   vtkSmartPointer<vtkPolyData> bspNeighborPolydata = 
     vtkSmartPointer<vtkPolyData>::New();
@@ -64,10 +77,14 @@ int main(int argc, char *argv[])
 
   vtkSmartPointer<vtkXMLPolyDataWriter> writer =
     vtkSmartPointer<vtkXMLPolyDataWriter>::New();
-  writer->SetFileName("bspNeighbors.vtp");
+  writer->SetFileName(outputFileName.c_str());
   writer->SetInputConnection(vertexGlyphFilter->GetOutputPort());
   writer->Write();
   }
+
+  // The input points are wrapped around the mapping, so it is released last
+  points = 0;
+  delete pointFile;
   
   return EXIT_SUCCESS;
 }
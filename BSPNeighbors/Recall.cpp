@@ -0,0 +1,190 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Measure how closely approximate BSP neighbors, found with a limited search budget,
+// match the exact ones on a given cloud, to choose a budget for previews. For every
+// combination of the given epsilons and distance evaluation limits it prints the
+// fraction of exact neighbors found (recall), the fraction of found neighbors that
+// are exact (precision), the fraction of neighborhoods that are identical and the
+// time per query.
+
+// STL
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// VTK
+#include <vtkIdList.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+#include <vtkXMLPolyDataReader.h>
+
+// Custom
+#include "BSPNeighborGraph.h"
+#include "BSPNeighborSearcher.h"
+#include "PointFileVTK.h"
+
+namespace
+{
+template <typename T>
+bool ParseList(const std::string& text, std::vector<T>& values)
+{
+  values.clear();
+  std::stringstream stream(text);
+  std::string item;
+  while(std::getline(stream, item, ','))
+    {
+    T value;
+    if(!(std::stringstream(item) >> value))
+      {
+      return false;
+      }
+    values.push_back(value);
+    }
+  return !values.empty();
+}
+
+// The time per query in microseconds of BSP neighbor queries about 'queryIds'
+double ComputeNeighbors(BSPNeighborSearcher* searcher, vtkIdList* queryIds, unsigned int k, BSPNeighborGraph* graph)
+{
+  // One thread, so the times are latencies rather than throughput
+  double startTime = vtkTimerLog::GetUniversalTime();
+  BSPNeighborsBatch(searcher, queryIds, graph, k, 1);
+  return 1e6 * (vtkTimerLog::GetUniversalTime() - startTime) / std::max<vtkIdType>(1, queryIds->GetNumberOfIds());
+}
+}
+
+int main(int argc, char *argv[])
+{
+  // Verify arguments
+  if(argc < 5)
+    {
+    std::cerr << "Required arguments: input.vtp|input.pts k epsilon[,epsilon...] maxEvaluations[,maxEvaluations...] "
+              << "[numberOfQueries]" << std::endl
+              << "A maxEvaluations of 0 means no limit." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Parse arguments
+  std::string inputFileName = argv[1];
+
+  unsigned int k;
+  std::vector<double> epsilons;
+  std::vector<std::size_t> maxEvaluations;
+  std::size_t numberOfQueries = 10000;
+  if(!(std::stringstream(argv[2]) >> k) || !ParseList(argv[3], epsilons) || !ParseList(argv[4], maxEvaluations) ||
+     (argc > 5 && !(std::stringstream(argv[5]) >> numberOfQueries)))
+    {
+    std::cerr << "Invalid arguments!" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Point files are mapped and used in place, anything else is parsed as XML
+  SmartNeighbors::MappedPointFile* pointFile = 0;
+  vtkSmartPointer<vtkPoints> points;
+  if(SmartNeighbors::IsPointFile(inputFileName))
+    {
+    pointFile = new SmartNeighbors::MappedPointFile(inputFileName);
+    points = SmartNeighbors::WrapPointFile(pointFile);
+    }
+  else
+    {
+    vtkSmartPointer<vtkXMLPolyDataReader> reader =
+      vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    reader->SetFileName( inputFileName.c_str() );
+    reader->Update();
+    points = reader->GetOutput()->GetPoints();
+    }
+
+  // Query points spread evenly over the cloud, or all of them
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  vtkIdType numberOfQueryIds = std::min<vtkIdType>(numberOfPoints, static_cast<vtkIdType>(numberOfQueries));
+  vtkSmartPointer<vtkIdList> queryIds =
+    vtkSmartPointer<vtkIdList>::New();
+  queryIds->SetNumberOfIds(numberOfQueryIds);
+  for(vtkIdType i = 0; i < numberOfQueryIds; ++i)
+    {
+    queryIds->SetId(i, static_cast<vtkIdType>(static_cast<double>(i) * numberOfPoints / numberOfQueryIds));
+    }
+
+  // The exact neighbors are the same as BSPNeighbors() finds for each point
+  {
+  BSPNeighborSearcher searcher(points);
+  BSPNeighborGraph exact;
+  double exactTime = ComputeNeighbors(&searcher, queryIds, k, &exact);
+
+  std::cout << "epsilon,max_evaluations,recall,precision,identical,us_per_query,speedup" << std::endl;
+  std::cout << "0,0,1,1,1," << exactTime << ",1" << std::endl;
+  for(std::size_t e = 0; e < epsilons.size(); ++e)
+    {
+    for(std::size_t m = 0; m < maxEvaluations.size(); ++m)
+      {
+      SmartNeighbors::SearchBudget budget(epsilons[e], maxEvaluations[m]);
+      if(budget.IsExact())
+        {
+        continue;
+        }
+      searcher.SetSearchBudget(budget);
+      BSPNeighborGraph approximate;
+      double time = ComputeNeighbors(&searcher, queryIds, k, &approximate);
+
+      std::size_t numberOfExact = 0;
+      std::size_t numberOfFound = 0;
+      std::size_t numberOfCommon = 0;
+      std::size_t numberOfIdentical = 0;
+      std::vector<vtkIdType> exactIds;
+      std::vector<vtkIdType> foundIds;
+      std::vector<vtkIdType> commonIds;
+      for(vtkIdType i = 0; i < numberOfQueryIds; ++i)
+        {
+        exactIds.assign(exact.NeighborsBegin(i), exact.NeighborsEnd(i));
+        foundIds.assign(approximate.NeighborsBegin(i), approximate.NeighborsEnd(i));
+        std::sort(exactIds.begin(), exactIds.end());
+        std::sort(foundIds.begin(), foundIds.end());
+        commonIds.clear();
+        std::set_intersection(exactIds.begin(), exactIds.end(), foundIds.begin(), foundIds.end(),
+                              std::back_inserter(commonIds));
+
+        numberOfExact += exactIds.size();
+        numberOfFound += foundIds.size();
+        numberOfCommon += commonIds.size();
+        if(exactIds == foundIds)
+          {
+          numberOfIdentical++;
+          }
+        }
+
+      std::cout << epsilons[e] << "," << maxEvaluations[m] << ","
+                << static_cast<double>(numberOfCommon) / std::max<std::size_t>(1, numberOfExact) << ","
+                << static_cast<double>(numberOfCommon) / std::max<std::size_t>(1, numberOfFound) << ","
+                << static_cast<double>(numberOfIdentical) / std::max<vtkIdType>(1, numberOfQueryIds) << ","
+                << time << "," << exactTime / time << std::endl;
+      }
+    }
+  }
+
+  // The input points are wrapped around the mapping, so it is released last
+  points = 0;
+  delete pointFile;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// STL
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Custom
+#include "BSPTileNeighborQuery.h"
+#include "PointFile.h"
+#include "TiledNeighborSearch.h"
+
+int main(int argc, char *argv[])
+{
+  // Verify arguments
+  if(argc < 5)
+    {
+    std::cerr << "Required arguments: input.pts|input.raw output.bin k haloWidth [memoryBudgetMB]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Parse arguments
+  std::string inputFileName = argv[1];
+  std::string outputFileName = argv[2];
+
+  unsigned int k;
+  double haloWidth;
+  std::stringstream(argv[3]) >> k;
+  std::stringstream(argv[4]) >> haloWidth;
+
+  std::size_t memoryBudgetMB = 1024;
+  if(argc > 5)
+    {
+    std::stringstream(argv[5]) >> memoryBudgetMB;
+    }
+
+  // Point files are mapped, anything else is read as raw doubles
+  SmartNeighbors::MappedPointFile* pointFile = 0;
+  SmartNeighbors::PointReader* reader;
+  if(SmartNeighbors::IsPointFile(inputFileName))
+    {
+    pointFile = new SmartNeighbors::MappedPointFile(inputFileName);
+    reader = new SmartNeighbors::MappedPointFileReader(pointFile);
+    }
+  else
+    {
+    reader = new SmartNeighbors::RawPointFileReader(inputFileName);
+    }
+  BSPTileNeighborQuery query(k);
+
+  SmartNeighbors::TiledNeighborSearch search;
+  search.SetMemoryBudget(memoryBudgetMB << 20);
+  search.SetHaloWidth(haloWidth);
+  search.Run(reader, &query, outputFileName);
+  delete reader;
+  delete pointFile;
+
+  std::cout << search.GetNumberOfPoints() << " points in " << search.GetNumberOfTiles() << " tiles, "
+            << "at most " << search.GetLargestTileSize() << " loaded at once" << std::endl;
+  if(search.GetNumberOfInexactPoints() > 0)
+    {
+    std::cout << search.GetNumberOfInexactPoints()
+              << " points may have wrong neighbors, consider a wider halo" << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,516 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef BSPNEIGHBORSEARCH_H
+#define BSPNEIGHBORSEARCH_H
+
+// This algorithm is explained in "Point Primitives for Interactive Modeling and Processing of 3D Geometry"
+
+// STL
+#include <cstddef>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Custom
+#include "BuildNeighborGraph.h"
+#include "CreatePointIndex.h"
+#include "HalfSpaceFilter.h"
+#include "NeighborhoodReducers.h"
+#include "ReorderedPointIndex.h"
+#include "SpaceFillingCurve.h"
+
+namespace SmartNeighbors
+{
+
+// BSP neighbor queries on points in a plain array, in 2 or 3 dimensions, with float
+// or double coordinates. This is the VTK free core behind BSPNeighborSearcher and
+// BSPNeighbors(). The index that finds the candidates is built once by the
+// constructor, a kd-tree or a uniform grid chosen from the points unless a type is
+// given, see CreatePointIndex.h and PointIndex.h for how the points are laid out.
+// With 'reorderPoints' the index keeps its own copy of the points in Morton order,
+// see ReorderedPointIndex.h, and the queries work on that copy so the neighbors of a
+// point are read from nearby memory. The neighbors found are the same either way.
+// Queries only read the search, so they may run concurrently as long as each thread
+// passes its own output vectors.
+template <typename TScalar, unsigned int Dimension>
+class BSPNeighborSearch
+{
+public:
+  typedef PointIndex<TScalar, Dimension> IndexType;
+  typedef typename IndexType::NeighborType NeighborType;
+  typedef ReorderedPointIndex<TScalar, Dimension> ReorderedIndexType;
+
+  BSPNeighborSearch(const TScalar* points, std::size_t numberOfPoints, unsigned int stride = Dimension,
+                    PointIndexType indexType = AutomaticIndex, bool reorderPoints = false)
+    : Index(reorderPoints ? new ReorderedIndexType(points, numberOfPoints, stride, indexType)
+                          : CreatePointIndex<TScalar, Dimension>(points, numberOfPoints, stride, indexType)),
+      OwnsIndex(true), Reordered(dynamic_cast<const ReorderedIndexType*>(this->Index))
+  {
+  }
+
+  // Search an index that the caller owns and may change between queries, such as a
+  // DynamicPointIndex
+  explicit BSPNeighborSearch(const IndexType* index)
+    : Index(index), OwnsIndex(false), Reordered(dynamic_cast<const ReorderedIndexType*>(index))
+  {
+  }
+
+  ~BSPNeighborSearch()
+  {
+    if(this->OwnsIndex)
+      {
+      delete this->Index;
+      }
+  }
+
+  const IndexType& GetIndex() const
+  {
+    return *this->Index;
+  }
+
+  // The index if it reorders the points, for its permutation, and 0 otherwise
+  const ReorderedIndexType* GetReorderedIndex() const
+  {
+    return this->Reordered;
+  }
+
+  // Find the k nearest neighbors of the point 'centerPointId', nearest first, not
+  // including the point itself
+  void FindKNearestNeighbors(std::size_t centerPointId, unsigned int k, std::vector<NeighborType>& kNearest) const
+  {
+    this->Index->FindKNearest(this->Index->GetPoint(centerPointId), k, kNearest, centerPointId);
+  }
+
+  // Find the k points nearest to the location 'queryPoint', nearest first
+  void FindKNearestToPoint(const TScalar* queryPoint, unsigned int k, std::vector<NeighborType>& kNearest) const
+  {
+    this->Index->FindKNearest(queryPoint, k, kNearest);
+  }
+
+  // Find the points within 'radius' of the point 'centerPointId', nearest first, not
+  // including the point itself. With a nonzero 'maxCandidates' the search stops once
+  // it has found that many, see PointIndex::FindInRadius().
+  void FindNeighborsInRadius(std::size_t centerPointId, TScalar radius, std::size_t maxCandidates,
+                             std::vector<NeighborType>& candidates) const
+  {
+    this->Index->FindInRadius(this->Index->GetPoint(centerPointId), radius, maxCandidates, candidates, centerPointId);
+  }
+
+  // Keep the candidates that lie in the halfspaces of all of the candidates. The ids
+  // of the kept ones are written to 'bspNeighborIds', which needs room for every
+  // candidate and may be 'candidateIds' itself, and their number is returned.
+  template <typename TId>
+  std::size_t FilterHalfSpaces(std::size_t centerPointId, const TId* candidateIds, std::size_t numberOfCandidates,
+                               TId* bspNeighborIds) const
+  {
+    return this->FilterHalfSpacesAt(this->Index->GetPoint(centerPointId), candidateIds, numberOfCandidates,
+                                    bspNeighborIds);
+  }
+
+  // The same around the location 'center', which need not be one of the points
+  template <typename TId>
+  std::size_t FilterHalfSpacesAt(const TScalar* center, const TId* candidateIds, std::size_t numberOfCandidates,
+                                 TId* bspNeighborIds) const
+  {
+    return this->FilterHalfSpacesAt(center, candidateIds, numberOfCandidates, bspNeighborIds, false);
+  }
+
+  // Find the BSP neighbors of the point 'centerPointId' among its k nearest neighbors.
+  // 'kNearest' is scratch space, pass the same vector to repeated queries to reuse it.
+  void Query(std::size_t centerPointId, unsigned int k, std::vector<std::size_t>& bspNeighborIds,
+             std::vector<NeighborType>& kNearest) const
+  {
+    if(this->Reordered)
+      {
+      const std::size_t position = this->Reordered->GetPosition(centerPointId);
+      const TScalar* center = this->Reordered->GetReorderedPoint(position);
+      this->Reordered->FindKNearestReordered(center, k, kNearest, position);
+      this->FilterReorderedNeighbors(center, kNearest, bspNeighborIds);
+      return;
+      }
+    this->FindKNearestNeighbors(centerPointId, k, kNearest);
+    this->FilterNeighbors(centerPointId, kNearest, bspNeighborIds);
+  }
+
+  // Query() with the k nearest search limited by 'budget', for when slightly imperfect
+  // neighbors are acceptable in exchange for a bounded cost, see SearchBudget
+  void Query(std::size_t centerPointId, unsigned int k, const SearchBudget& budget,
+             std::vector<std::size_t>& bspNeighborIds, std::vector<NeighborType>& kNearest) const
+  {
+    if(budget.IsExact())
+      {
+      this->Query(centerPointId, k, bspNeighborIds, kNearest);
+      return;
+      }
+    this->Index->FindKNearestApproximate(this->Index->GetPoint(centerPointId), k, budget, kNearest, centerPointId);
+    this->FilterNeighbors(centerPointId, kNearest, bspNeighborIds);
+  }
+
+  void Query(std::size_t centerPointId, unsigned int k, std::vector<std::size_t>& bspNeighborIds) const
+  {
+    std::vector<NeighborType> kNearest;
+    this->Query(centerPointId, k, bspNeighborIds, kNearest);
+  }
+
+  // Find the BSP neighbors of the location 'queryPoint' among its k nearest points. The
+  // location need not be one of the points, and a point that coincides with it is a
+  // neighbor like any other.
+  void QueryPoint(const TScalar* queryPoint, unsigned int k, std::vector<std::size_t>& bspNeighborIds,
+                  std::vector<NeighborType>& kNearest) const
+  {
+    if(this->Reordered)
+      {
+      this->Reordered->FindKNearestReordered(queryPoint, k, kNearest);
+      this->FilterReorderedNeighbors(queryPoint, kNearest, bspNeighborIds);
+      return;
+      }
+    this->FindKNearestToPoint(queryPoint, k, kNearest);
+    this->FilterNeighbors(queryPoint, kNearest, bspNeighborIds);
+  }
+
+  // QueryPoint() with the k nearest search limited by 'budget', see Query()
+  void QueryPoint(const TScalar* queryPoint, unsigned int k, const SearchBudget& budget,
+                  std::vector<std::size_t>& bspNeighborIds, std::vector<NeighborType>& kNearest) const
+  {
+    if(budget.IsExact())
+      {
+      this->QueryPoint(queryPoint, k, bspNeighborIds, kNearest);
+      return;
+      }
+    this->Index->FindKNearestApproximate(queryPoint, k, budget, kNearest);
+    this->FilterNeighbors(queryPoint, kNearest, bspNeighborIds);
+  }
+
+  // Find the BSP neighbors of many points at once, row i of 'graph' holding those of
+  // the point centerPointIds[i]. The queries run across 'numberOfThreads' threads (0
+  // means use all available cores) in the order of the points along a Morton curve,
+  // so consecutive queries search the same part of the index while it is in the
+  // caches. This is faster than querying the points one by one in an arbitrary
+  // order, and the result is the same.
+  template <typename TIndex>
+  void QueryBatch(const std::size_t* centerPointIds, std::size_t numberOfQueries, unsigned int k,
+                  NeighborGraph<TIndex>* graph, int numberOfThreads = 0) const
+  {
+    std::vector<std::size_t> order;
+    ComputeMortonOrder<TScalar, Dimension>(this->Index->GetPoint(0), this->Index->GetStride(), centerPointIds,
+                                           numberOfQueries, order);
+    BatchQuery<TIndex> query(this, k, centerPointIds, 0, 0);
+    BuildNeighborGraph(numberOfQueries, query, graph, numberOfThreads, order.empty() ? 0 : &order[0]);
+  }
+
+  // The same for the locations 'queryPoints', laid out like the points with a stride
+  // of 'queryStride', see QueryPoint()
+  template <typename TIndex>
+  void QueryBatch(const TScalar* queryPoints, std::size_t numberOfQueries, unsigned int queryStride, unsigned int k,
+                  NeighborGraph<TIndex>* graph, int numberOfThreads = 0) const
+  {
+    std::vector<std::size_t> order;
+    ComputeMortonOrder<TScalar, Dimension>(queryPoints, numberOfQueries, queryStride, order);
+    BatchQuery<TIndex> query(this, k, 0, queryPoints, queryStride);
+    BuildNeighborGraph(numberOfQueries, query, graph, numberOfThreads, order.empty() ? 0 : &order[0]);
+  }
+
+  // Find the BSP neighbors of the point 'centerPointId' among the points within
+  // 'radius' of it, at most 'maxCandidates' of them unless that is 0. Unlike a fixed
+  // k, the candidates adapt to the local density. 'candidates' is scratch space.
+  void QueryInRadius(std::size_t centerPointId, TScalar radius, std::size_t maxCandidates,
+                     std::vector<std::size_t>& bspNeighborIds, std::vector<NeighborType>& candidates) const
+  {
+    if(this->Reordered)
+      {
+      const std::size_t position = this->Reordered->GetPosition(centerPointId);
+      const TScalar* center = this->Reordered->GetReorderedPoint(position);
+      this->Reordered->FindInRadiusReordered(center, radius, maxCandidates, candidates, position);
+      this->FilterReorderedNeighbors(center, candidates, bspNeighborIds);
+      return;
+      }
+    this->FindNeighborsInRadius(centerPointId, radius, maxCandidates, candidates);
+    this->FilterNeighbors(centerPointId, candidates, bspNeighborIds);
+  }
+
+  void QueryInRadius(std::size_t centerPointId, TScalar radius, std::size_t maxCandidates,
+                     std::vector<std::size_t>& bspNeighborIds) const
+  {
+    std::vector<NeighborType> candidates;
+    this->QueryInRadius(centerPointId, radius, maxCandidates, bspNeighborIds, candidates);
+  }
+
+  // Pass the BSP neighbors of the point 'centerPointId' among its k nearest neighbors
+  // to 'reducer', see NeighborhoodReducers.h, while their coordinates are still in
+  // the cache. The ids are also written to 'bspNeighborIds'. 'kNearest' is scratch
+  // space as for Query().
+  template <typename TReducer>
+  void Reduce(std::size_t centerPointId, unsigned int k, TReducer& reducer, std::vector<std::size_t>& bspNeighborIds,
+              std::vector<NeighborType>& kNearest) const
+  {
+    TScalar center[3];
+    if(this->Reordered)
+      {
+      const std::size_t position = this->Reordered->GetPosition(centerPointId);
+      const TScalar* point = this->Reordered->GetReorderedPoint(position);
+      this->Reordered->FindKNearestReordered(point, k, kNearest, position);
+      GatherPoint(point, center);
+      reducer.Begin(centerPointId, center);
+      this->FilterNeighbors(point, kNearest, bspNeighborIds, true, reducer);
+      }
+    else
+      {
+      const TScalar* point = this->Index->GetPoint(centerPointId);
+      this->FindKNearestNeighbors(centerPointId, k, kNearest);
+      GatherPoint(point, center);
+      reducer.Begin(centerPointId, center);
+      this->FilterNeighbors(point, kNearest, bspNeighborIds, false, reducer);
+      }
+    reducer.End();
+  }
+
+  // The order of all of the points along a Morton curve, in which querying every
+  // point searches the same part of the index from one query to the next. It is
+  // computed over the points of the index in place into 'order', or is the
+  // permutation of a reordered index, which already stores the points in it. Returns
+  // the first id of the order, or 0 if there are no points.
+  const std::size_t* GetQueryOrder(std::vector<std::size_t>& order) const
+  {
+    const std::size_t numberOfPoints = this->Index->GetNumberOfPoints();
+    if(numberOfPoints == 0)
+      {
+      return 0;
+      }
+    if(this->Reordered)
+      {
+      return &this->Reordered->GetPermutation()[0];
+      }
+    ComputeMortonOrder<TScalar, Dimension>(this->Index->GetPoint(0), numberOfPoints, this->Index->GetStride(), order);
+    return &order[0];
+  }
+
+  // Reduce() every point across 'numberOfThreads' threads (0 means use all available
+  // cores), in the order of the points along a Morton curve as for QueryBatch(). Each
+  // thread works on its own copy of 'reducer'. This computes per point results such
+  // as normals in one pass, without ever storing the neighbor graph.
+  template <typename TReducer>
+  void ReduceAll(unsigned int k, const TReducer& reducer, int numberOfThreads = 0) const
+  {
+    const std::size_t numberOfPoints = this->Index->GetNumberOfPoints();
+    std::vector<std::size_t> order;
+    const std::size_t* queryOrder = this->GetQueryOrder(order);
+    const std::ptrdiff_t numberOfQueries = static_cast<std::ptrdiff_t>(numberOfPoints);
+
+#ifdef _OPENMP
+    if(numberOfThreads <= 0)
+      {
+      numberOfThreads = omp_get_max_threads();
+      }
+#pragma omp parallel num_threads(numberOfThreads)
+#else
+    (void)numberOfThreads;
+#endif
+    {
+    TReducer threadReducer(reducer);
+    std::vector<std::size_t> bspNeighborIds;
+    std::vector<NeighborType> kNearest;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 256)
+#endif
+    for(std::ptrdiff_t position = 0; position < numberOfQueries; ++position)
+      {
+      this->Reduce(queryOrder[position], k, threadReducer, bspNeighborIds, kNearest);
+      }
+
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+    threadReducer.Finish();
+    }
+  }
+
+private:
+  // The reducer of queries that only want the ids
+  struct NoReducer
+  {
+    void Add(std::size_t, const TScalar*)
+    {
+    }
+  };
+
+  // One query of a batch, see BuildNeighborGraph.h. Every thread gets its own scratch
+  // storage.
+  template <typename TIndex>
+  class BatchQuery
+  {
+  public:
+    BatchQuery(const BSPNeighborSearch* search, unsigned int k, const std::size_t* centerPointIds,
+               const TScalar* queryPoints, unsigned int queryStride)
+      : Search(search), K(k), CenterPointIds(centerPointIds), QueryPoints(queryPoints), QueryStride(queryStride)
+    {
+    }
+
+    void operator()(std::size_t queryId, std::vector<TIndex>& neighborIds)
+    {
+      if(this->CenterPointIds)
+        {
+        this->Search->Query(this->CenterPointIds[queryId], this->K, this->BSPNeighborIds, this->KNearest);
+        }
+      else
+        {
+        this->Search->QueryPoint(this->QueryPoints + queryId * this->QueryStride, this->K, this->BSPNeighborIds,
+                                 this->KNearest);
+        }
+      for(std::size_t i = 0; i < this->BSPNeighborIds.size(); ++i)
+        {
+        neighborIds.push_back(static_cast<TIndex>(this->BSPNeighborIds[i]));
+        }
+    }
+
+    void Finish()
+    {
+    }
+
+  private:
+    const BSPNeighborSearch* Search;
+    unsigned int K;
+    const std::size_t* CenterPointIds;
+    const TScalar* QueryPoints;
+    unsigned int QueryStride;
+
+    std::vector<std::size_t> BSPNeighborIds;
+    std::vector<NeighborType> KNearest;
+  };
+
+  // The candidates are positions in the reordered index if 'byPosition' is set. Every
+  // kept candidate is passed to 'reducer' by id along with its gathered coordinates.
+  template <typename TId>
+  std::size_t FilterHalfSpacesAt(const TScalar* center, const TId* candidateIds, std::size_t numberOfCandidates,
+                                 TId* bspNeighborIds, bool byPosition) const
+  {
+    NoReducer reducer;
+    return this->FilterHalfSpacesAt(center, candidateIds, numberOfCandidates, bspNeighborIds, byPosition, reducer);
+  }
+
+  template <typename TId, typename TReducer>
+  std::size_t FilterHalfSpacesAt(const TScalar* center, const TId* candidateIds, std::size_t numberOfCandidates,
+                                 TId* bspNeighborIds, bool byPosition, TReducer& reducer) const
+  {
+    // Gather the candidates once, with z = 0 in 2D, into the layout of HalfSpaceFilter.h.
+    // Typical candidate counts fit in the stack buffers.
+    const unsigned int StackCandidates = 64;
+    TScalar stackCoordinates[3 * (StackCandidates + 1)];
+    unsigned int stackKept[StackCandidates];
+    std::vector<TScalar> heapCoordinates;
+    std::vector<unsigned int> heapKept;
+
+    TScalar* coordinates = stackCoordinates;
+    unsigned int* kept = stackKept;
+    if(numberOfCandidates > StackCandidates)
+      {
+      heapCoordinates.resize(3 * (numberOfCandidates + 1));
+      heapKept.resize(numberOfCandidates);
+      coordinates = &heapCoordinates[0];
+      kept = &heapKept[0];
+      }
+
+    GatherPoint(center, coordinates);
+    for(std::size_t i = 0; i < numberOfCandidates; ++i)
+      {
+      const std::size_t id = static_cast<std::size_t>(candidateIds[i]);
+      GatherPoint(byPosition ? this->Reordered->GetReorderedPoint(id) : this->Index->GetPoint(id), coordinates + 3 * (i + 1));
+      }
+
+    unsigned int numberOfKept = SmartNeighbors::FilterHalfSpaces(coordinates, coordinates + 3,
+                                                                 static_cast<unsigned int>(numberOfCandidates), kept);
+    // kept[i] >= i, so this is safe when the two arrays are the same
+    for(unsigned int i = 0; i < numberOfKept; ++i)
+      {
+      const std::size_t id = static_cast<std::size_t>(candidateIds[kept[i]]);
+      reducer.Add(byPosition ? this->Reordered->GetPermutation()[id] : id, coordinates + 3 * (kept[i] + 1));
+      bspNeighborIds[i] = candidateIds[kept[i]];
+      }
+    return numberOfKept;
+  }
+
+  void FilterNeighbors(std::size_t centerPointId, const std::vector<NeighborType>& candidates,
+                       std::vector<std::size_t>& bspNeighborIds) const
+  {
+    this->FilterNeighbors(this->Index->GetPoint(centerPointId), candidates, bspNeighborIds);
+  }
+
+  void FilterNeighbors(const TScalar* center, const std::vector<NeighborType>& candidates,
+                       std::vector<std::size_t>& bspNeighborIds) const
+  {
+    NoReducer reducer;
+    this->FilterNeighbors(center, candidates, bspNeighborIds, false, reducer);
+  }
+
+  // The same with the center and the candidates in the reordered index, returning ids
+  void FilterReorderedNeighbors(const TScalar* center, const std::vector<NeighborType>& candidates,
+                                std::vector<std::size_t>& bspNeighborIds) const
+  {
+    NoReducer reducer;
+    this->FilterNeighbors(center, candidates, bspNeighborIds, true, reducer);
+  }
+
+  template <typename TReducer>
+  void FilterNeighbors(const TScalar* center, const std::vector<NeighborType>& candidates,
+                       std::vector<std::size_t>& bspNeighborIds, bool byPosition, TReducer& reducer) const
+  {
+    bspNeighborIds.resize(candidates.size());
+    for(std::size_t i = 0; i < candidates.size(); ++i)
+      {
+      bspNeighborIds[i] = candidates[i].Id;
+      }
+    if(!bspNeighborIds.empty())
+      {
+      bspNeighborIds.resize(this->FilterHalfSpacesAt(center, &bspNeighborIds[0], bspNeighborIds.size(),
+                                                     &bspNeighborIds[0], byPosition, reducer));
+      }
+    if(byPosition)
+      {
+      const std::vector<std::size_t>& permutation = this->Reordered->GetPermutation();
+      for(std::size_t i = 0; i < bspNeighborIds.size(); ++i)
+        {
+        bspNeighborIds[i] = permutation[bspNeighborIds[i]];
+        }
+      }
+  }
+
+  static void GatherPoint(const TScalar* p, TScalar* xyz)
+  {
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      xyz[d] = d < Dimension ? p[d] : 0;
+      }
+  }
+
+  // Not copyable, the search may own its index
+  BSPNeighborSearch(const BSPNeighborSearch&);
+  void operator=(const BSPNeighborSearch&);
+
+  const IndexType* Index;
+  bool OwnsIndex;
+
+  // The index itself if it reorders the points
+  const ReorderedIndexType* Reordered;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,107 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Checks that batch queries, which run in Morton order and scatter the neighbors
+// back, give row i the neighbors that a single query of the ith point or location
+// finds, on one thread and on several, with the points in their own order and in
+// Morton order. Run by ctest, it prints each mismatch and fails if there are any.
+
+// STL
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Custom
+#include "BSPNeighborSearch.h"
+#include "NeighborGraph.h"
+#include "TestUtilities.h"
+
+namespace
+{
+const unsigned int K = 12;
+
+// Row i of 'graph' against 'expected', the neighbors of query i
+void CompareRow(const std::string& check, const std::string& distribution,
+                const SmartNeighbors::NeighborGraph<unsigned int>& graph, std::size_t i,
+                const std::vector<std::size_t>& expected)
+{
+  if(graph.GetNumberOfPoints() <= i || graph.GetNumberOfNeighbors(i) != expected.size() ||
+     !std::equal(expected.begin(), expected.end(), graph.NeighborsBegin(i)))
+    {
+    Fail(check, distribution, i);
+    }
+}
+
+void CheckBatches(const std::string& distribution, const std::vector<double>& points)
+{
+  const std::size_t numberOfPoints = points.size() / 3;
+
+  // Random points, some of them more than once, and random locations around the
+  // cloud with a stride of 4 as in an array of x, y, z, w
+  Random random(3);
+  const std::size_t numberOfQueries = numberOfPoints / 2;
+  std::vector<std::size_t> queryIds(numberOfQueries);
+  std::vector<double> queryPoints(4 * numberOfQueries);
+  for(std::size_t i = 0; i < numberOfQueries; ++i)
+    {
+    queryIds[i] = std::min(static_cast<std::size_t>(random.Uniform() * numberOfPoints), numberOfPoints - 1);
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      queryPoints[4 * i + d] = points[3 * queryIds[i] + d] + 0.01 * (random.Uniform() - 0.5);
+      }
+    }
+
+  std::vector<std::size_t> expected;
+  std::vector<SmartNeighbors::BSPNeighborSearch<double, 3>::NeighborType> kNearest;
+  for(int reorder = 0; reorder < 2; ++reorder)
+    {
+    SmartNeighbors::BSPNeighborSearch<double, 3> search(&points[0], numberOfPoints, 3, SmartNeighbors::AutomaticIndex,
+                                                        reorder != 0);
+    const std::string suffix = reorder ? " on reordered points" : "";
+    for(int numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads += 3)
+      {
+      SmartNeighbors::NeighborGraph<unsigned int> graph;
+      search.QueryBatch(&queryIds[0], numberOfQueries, K, &graph, numberOfThreads);
+      for(std::size_t i = 0; i < numberOfQueries; ++i)
+        {
+        search.Query(queryIds[i], K, expected);
+        CompareRow("The batch of points" + suffix, distribution, graph, i, expected);
+        }
+
+      search.QueryBatch(&queryPoints[0], numberOfQueries, 4, K, &graph, numberOfThreads);
+      for(std::size_t i = 0; i < numberOfQueries; ++i)
+        {
+        search.QueryPoint(&queryPoints[4 * i], K, expected, kNearest);
+        CompareRow("The batch of locations" + suffix, distribution, graph, i, expected);
+        }
+      }
+    }
+}
+}
+
+int main(int, char *[])
+{
+  const char* distributions[] = {"uniform", "plane", "lattice"};
+  for(unsigned int i = 0; i < 3; ++i)
+    {
+    std::vector<double> points;
+    GenerateCloud(distributions[i], 20000, points);
+    CheckBatches(distributions[i], points);
+    }
+  return ReportFailures();
+}
@@ -0,0 +1,493 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Benchmarks k nearest, BSP and Voronoi neighbor queries across cloud sizes,
+// candidate counts, point distributions and indexes, and writes one CSV row per
+// configuration so that runs can be compared to catch regressions.
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Custom
+#include "BSPNeighborSearch.h"
+#include "CreatePointIndex.h"
+#include "NeighborSearchStats.h"
+#include "ReorderedPointIndex.h"
+#include "VoronoiNeighborSearch.h"
+
+namespace
+{
+// A small generator with the same sequence on every platform, rand() is too short
+// on some of them for clouds of millions of points
+class Random
+{
+public:
+  explicit Random(unsigned int seed)
+    : State(0x9E3779B97F4A7C15ULL ^ seed)
+  {
+  }
+
+  // Uniform in [0, 1)
+  double Uniform()
+  {
+    // xorshift64*
+    this->State ^= this->State >> 12;
+    this->State ^= this->State << 25;
+    this->State ^= this->State >> 27;
+    unsigned long long value = this->State * 2685821657736338717ULL;
+    return (value >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  double Normal()
+  {
+    double u = std::max(this->Uniform(), 1e-300);
+    return std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * 3.14159265358979323846 * this->Uniform());
+  }
+
+private:
+  unsigned long long State;
+};
+
+// Points in about the unit cube:
+//  uniform     - uniform in the cube
+//  clustered   - 20 Gaussian clusters of different widths, so the density varies a lot
+//  surface     - a wavy height field in 3D or a circle in 2D, sampled as a scanner would
+//  pointsource - uniform in a ball as vtkPointSource generates it
+template <unsigned int Dimension>
+bool GenerateCloud(const std::string& distribution, std::size_t numberOfPoints, unsigned int seed,
+                   std::vector<double>& points)
+{
+  const double Pi = 3.14159265358979323846;
+  Random random(seed);
+  points.resize(numberOfPoints * Dimension);
+  if(distribution == "uniform")
+    {
+    for(std::size_t i = 0; i < points.size(); ++i)
+      {
+      points[i] = random.Uniform();
+      }
+    }
+  else if(distribution == "clustered")
+    {
+    const unsigned int NumberOfClusters = 20;
+    double centers[NumberOfClusters][Dimension];
+    double widths[NumberOfClusters];
+    for(unsigned int c = 0; c < NumberOfClusters; ++c)
+      {
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        centers[c][d] = 0.1 + 0.8 * random.Uniform();
+        }
+      widths[c] = 0.005 + 0.045 * random.Uniform();
+      }
+    for(std::size_t i = 0; i < numberOfPoints; ++i)
+      {
+      unsigned int c = static_cast<unsigned int>(random.Uniform() * NumberOfClusters);
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        points[i * Dimension + d] = centers[c][d] + widths[c] * random.Normal();
+        }
+      }
+    }
+  else if(distribution == "surface")
+    {
+    for(std::size_t i = 0; i < numberOfPoints; ++i)
+      {
+      double* p = &points[i * Dimension];
+      if(Dimension == 3)
+        {
+        p[0] = random.Uniform();
+        p[1] = random.Uniform();
+        p[Dimension - 1] = 0.5 + 0.1 * std::sin(6 * Pi * p[0]) * std::cos(4 * Pi * p[1]) + 1e-4 * random.Normal();
+        }
+      else
+        {
+        double angle = 2 * Pi * random.Uniform();
+        double radius = 0.4 + 1e-4 * random.Normal();
+        p[0] = 0.5 + radius * std::cos(angle);
+        p[1] = 0.5 + radius * std::sin(angle);
+        }
+      }
+    }
+  else if(distribution == "pointsource")
+    {
+    // vtkPointSource with a radius of 0.5 and its uniform distribution
+    for(std::size_t i = 0; i < numberOfPoints; ++i)
+      {
+      double* p = &points[i * Dimension];
+      double theta = 2 * Pi * random.Uniform();
+      if(Dimension == 3)
+        {
+        double cosphi = 1 - 2 * random.Uniform();
+        double sinphi = std::sqrt(1 - cosphi * cosphi);
+        double rho = 0.5 * std::pow(random.Uniform(), 1.0 / 3.0);
+        p[0] = 0.5 + rho * sinphi * std::cos(theta);
+        p[1] = 0.5 + rho * sinphi * std::sin(theta);
+        p[Dimension - 1] = 0.5 + rho * cosphi;
+        }
+      else
+        {
+        double rho = 0.5 * std::sqrt(random.Uniform());
+        p[0] = 0.5 + rho * std::cos(theta);
+        p[1] = 0.5 + rho * std::sin(theta);
+        }
+      }
+    }
+  else
+    {
+    return false;
+    }
+  return true;
+}
+
+template <typename T>
+bool ParseList(const std::string& text, std::vector<T>& values)
+{
+  values.clear();
+  std::stringstream list(text);
+  std::string item;
+  while(std::getline(list, item, ','))
+    {
+    std::stringstream itemStream(item);
+    T value;
+    if(!(itemStream >> value))
+      {
+      return false;
+      }
+    values.push_back(value);
+    }
+  return !values.empty();
+}
+
+// Sizes are parsed as doubles so that 1e6 can be written for a million
+bool ParseSizes(const std::string& text, std::vector<std::size_t>& sizes)
+{
+  std::vector<double> values;
+  if(!ParseList(text, values))
+    {
+    return false;
+    }
+  sizes.clear();
+  for(std::size_t i = 0; i < values.size(); ++i)
+    {
+    if(!(values[i] >= 2))
+      {
+      return false;
+      }
+    sizes.push_back(static_cast<std::size_t>(values[i]));
+    }
+  return true;
+}
+
+struct Options
+{
+  std::vector<std::size_t> Sizes;
+  std::vector<unsigned int> Ks;
+  std::vector<std::string> Distributions;
+  std::vector<std::string> Methods;
+  std::vector<std::string> Indexes;
+  unsigned int Dimension;
+  std::size_t NumberOfQueries;
+  unsigned int Seed;
+  bool ReorderPoints;
+};
+
+// The value at 'fraction' of the sorted latencies, by nearest rank
+double Percentile(const std::vector<double>& sorted, double fraction)
+{
+  std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+  return sorted[std::min(std::max(rank, static_cast<std::size_t>(1)), sorted.size()) - 1];
+}
+
+const char* GetIndexName(SmartNeighbors::PointIndexType indexType)
+{
+  return indexType == SmartNeighbors::UniformGridIndex ? "grid" : "kdtree";
+}
+
+template <unsigned int Dimension>
+void Run(const Options& options, std::ostream& os)
+{
+  typedef SmartNeighbors::PointIndex<double, Dimension> IndexType;
+  typedef typename IndexType::NeighborType NeighborType;
+  typedef SmartNeighbors::NeighborSearchStats Stats;
+
+  for(std::size_t distribution = 0; distribution < options.Distributions.size(); ++distribution)
+    {
+    for(std::size_t size = 0; size < options.Sizes.size(); ++size)
+      {
+      const std::size_t numberOfPoints = options.Sizes[size];
+      std::vector<double> points;
+      GenerateCloud<Dimension>(options.Distributions[distribution], numberOfPoints, options.Seed, points);
+
+      double bounds[2 * Dimension];
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        bounds[2*d] = points[d];
+        bounds[2*d + 1] = points[d];
+        for(std::size_t i = 1; i < numberOfPoints; ++i)
+          {
+          bounds[2*d] = std::min(bounds[2*d], points[i * Dimension + d]);
+          bounds[2*d + 1] = std::max(bounds[2*d + 1], points[i * Dimension + d]);
+          }
+        }
+
+      // The same random queries for every index, k and method. Random order defeats
+      // the caches as a worst case would.
+      Random random(options.Seed + 1);
+      std::vector<std::size_t> queryIds(std::min(options.NumberOfQueries, numberOfPoints));
+      for(std::size_t i = 0; i < queryIds.size(); ++i)
+        {
+        queryIds[i] = std::min(static_cast<std::size_t>(random.Uniform() * numberOfPoints), numberOfPoints - 1);
+        }
+
+      for(std::size_t index = 0; index < options.Indexes.size(); ++index)
+        {
+        double startTime = Stats::GetTime();
+        SmartNeighbors::PointIndexType indexType = SmartNeighbors::KdTreeIndex;
+        if(options.Indexes[index] == "grid")
+          {
+          indexType = SmartNeighbors::UniformGridIndex;
+          }
+        else if(options.Indexes[index] == "auto")
+          {
+          indexType = SmartNeighbors::ChoosePointIndexType<double, Dimension>(&points[0], numberOfPoints);
+          }
+        IndexType* pointIndex = 0;
+        if(options.ReorderPoints)
+          {
+          pointIndex = new SmartNeighbors::ReorderedPointIndex<double, Dimension>(&points[0], numberOfPoints, Dimension,
+                                                                                 indexType);
+          }
+        else
+          {
+          pointIndex = SmartNeighbors::CreatePointIndex<double, Dimension>(&points[0], numberOfPoints, Dimension,
+                                                                           indexType);
+          }
+        const double buildTime = Stats::GetTime() - startTime;
+
+        std::string indexName = GetIndexName(indexType);
+        if(options.Indexes[index] == "auto")
+          {
+          indexName = "auto:" + indexName;
+          }
+        if(options.ReorderPoints)
+          {
+          indexName += ":morton";
+          }
+
+        SmartNeighbors::BSPNeighborSearch<double, Dimension> bspSearch(pointIndex);
+        SmartNeighbors::VoronoiNeighborSearch<double, Dimension> voronoiSearch(pointIndex, bounds);
+        typename SmartNeighbors::VoronoiNeighborSearch<double, Dimension>::CellType cell;
+        std::vector<NeighborType> kNearest;
+        std::vector<std::size_t> neighborIds;
+        std::vector<double> latencies(queryIds.size());
+
+        for(std::size_t kIndex = 0; kIndex < options.Ks.size(); ++kIndex)
+          {
+          const unsigned int k = options.Ks[kIndex];
+          for(std::size_t method = 0; method < options.Methods.size(); ++method)
+            {
+            const std::string& methodName = options.Methods[method];
+            std::size_t numberOfNeighbors = 0;
+            for(std::size_t i = 0; i < queryIds.size(); ++i)
+              {
+              const std::size_t id = queryIds[i];
+              double queryStartTime = Stats::GetTime();
+              if(methodName == "knn")
+                {
+                pointIndex->FindKNearest(pointIndex->GetPoint(id), k, kNearest, id);
+                numberOfNeighbors += kNearest.size();
+                }
+              else if(methodName == "bsp")
+                {
+                bspSearch.Query(id, k, neighborIds, kNearest);
+                numberOfNeighbors += neighborIds.size();
+                }
+              else
+                {
+                // k is the initial number of candidates, see VoronoiNeighborSearch.h
+                voronoiSearch.Query(id, neighborIds, k, 0, 0, cell, kNearest);
+                numberOfNeighbors += neighborIds.size();
+                }
+              latencies[i] = Stats::GetTime() - queryStartTime;
+              }
+
+            double totalTime = 0.0;
+            for(std::size_t i = 0; i < latencies.size(); ++i)
+              {
+              totalTime += latencies[i];
+              }
+            std::sort(latencies.begin(), latencies.end());
+
+            os << options.Distributions[distribution] << "," << Dimension << "," << numberOfPoints << "," << k << ","
+               << methodName << "," << indexName << "," << buildTime << "," << queryIds.size() << ","
+               << 1e6 * Percentile(latencies, 0.5) << "," << 1e6 * Percentile(latencies, 0.9) << ","
+               << 1e6 * Percentile(latencies, 0.99) << "," << 1e6 * latencies.back() << ","
+               << (totalTime > 0 ? queryIds.size() / totalTime : 0.0) << ","
+               << static_cast<double>(numberOfNeighbors) / queryIds.size() << ","
+               << pointIndex->GetMemorySize() / 1048576.0 << std::endl;
+            }
+          }
+
+        delete pointIndex;
+        }
+      }
+    }
+}
+
+void PrintUsage()
+{
+  std::cerr << "Usage: SmartNeighborsBenchmark [options]" << std::endl
+            << "  --sizes 1e3,1e4,1e5,1e6,1e7       numbers of points" << std::endl
+            << "  --k 8,16,32,64,128                candidates, the initial ones for Voronoi" << std::endl
+            << "  --distributions uniform,clustered,surface,pointsource" << std::endl
+            << "  --methods knn,bsp,voronoi" << std::endl
+            << "  --indexes auto,kdtree,grid" << std::endl
+            << "  --dimension 3                     2 or 3" << std::endl
+            << "  --queries 10000                   timed queries per configuration" << std::endl
+            << "  --seed 1" << std::endl
+            << "  --reorder 0                       1 to store the points in Morton order" << std::endl
+            << "  --output results.csv              instead of the standard output" << std::endl;
+}
+}
+
+int main(int argc, char *argv[])
+{
+  Options options;
+  ParseSizes("1e3,1e4,1e5,1e6,1e7", options.Sizes);
+  ParseList("8,16,32,64,128", options.Ks);
+  ParseList(std::string("uniform,clustered,surface,pointsource"), options.Distributions);
+  ParseList(std::string("knn,bsp,voronoi"), options.Methods);
+  ParseList(std::string("auto,kdtree,grid"), options.Indexes);
+  options.Dimension = 3;
+  options.NumberOfQueries = 10000;
+  options.Seed = 1;
+  options.ReorderPoints = false;
+  std::string outputFileName;
+
+  // Parse arguments
+  for(int i = 1; i < argc; i += 2)
+    {
+    std::string name = argv[i];
+    if(i + 1 >= argc)
+      {
+      PrintUsage();
+      return EXIT_FAILURE;
+      }
+    std::string value = argv[i + 1];
+    bool valid = true;
+    if(name == "--sizes")
+      {
+      valid = ParseSizes(value, options.Sizes);
+      }
+    else if(name == "--k")
+      {
+      valid = ParseList(value, options.Ks);
+      }
+    else if(name == "--distributions")
+      {
+      valid = ParseList(value, options.Distributions);
+      for(std::size_t j = 0; j < options.Distributions.size(); ++j)
+        {
+        std::vector<double> unused;
+        valid = valid && GenerateCloud<3>(options.Distributions[j], 0, 0, unused);
+        }
+      }
+    else if(name == "--methods")
+      {
+      valid = ParseList(value, options.Methods);
+      for(std::size_t j = 0; j < options.Methods.size(); ++j)
+        {
+        valid = valid && (options.Methods[j] == "knn" || options.Methods[j] == "bsp" || options.Methods[j] == "voronoi");
+        }
+      }
+    else if(name == "--indexes")
+      {
+      valid = ParseList(value, options.Indexes);
+      for(std::size_t j = 0; j < options.Indexes.size(); ++j)
+        {
+        valid = valid && (options.Indexes[j] == "auto" || options.Indexes[j] == "kdtree" || options.Indexes[j] == "grid");
+        }
+      }
+    else if(name == "--dimension")
+      {
+      valid = (std::stringstream(value) >> options.Dimension) && (options.Dimension == 2 || options.Dimension == 3);
+      }
+    else if(name == "--queries")
+      {
+      valid = (std::stringstream(value) >> options.NumberOfQueries) && options.NumberOfQueries > 0;
+      }
+    else if(name == "--seed")
+      {
+      valid = static_cast<bool>(std::stringstream(value) >> options.Seed);
+      }
+    else if(name == "--reorder")
+      {
+      valid = static_cast<bool>(std::stringstream(value) >> options.ReorderPoints);
+      }
+    else if(name == "--output")
+      {
+      outputFileName = value;
+      }
+    else
+      {
+      valid = false;
+      }
+    if(!valid)
+      {
+      std::cerr << "Invalid value for " << name << ": " << value << std::endl;
+      PrintUsage();
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::ofstream outputFile;
+  if(!outputFileName.empty())
+    {
+    outputFile.open(outputFileName.c_str());
+    if(!outputFile)
+      {
+      std::cerr << "Could not write " << outputFileName << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  std::ostream& os = outputFileName.empty() ? std::cout : outputFile;
+
+  // The latencies are in microseconds, the build time in seconds and the
+  // throughput in queries per second of one thread. The memory is what the index
+  // allocates on top of the cloud, see PointIndex::GetMemorySize().
+  os << "distribution,dimension,points,k,method,index,build_s,queries,p50_us,p90_us,p99_us,max_us,"
+     << "queries_per_s,mean_neighbors,memory_mb" << std::endl;
+  if(options.Dimension == 2)
+    {
+    Run<2>(options, os);
+    }
+  else
+    {
+    Run<3>(options, os);
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef BUILDNEIGHBORGRAPH_H
+#define BUILDNEIGHBORGRAPH_H
+
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Custom
+#include "NeighborGraph.h"
+
+namespace SmartNeighbors
+{
+
+namespace BuildNeighborGraphDetail
+{
+// Queries are handed out in blocks of this many points. The block
+// boundaries do not depend on the thread count, which keeps the output
+// deterministic, and blocks are small enough to balance uneven query costs.
+const std::ptrdiff_t QueryBlockSize = 256;
+
+template <typename TIndex>
+struct QueryBlock
+{
+  std::vector<std::size_t> NumberOfNeighbors;
+  std::vector<TIndex> NeighborIds;
+};
+
+// Lay out blocks of queries that ran in the order 'queryOrder', each point's
+// neighbors where the point is rather than where its query ran
+template <typename TIndex>
+void ScatterNeighborGraph(std::vector<QueryBlock<TIndex> >& blocks, const std::size_t* queryOrder,
+                          NeighborGraph<TIndex>* graph, int numberOfThreads)
+{
+  const std::ptrdiff_t numberOfBlocks = static_cast<std::ptrdiff_t>(blocks.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numberOfThreads) schedule(static)
+#else
+  (void)numberOfThreads;
+#endif
+  for(std::ptrdiff_t blockId = 0; blockId < numberOfBlocks; ++blockId)
+    {
+    const QueryBlock<TIndex>& block = blocks[blockId];
+    const std::size_t* pointIds = queryOrder + blockId * QueryBlockSize;
+    for(std::size_t i = 0; i < block.NumberOfNeighbors.size(); ++i)
+      {
+      graph->Offsets[pointIds[i] + 1] = block.NumberOfNeighbors[i];
+      }
+    }
+
+  for(std::size_t pointId = 0; pointId + 1 < graph->Offsets.size(); ++pointId)
+    {
+    graph->Offsets[pointId + 1] += graph->Offsets[pointId];
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numberOfThreads) schedule(static)
+#endif
+  for(std::ptrdiff_t blockId = 0; blockId < numberOfBlocks; ++blockId)
+    {
+    QueryBlock<TIndex>& block = blocks[blockId];
+    const std::size_t* pointIds = queryOrder + blockId * QueryBlockSize;
+    typename std::vector<TIndex>::const_iterator neighborIds = block.NeighborIds.begin();
+    for(std::size_t i = 0; i < block.NumberOfNeighbors.size(); ++i)
+      {
+      std::copy(neighborIds, neighborIds + block.NumberOfNeighbors[i],
+                graph->NeighborIds.begin() + graph->Offsets[pointIds[i]]);
+      neighborIds += block.NumberOfNeighbors[i];
+      }
+
+    std::vector<TIndex>().swap(block.NeighborIds);
+    }
+}
+}
+
+// Run one neighbor query per point across 'numberOfThreads' threads (0 means use all
+// available cores) and lay the results out as a graph. Each thread works on its own
+// copy of 'query', which must provide
+//
+//   void operator()(std::size_t pointId, std::vector<TIndex>& neighborIds);
+//   void Finish();
+//
+// The call operator appends the neighbors of one point. Finish() is called once by
+// each thread after its last query, one thread at a time, to merge per thread state
+// such as statistics. The result does not depend on the number of threads.
+//
+// The queries run in the order 'queryOrder', a permutation of the points, if it is
+// given, and in the order of the points otherwise. Running nearby points one after
+// another, as in ComputeMortonOrder(), keeps the parts of the index they search in
+// the caches. The graph is in the order of the points either way.
+template <typename TIndex, typename TQuery>
+void BuildNeighborGraph(std::size_t numberOfPoints, const TQuery& query, NeighborGraph<TIndex>* graph,
+                        int numberOfThreads = 0, const std::size_t* queryOrder = 0)
+{
+  using BuildNeighborGraphDetail::QueryBlockSize;
+  typedef BuildNeighborGraphDetail::QueryBlock<TIndex> BlockType;
+
+  const std::ptrdiff_t numberOfBlocks = (static_cast<std::ptrdiff_t>(numberOfPoints) + QueryBlockSize - 1) / QueryBlockSize;
+  std::vector<BlockType> blocks(numberOfBlocks);
+
+#ifdef _OPENMP
+  if(numberOfThreads <= 0)
+    {
+    numberOfThreads = omp_get_max_threads();
+    }
+#pragma omp parallel num_threads(numberOfThreads)
+#else
+  (void)numberOfThreads;
+#endif
+  {
+  TQuery threadQuery(query);
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+  for(std::ptrdiff_t blockId = 0; blockId < numberOfBlocks; ++blockId)
+    {
+    BlockType& block = blocks[blockId];
+    std::size_t begin = blockId * QueryBlockSize;
+    std::size_t end = std::min(begin + QueryBlockSize, numberOfPoints);
+    block.NumberOfNeighbors.reserve(end - begin);
+
+    for(std::size_t position = begin; position < end; ++position)
+      {
+      std::size_t numberOfIds = block.NeighborIds.size();
+      threadQuery(queryOrder ? queryOrder[position] : position, block.NeighborIds);
+      block.NumberOfNeighbors.push_back(block.NeighborIds.size() - numberOfIds);
+      }
+    }
+
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+  threadQuery.Finish();
+  }
+
+  // Lay the blocks out one after another. The graph is sized exactly once,
+  // so existing storage in it is reused rather than reallocated.
+  std::vector<std::size_t> blockOffsets(numberOfBlocks + 1, 0);
+  for(std::ptrdiff_t blockId = 0; blockId < numberOfBlocks; ++blockId)
+    {
+    blockOffsets[blockId + 1] = blockOffsets[blockId] + blocks[blockId].NeighborIds.size();
+    }
+
+  graph->Allocate(numberOfPoints, blockOffsets[numberOfBlocks]);
+
+  if(queryOrder)
+    {
+    BuildNeighborGraphDetail::ScatterNeighborGraph(blocks, queryOrder, graph, numberOfThreads);
+    return;
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numberOfThreads) schedule(static)
+#endif
+  for(std::ptrdiff_t blockId = 0; blockId < numberOfBlocks; ++blockId)
+    {
+    BlockType& block = blocks[blockId];
+    std::size_t offset = blockOffsets[blockId];
+    std::size_t pointId = blockId * QueryBlockSize;
+    for(std::size_t i = 0; i < block.NumberOfNeighbors.size(); ++i)
+      {
+      offset += block.NumberOfNeighbors[i];
+      graph->Offsets[pointId + i + 1] = offset;
+      }
+    std::copy(block.NeighborIds.begin(), block.NeighborIds.end(),
+              graph->NeighborIds.begin() + blockOffsets[blockId]);
+
+    // Release the block as soon as it has been copied
+    std::vector<TIndex>().swap(block.NeighborIds);
+    }
+}
+
+} // end namespace SmartNeighbors
+
+#endif
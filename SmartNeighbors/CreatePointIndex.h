@@ -0,0 +1,118 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef CREATEPOINTINDEX_H
+#define CREATEPOINTINDEX_H
+
+// STL
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Custom
+#include "KdTree.h"
+#include "UniformGrid.h"
+
+namespace SmartNeighbors
+{
+
+// Choose the index for these points from how evenly they fill their bounding box.
+// The points are counted in the cells of the grid that UniformGrid would build. The
+// grid wins when few of its cells are empty and the counts of the others vary about
+// as little as for uniformly random points (a coefficient of variation near 0.5 at 4
+// points per cell). Clusters, scans of surfaces in 3D and large holes leave many
+// cells empty or crowd a few, and then the kd-tree wins.
+template <typename TScalar, unsigned int Dimension>
+PointIndexType ChoosePointIndexType(const TScalar* points, std::size_t numberOfPoints, unsigned int stride = Dimension)
+{
+  const double MaximumEmptyFraction = 0.5;
+  const double MaximumVariation = 1.0;
+
+  double origin[Dimension];
+  double spacing[Dimension];
+  unsigned int size[Dimension];
+  UniformGrid<TScalar, Dimension>::ComputeGeometry(points, numberOfPoints, stride, origin, spacing, size);
+  // A grid with more cells than points is mostly empty, don't count into it
+  double numberOfCells = 1;
+  for(unsigned int d = 0; d < Dimension; ++d)
+    {
+    numberOfCells *= size[d];
+    }
+  if(numberOfCells <= 1 || numberOfCells > numberOfPoints)
+    {
+    return KdTreeIndex;
+    }
+
+  std::vector<unsigned int> counts(static_cast<std::size_t>(numberOfCells), 0);
+  for(std::size_t i = 0; i < numberOfPoints; ++i)
+    {
+    const TScalar* p = points + i * stride;
+    std::size_t cellId = 0;
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      const double position = (p[d] - origin[d]) / spacing[d];
+      const unsigned int index = position > 0 ? static_cast<unsigned int>(position) : 0;
+      cellId = cellId * size[d] + std::min(index, size[d] - 1);
+      }
+    counts[cellId]++;
+    }
+
+  std::size_t occupied = 0;
+  double sum = 0;
+  double sum2 = 0;
+  for(std::size_t cell = 0; cell < counts.size(); ++cell)
+    {
+    if(counts[cell] > 0)
+      {
+      occupied++;
+      sum += counts[cell];
+      sum2 += static_cast<double>(counts[cell]) * counts[cell];
+      }
+    }
+  const double emptyFraction = 1.0 - static_cast<double>(occupied) / numberOfCells;
+  const double mean = sum / occupied;
+  const double variation = std::sqrt(std::max(0.0, sum2 / occupied - mean * mean)) / mean;
+
+  if(emptyFraction <= MaximumEmptyFraction && variation <= MaximumVariation)
+    {
+    return UniformGridIndex;
+    }
+  return KdTreeIndex;
+}
+
+// Build an index of the given type over the points, see PointIndex.h. The caller
+// owns the index and deletes it.
+template <typename TScalar, unsigned int Dimension>
+PointIndex<TScalar, Dimension>* CreatePointIndex(const TScalar* points, std::size_t numberOfPoints,
+                                                 unsigned int stride = Dimension,
+                                                 PointIndexType indexType = AutomaticIndex)
+{
+  if(indexType == AutomaticIndex)
+    {
+    indexType = ChoosePointIndexType<TScalar, Dimension>(points, numberOfPoints, stride);
+    }
+  if(indexType == UniformGridIndex)
+    {
+    return new UniformGrid<TScalar, Dimension>(points, numberOfPoints, stride);
+    }
+  return new KdTree<TScalar, Dimension>(points, numberOfPoints, stride);
+}
+
+} // end namespace SmartNeighbors
+
+#endif
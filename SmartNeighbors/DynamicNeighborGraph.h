@@ -0,0 +1,347 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef DYNAMICNEIGHBORGRAPH_H
+#define DYNAMICNEIGHBORGRAPH_H
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+// Custom
+#include "BSPNeighborSearch.h"
+#include "DynamicPointIndex.h"
+#include "VoronoiNeighborSearch.h"
+
+namespace SmartNeighbors
+{
+
+// The neighbors of every point of a DynamicPointIndex, kept up to date as points are
+// inserted and removed. Only the points that a change can affect are recomputed:
+//  - Each point records the ball around it that its neighbors depend on, such as
+//    its kNN ball or the security radius of its Voronoi cell. A point inserted into
+//    that ball may change them, one inserted elsewhere cannot. The balls are listed
+//    in the cells of the index that they overlap, so an insertion only tests the
+//    balls listed in its own cell.
+//  - Each point also records the points whose removal would change its neighbors,
+//    such as its k nearest points or its Voronoi neighbors.
+// So the work per change is proportional to the number of points around it, not to
+// the number of points. Subclasses say how the neighbors of one point are found.
+template <typename TScalar, unsigned int Dimension>
+class DynamicNeighborGraph
+{
+public:
+  typedef DynamicPointIndex<TScalar, Dimension> IndexType;
+
+  // See DynamicPointIndex for the cell size
+  explicit DynamicNeighborGraph(double cellSize)
+    : Index(cellSize)
+  {
+  }
+
+  virtual ~DynamicNeighborGraph() {}
+
+  // Insert a point and return its id. If 'changedIds' is given it is set to the
+  // points whose neighbors were recomputed, the new point first.
+  std::size_t Insert(const TScalar* p, std::vector<std::size_t>* changedIds = 0)
+  {
+    // The points whose balls contain the new one
+    std::vector<std::size_t> affected;
+    typename BallMap::const_iterator cell = this->Balls.find(this->Index.GetCellKey(p));
+    if(cell != this->Balls.end())
+      {
+      this->AddContainingBalls(cell->second, p, affected);
+      }
+    this->AddContainingBalls(this->LargeBalls, p, affected);
+
+    const std::size_t id = this->Index.Insert(p);
+    const std::size_t numberOfIds = this->Index.GetNumberOfPoints();
+    if(this->Neighbors.size() < numberOfIds)
+      {
+      this->Neighbors.resize(numberOfIds);
+      this->Dependencies.resize(numberOfIds);
+      this->Dependents.resize(numberOfIds);
+      this->Radius.resize(numberOfIds, 0.0);
+      this->Linked.resize(numberOfIds, false);
+      }
+
+    this->Update(id);
+    for(std::size_t i = 0; i < affected.size(); ++i)
+      {
+      this->Update(affected[i]);
+      }
+
+    if(changedIds)
+      {
+      changedIds->assign(1, id);
+      changedIds->insert(changedIds->end(), affected.begin(), affected.end());
+      }
+    return id;
+  }
+
+  // Remove the point 'id'. If 'changedIds' is given it is set to the points whose
+  // neighbors were recomputed.
+  void Remove(std::size_t id, std::vector<std::size_t>* changedIds = 0)
+  {
+    if(changedIds)
+      {
+      changedIds->clear();
+      }
+    if(!this->Index.Contains(id))
+      {
+      return;
+      }
+
+    const std::vector<std::size_t> affected = this->Dependents[id];
+    this->Unlink(id);
+    this->Neighbors[id].clear();
+    this->Index.Remove(id);
+
+    for(std::size_t i = 0; i < affected.size(); ++i)
+      {
+      this->Update(affected[i]);
+      }
+    this->Dependents[id].clear();
+
+    if(changedIds)
+      {
+      *changedIds = affected;
+      }
+  }
+
+  // The neighbors of the point 'id', which must not have been removed
+  const std::vector<std::size_t>& GetNeighbors(std::size_t id) const
+  {
+    return this->Neighbors[id];
+  }
+
+  const IndexType& GetIndex() const
+  {
+    return this->Index;
+  }
+
+protected:
+  // Find the neighbors of the point 'id' among the current points. 'dependencyIds'
+  // is set to the points whose removal could change them and 'radius' to the radius
+  // of the ball around the point that an insertion must fall in to change them.
+  virtual void ComputeNeighbors(std::size_t id, std::vector<std::size_t>& neighborIds,
+                                std::vector<std::size_t>& dependencyIds, double& radius) = 0;
+
+  IndexType Index;
+
+private:
+  // Not copyable, the searches of the subclasses reference the index
+  DynamicNeighborGraph(const DynamicNeighborGraph&);
+  void operator=(const DynamicNeighborGraph&);
+
+  typedef typename IndexType::CellKey CellKey;
+  typedef std::map<CellKey, std::vector<std::size_t> > BallMap;
+
+  // Balls that overlap more cells than this along an axis, or are unbounded, are
+  // tested by every insertion instead of being listed in their cells. They are the
+  // balls of the few points far from the others.
+  static const long MaximumBallCells = 4;
+
+  void Update(std::size_t id)
+  {
+    this->Unlink(id);
+    this->ComputeNeighbors(id, this->Neighbors[id], this->Dependencies[id], this->Radius[id]);
+    for(std::size_t i = 0; i < this->Dependencies[id].size(); ++i)
+      {
+      this->Dependents[this->Dependencies[id][i]].push_back(id);
+      }
+    this->LinkBall(id, true);
+    this->Linked[id] = true;
+  }
+
+  // Forget what the point 'id' depends on, before it is recomputed or removed
+  void Unlink(std::size_t id)
+  {
+    if(!this->Linked[id])
+      {
+      return;
+      }
+    this->LinkBall(id, false);
+    this->Linked[id] = false;
+
+    for(std::size_t i = 0; i < this->Dependencies[id].size(); ++i)
+      {
+      std::vector<std::size_t>& dependents = this->Dependents[this->Dependencies[id][i]];
+      dependents.erase(std::find(dependents.begin(), dependents.end(), id));
+      }
+    this->Dependencies[id].clear();
+  }
+
+  // List the ball of the point 'id' in the cells that it overlaps, or take it out of
+  // them. The point must not have been removed from the index yet.
+  void LinkBall(std::size_t id, bool link)
+  {
+    const TScalar* center = this->Index.GetPoint(id);
+    const double cellSize = this->Index.GetCellSize();
+    // Widened for the rounding of the cell of the inserted point
+    const double radius = this->Radius[id] * (1 + 1e-12);
+    CellKey lower;
+    CellKey upper;
+    bool large = !(radius < HUGE_VAL);
+    for(unsigned int d = 0; d < Dimension && !large; ++d)
+      {
+      const double slack = 1e-12 * std::fabs(static_cast<double>(center[d]));
+      const double first = std::floor((center[d] - radius - slack) / cellSize);
+      const double last = std::floor((center[d] + radius + slack) / cellSize);
+      large = last - first + 1 > MaximumBallCells;
+      lower.Index[d] = static_cast<long>(first);
+      upper.Index[d] = static_cast<long>(last);
+      }
+
+    if(large)
+      {
+      if(link)
+        {
+        this->LargeBalls.push_back(id);
+        }
+      else
+        {
+        this->LargeBalls.erase(std::find(this->LargeBalls.begin(), this->LargeBalls.end(), id));
+        }
+      return;
+      }
+
+    CellKey cell = lower;
+    while(true)
+      {
+      if(link)
+        {
+        this->Balls[cell].push_back(id);
+        }
+      else
+        {
+        typename BallMap::iterator entry = this->Balls.find(cell);
+        std::vector<std::size_t>& ids = entry->second;
+        ids.erase(std::find(ids.begin(), ids.end(), id));
+        if(ids.empty())
+          {
+          this->Balls.erase(entry);
+          }
+        }
+
+      // The next cell of the box, the first axis fastest
+      unsigned int d = 0;
+      while(d < Dimension && cell.Index[d] == upper.Index[d])
+        {
+        cell.Index[d] = lower.Index[d];
+        ++d;
+        }
+      if(d == Dimension)
+        {
+        break;
+        }
+      cell.Index[d]++;
+      }
+  }
+
+  void AddContainingBalls(const std::vector<std::size_t>& ids, const TScalar* p, std::vector<std::size_t>& affected) const
+  {
+    for(std::size_t i = 0; i < ids.size(); ++i)
+      {
+      const double radius = this->Radius[ids[i]];
+      if(Distance2<TScalar, Dimension>(this->Index.GetPoint(ids[i]), p) <= radius * radius)
+        {
+        affected.push_back(ids[i]);
+        }
+      }
+  }
+
+  std::vector<std::vector<std::size_t> > Neighbors;
+  std::vector<std::vector<std::size_t> > Dependencies;
+  std::vector<std::vector<std::size_t> > Dependents;
+  std::vector<double> Radius;
+  std::vector<bool> Linked;
+
+  // The points whose balls overlap each cell, and the points with large balls
+  BallMap Balls;
+  std::vector<std::size_t> LargeBalls;
+};
+
+// The BSP neighbors of every point among its k nearest points, see BSPNeighborSearch.h
+template <typename TScalar, unsigned int Dimension>
+class DynamicBSPNeighborGraph : public DynamicNeighborGraph<TScalar, Dimension>
+{
+public:
+  typedef DynamicNeighborGraph<TScalar, Dimension> Superclass;
+
+  DynamicBSPNeighborGraph(double cellSize, unsigned int k)
+    : Superclass(cellSize), K(k), Search(&this->Index)
+  {
+  }
+
+protected:
+  void ComputeNeighbors(std::size_t id, std::vector<std::size_t>& neighborIds, std::vector<std::size_t>& dependencyIds,
+                        double& radius)
+  {
+    this->Search.Query(id, this->K, neighborIds, this->KNearest);
+    dependencyIds.resize(this->KNearest.size());
+    for(std::size_t i = 0; i < this->KNearest.size(); ++i)
+      {
+      dependencyIds[i] = this->KNearest[i].Id;
+      }
+    // With fewer than k other points any new point is a candidate
+    radius = this->KNearest.size() < this->K ? HUGE_VAL : std::sqrt(static_cast<double>(this->KNearest.back().Distance2));
+  }
+
+private:
+  unsigned int K;
+  BSPNeighborSearch<TScalar, Dimension> Search;
+  std::vector<typename BSPNeighborSearch<TScalar, Dimension>::NeighborType> KNearest;
+};
+
+// The Voronoi neighbors of every point, see VoronoiNeighborSearch.h. The cells are
+// clipped to fixed bounds, so that a change far away cannot move the cells on the
+// boundary.
+template <typename TScalar, unsigned int Dimension>
+class DynamicVoronoiNeighborGraph : public DynamicNeighborGraph<TScalar, Dimension>
+{
+public:
+  typedef DynamicNeighborGraph<TScalar, Dimension> Superclass;
+
+  // The bounds are the first 2 * Dimension values of {xmin, xmax, ymin, ymax, zmin, zmax}
+  DynamicVoronoiNeighborGraph(double cellSize, const double* bounds)
+    : Superclass(cellSize), Search(&this->Index, bounds)
+  {
+  }
+
+protected:
+  void ComputeNeighbors(std::size_t id, std::vector<std::size_t>& neighborIds, std::vector<std::size_t>& dependencyIds,
+                        double& radius)
+  {
+    // Removing a point that does not share a face with the cell does not change it
+    this->Search.Query(id, neighborIds, 16, 0, &radius, this->Cell, this->KNearest);
+    dependencyIds = neighborIds;
+  }
+
+private:
+  VoronoiNeighborSearch<TScalar, Dimension> Search;
+  typename VoronoiNeighborSearch<TScalar, Dimension>::CellType Cell;
+  std::vector<typename VoronoiNeighborSearch<TScalar, Dimension>::NeighborType> KNearest;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
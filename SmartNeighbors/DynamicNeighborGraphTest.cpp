@@ -0,0 +1,141 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Checks that the dynamic neighbor graphs, repaired after every insertion and
+// removal, hold the neighbors that a search over the remaining points finds from
+// scratch: BSP neighbors and Voronoi neighbors clipped to the unit box, in 2D and
+// in 3D. Run by ctest, it prints each mismatch and fails if there are any.
+
+// STL
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Custom
+#include "BSPNeighborSearch.h"
+#include "DynamicNeighborGraph.h"
+#include "TestUtilities.h"
+#include "VoronoiNeighborSearch.h"
+
+namespace
+{
+const unsigned int K = 12;
+const double Bounds[6] = {0, 1, 0, 1, 0, 1};
+
+// The neighbors of every point of 'points' found from scratch, as the graph finds them
+template <unsigned int Dimension>
+void FindNeighbors(const SmartNeighbors::DynamicBSPNeighborGraph<double, Dimension>&, const std::vector<double>& points,
+                   std::vector<std::vector<std::size_t> >& neighborIds)
+{
+  SmartNeighbors::BSPNeighborSearch<double, Dimension> search(&points[0], points.size() / Dimension);
+  for(std::size_t id = 0; id < neighborIds.size(); ++id)
+    {
+    search.Query(id, K, neighborIds[id]);
+    }
+}
+
+template <unsigned int Dimension>
+void FindNeighbors(const SmartNeighbors::DynamicVoronoiNeighborGraph<double, Dimension>&,
+                   const std::vector<double>& points, std::vector<std::vector<std::size_t> >& neighborIds)
+{
+  SmartNeighbors::VoronoiNeighborSearch<double, Dimension> search(&points[0], points.size() / Dimension);
+  search.SetBounds(Bounds);
+  for(std::size_t id = 0; id < neighborIds.size(); ++id)
+    {
+    search.Query(id, neighborIds[id]);
+    }
+}
+
+// Compare the neighbors of every live point of 'graph' with those found from scratch
+// over the live points. They are numbered in the order of their ids, so that ties
+// between equally far points are broken as in the graph.
+template <unsigned int Dimension, typename TGraph>
+void CompareWithRecompute(const std::string& name, const TGraph& graph, std::vector<std::size_t> liveIds)
+{
+  std::sort(liveIds.begin(), liveIds.end());
+  std::vector<double> points;
+  for(std::size_t i = 0; i < liveIds.size(); ++i)
+    {
+    const double* p = graph.GetIndex().GetPoint(liveIds[i]);
+    points.insert(points.end(), p, p + Dimension);
+    }
+  std::vector<std::vector<std::size_t> > expected(liveIds.size());
+  FindNeighbors(graph, points, expected);
+
+  for(std::size_t i = 0; i < liveIds.size(); ++i)
+    {
+    std::vector<std::size_t> expectedIds(expected[i].size());
+    for(std::size_t j = 0; j < expected[i].size(); ++j)
+      {
+      expectedIds[j] = liveIds[expected[i][j]];
+      }
+    std::vector<std::size_t> neighborIds = graph.GetNeighbors(liveIds[i]);
+    std::sort(expectedIds.begin(), expectedIds.end());
+    std::sort(neighborIds.begin(), neighborIds.end());
+    if(neighborIds != expectedIds)
+      {
+      Fail(name, "uniform", liveIds[i]);
+      }
+    }
+}
+
+// Make 'numberOfChanges' random insertions and removals, more insertions than removals
+// so that the graph grows, and compare it with a recompute every 500 changes
+template <unsigned int Dimension, typename TGraph>
+void CheckGraph(const std::string& name, TGraph& graph, unsigned int numberOfChanges)
+{
+  Random random(11);
+  std::vector<std::size_t> liveIds;
+  for(unsigned int change = 1; change <= numberOfChanges; ++change)
+    {
+    if(liveIds.size() < 5 || random.Uniform() < 0.6)
+      {
+      double p[Dimension];
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        p[d] = random.Uniform();
+        }
+      liveIds.push_back(graph.Insert(p));
+      }
+    else
+      {
+      const std::size_t i = std::min(static_cast<std::size_t>(random.Uniform() * liveIds.size()), liveIds.size() - 1);
+      graph.Remove(liveIds[i]);
+      liveIds.erase(liveIds.begin() + i);
+      }
+    if(change % 500 == 0)
+      {
+      CompareWithRecompute<Dimension>(name, graph, liveIds);
+      }
+    }
+}
+}
+
+int main(int, char *[])
+{
+  SmartNeighbors::DynamicBSPNeighborGraph<double, 2> bsp2D(0.05, K);
+  CheckGraph<2>("The repaired 2D BSP graph", bsp2D, 3000);
+  SmartNeighbors::DynamicBSPNeighborGraph<double, 3> bsp3D(0.1, K);
+  CheckGraph<3>("The repaired 3D BSP graph", bsp3D, 3000);
+  SmartNeighbors::DynamicVoronoiNeighborGraph<double, 2> voronoi2D(0.05, Bounds);
+  CheckGraph<2>("The repaired 2D Voronoi graph", voronoi2D, 3000);
+  // Every change recomputes a few dozen 3D cells, so there are fewer changes
+  SmartNeighbors::DynamicVoronoiNeighborGraph<double, 3> voronoi3D(0.1, Bounds);
+  CheckGraph<3>("The repaired 3D Voronoi graph", voronoi3D, 1000);
+  return ReportFailures();
+}
@@ -0,0 +1,472 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef DYNAMICPOINTINDEX_H
+#define DYNAMICPOINTINDEX_H
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <vector>
+
+// Custom
+#include "PointIndex.h"
+
+namespace SmartNeighbors
+{
+
+// A spatial index that points can be inserted into and removed from, for streams of
+// points that arrive and expire. The points are hashed into cubic cells of a fixed
+// size, which should hold a few points each at the expected density, and only the
+// occupied cells are stored. Inserting or removing a point touches one cell. A search
+// walks rings of cells around the query until the cells it would walk outnumber the
+// occupied ones, and then visits the remaining occupied cells instead, so a few far
+// outliers do not make it walk the empty cells between them and the rest.
+//
+// The index owns a copy of the points. A point keeps its id until it is removed,
+// and the ids of removed points are reused by later insertions. GetNumberOfPoints()
+// is the number of ids in use or free, searches never return a removed point.
+template <typename TScalar, unsigned int Dimension>
+class DynamicPointIndex : public PointIndex<TScalar, Dimension>
+{
+public:
+  typedef PointIndex<TScalar, Dimension> Superclass;
+  typedef typename Superclass::NeighborType NeighborType;
+
+  // The integer coordinates of a cell
+  struct CellKey
+  {
+    long Index[Dimension];
+
+    bool operator<(const CellKey& other) const
+    {
+      return std::lexicographical_compare(this->Index, this->Index + Dimension, other.Index, other.Index + Dimension);
+    }
+  };
+
+  explicit DynamicPointIndex(double cellSize)
+    : Superclass(0, 0, Dimension), CellSize(cellSize), NumberOfLivePoints(0)
+  {
+    if(!(cellSize > 0))
+      {
+      this->CellSize = 1;
+      }
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      this->LowerCell[d] = 0;
+      this->UpperCell[d] = -1;
+      }
+  }
+
+  std::size_t Insert(const TScalar* p)
+  {
+    std::size_t id;
+    if(this->FreeIds.empty())
+      {
+      id = this->Alive.size();
+      this->Alive.push_back(true);
+      this->Coordinates.insert(this->Coordinates.end(), p, p + Dimension);
+      this->Points = &this->Coordinates[0];
+      this->NumberOfPoints = this->Alive.size();
+      }
+    else
+      {
+      id = this->FreeIds.back();
+      this->FreeIds.pop_back();
+      this->Alive[id] = true;
+      std::copy(p, p + Dimension, &this->Coordinates[id * Dimension]);
+      }
+
+    CellKey key = this->GetCellKey(p);
+    std::vector<std::size_t>& ids = this->Cells[key];
+    if(ids.empty())
+      {
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        this->AxisCells[d][key.Index[d]]++;
+        }
+      this->UpdateExtent();
+      }
+    ids.push_back(id);
+    this->NumberOfLivePoints++;
+    return id;
+  }
+
+  void Remove(std::size_t id)
+  {
+    if(!this->Contains(id))
+      {
+      return;
+      }
+    const CellKey key = this->GetCellKey(this->GetPoint(id));
+    typename CellMap::iterator cell = this->Cells.find(key);
+    std::vector<std::size_t>& ids = cell->second;
+    ids.erase(std::find(ids.begin(), ids.end(), id));
+    if(ids.empty())
+      {
+      this->Cells.erase(cell);
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        std::map<long, std::size_t>::iterator count = this->AxisCells[d].find(key.Index[d]);
+        if(--count->second == 0)
+          {
+          this->AxisCells[d].erase(count);
+          }
+        }
+      this->UpdateExtent();
+      }
+    this->Alive[id] = false;
+    this->FreeIds.push_back(id);
+    this->NumberOfLivePoints--;
+  }
+
+  bool Contains(std::size_t id) const
+  {
+    return id < this->Alive.size() && this->Alive[id];
+  }
+
+  std::size_t GetNumberOfLivePoints() const
+  {
+    return this->NumberOfLivePoints;
+  }
+
+  double GetCellSize() const
+  {
+    return this->CellSize;
+  }
+
+  CellKey GetCellKey(const TScalar* p) const
+  {
+    CellKey key;
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      key.Index[d] = static_cast<long>(std::floor(p[d] / this->CellSize));
+      }
+    return key;
+  }
+
+  void FindKNearest(const TScalar* query, unsigned int k, std::vector<NeighborType>& nearest,
+                    std::size_t excludeId = Superclass::NoId) const
+  {
+    nearest.clear();
+    if(k == 0 || this->NumberOfLivePoints == 0)
+      {
+      return;
+      }
+    nearest.reserve(k);
+
+    Search search = {query, excludeId, &nearest, k, 0, 0};
+    CellKey center = this->GetCellKey(query);
+    for(unsigned int ring = 0; ; ++ring)
+      {
+      if(this->IsRingWalkTooLong(center, ring))
+        {
+        this->SearchOccupiedCells(center, ring, search);
+        break;
+        }
+      CellKey cell;
+      this->SearchRing(center, ring, 0, false, cell, search);
+
+      // A point exactly at the bound could still win a tie on its id
+      const double bound = this->GetSearchedDistance(center, ring, query);
+      const double distance2 = nearest.size() == k ? nearest.front().Distance2 : HUGE_VAL;
+      if(bound == HUGE_VAL || (bound > 0 && distance2 * (1 + 16 * std::numeric_limits<TScalar>::epsilon()) < bound * bound))
+        {
+        break;
+        }
+      }
+    std::sort_heap(nearest.begin(), nearest.end());
+  }
+
+  void FindInRadius(const TScalar* query, TScalar radius, std::size_t maxCount, std::vector<NeighborType>& neighbors,
+                    std::size_t excludeId = Superclass::NoId) const
+  {
+    neighbors.clear();
+    if(this->NumberOfLivePoints == 0 || !(radius >= 0))
+      {
+      return;
+      }
+
+    Search search = {query, excludeId, &neighbors, 0, radius * radius, maxCount};
+    CellKey center = this->GetCellKey(query);
+    for(unsigned int ring = 0; ; ++ring)
+      {
+      if(this->IsRingWalkTooLong(center, ring))
+        {
+        this->SearchOccupiedCells(center, ring, search);
+        break;
+        }
+      CellKey cell;
+      if(!this->SearchRing(center, ring, 0, false, cell, search))
+        {
+        break;
+        }
+      const double bound = this->GetSearchedDistance(center, ring, query);
+      if(bound == HUGE_VAL || bound > radius)
+        {
+        break;
+        }
+      }
+    std::sort(neighbors.begin(), neighbors.end());
+  }
+
+  // The maps are estimated at a value and four pointers per node, the usual
+  // layout of a red-black tree
+  std::size_t GetMemorySize() const
+  {
+    const std::size_t NodeSize = 4 * sizeof(void*);
+    std::size_t size = this->Coordinates.capacity() * sizeof(TScalar) + this->Alive.capacity() / 8 +
+                       this->FreeIds.capacity() * sizeof(std::size_t) +
+                       this->Cells.size() * (NodeSize + sizeof(typename CellMap::value_type));
+    for(typename CellMap::const_iterator cell = this->Cells.begin(); cell != this->Cells.end(); ++cell)
+      {
+      size += cell->second.capacity() * sizeof(std::size_t);
+      }
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      size += this->AxisCells[d].size() * (NodeSize + sizeof(std::pair<const long, std::size_t>));
+      }
+    return size;
+  }
+
+private:
+  typedef std::map<CellKey, std::vector<std::size_t> > CellMap;
+
+  // See UniformGrid::Search
+  struct Search
+  {
+    const TScalar* Query;
+    std::size_t ExcludeId;
+    std::vector<NeighborType>* Neighbors;
+    unsigned int K;
+    TScalar Radius2;
+    std::size_t MaxCount;
+  };
+
+  void UpdateExtent()
+  {
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      if(this->AxisCells[d].empty())
+        {
+        this->LowerCell[d] = 0;
+        this->UpperCell[d] = -1;
+        }
+      else
+        {
+        this->LowerCell[d] = this->AxisCells[d].begin()->first;
+        this->UpperCell[d] = this->AxisCells[d].rbegin()->first;
+        }
+      }
+  }
+
+  // Whether walking the rings up to 'ring' visits more cells of the occupied extent
+  // than there are occupied cells, or takes more rings than that
+  bool IsRingWalkTooLong(const CellKey& center, unsigned int ring) const
+  {
+    const double numberOfCells = static_cast<double>(this->Cells.size());
+    if(ring > numberOfCells)
+      {
+      return true;
+      }
+    double volume = 1;
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      const long lower = std::max(center.Index[d] - static_cast<long>(ring), this->LowerCell[d]);
+      const long upper = std::min(center.Index[d] + static_cast<long>(ring), this->UpperCell[d]);
+      volume *= static_cast<double>(std::max(upper - lower + 1, 1L));
+      }
+    return volume > numberOfCells;
+  }
+
+  // Search the occupied cells that are at least 'ring' cells from 'center', which
+  // the walk of the rings before it has not visited
+  void SearchOccupiedCells(const CellKey& center, unsigned int ring, Search& search) const
+  {
+    for(typename CellMap::const_iterator cell = this->Cells.begin(); cell != this->Cells.end(); ++cell)
+      {
+      long distance = 0;
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        distance = std::max(distance, std::labs(cell->first.Index[d] - center.Index[d]));
+        }
+      if(distance >= static_cast<long>(ring) && !this->IsCellTooFar(cell->first, search) &&
+         !this->SearchIds(cell->second, search))
+        {
+        return;
+        }
+      }
+  }
+
+  // A lower bound of the distance from the query to every cell that is more than
+  // 'ring' cells from 'center' and inside the occupied extent, see
+  // UniformGrid::GetSearchedDistance(). The rounding of the cell of each point is
+  // allowed for at the scale of the coordinates.
+  double GetSearchedDistance(const CellKey& center, unsigned int ring, const TScalar* query) const
+  {
+    const double tolerance = 8 * std::numeric_limits<double>::epsilon();
+    double bound = HUGE_VAL;
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      if(center.Index[d] - static_cast<long>(ring) > this->LowerCell[d])
+        {
+        const double face = (center.Index[d] - static_cast<long>(ring)) * this->CellSize;
+        bound = std::min(bound, query[d] - face - tolerance * std::max(std::fabs(face), std::fabs(double(query[d]))));
+        }
+      if(center.Index[d] + static_cast<long>(ring) < this->UpperCell[d])
+        {
+        const double face = (center.Index[d] + static_cast<long>(ring) + 1) * this->CellSize;
+        bound = std::min(bound, face - query[d] - tolerance * std::max(std::fabs(face), std::fabs(double(query[d]))));
+        }
+      }
+    return bound;
+  }
+
+  // See UniformGrid::SearchRing(), restricted to the occupied extent
+  bool SearchRing(const CellKey& center, unsigned int ring, unsigned int axis, bool onRing, CellKey& cell,
+                  Search& search) const
+  {
+    const long lower = std::max(center.Index[axis] - static_cast<long>(ring), this->LowerCell[axis]);
+    const long upper = std::min(center.Index[axis] + static_cast<long>(ring), this->UpperCell[axis]);
+    if(axis + 1 < Dimension)
+      {
+      for(cell.Index[axis] = lower; cell.Index[axis] <= upper; ++cell.Index[axis])
+        {
+        const bool atEnd = cell.Index[axis] == center.Index[axis] - static_cast<long>(ring) ||
+                           cell.Index[axis] == center.Index[axis] + static_cast<long>(ring);
+        if(!this->SearchRing(center, ring, axis + 1, onRing || atEnd, cell, search))
+          {
+          return false;
+          }
+        }
+      return true;
+      }
+
+    if(onRing)
+      {
+      for(cell.Index[axis] = lower; cell.Index[axis] <= upper; ++cell.Index[axis])
+        {
+        if(!this->SearchCell(cell, search))
+          {
+          return false;
+          }
+        }
+      return true;
+      }
+    cell.Index[axis] = center.Index[axis] - static_cast<long>(ring);
+    if(cell.Index[axis] >= lower && !this->SearchCell(cell, search))
+      {
+      return false;
+      }
+    cell.Index[axis] = center.Index[axis] + static_cast<long>(ring);
+    if(ring > 0 && cell.Index[axis] <= upper)
+      {
+      return this->SearchCell(cell, search);
+      }
+    return true;
+  }
+
+  bool SearchCell(const CellKey& cell, Search& search) const
+  {
+    // Skip cells that are strictly farther than the kth candidate so far, or than
+    // the radius, before looking them up
+    if(this->IsCellTooFar(cell, search))
+      {
+      return true;
+      }
+    typename CellMap::const_iterator found = this->Cells.find(cell);
+    if(found == this->Cells.end())
+      {
+      return true;
+      }
+    return this->SearchIds(found->second, search);
+  }
+
+  bool IsCellTooFar(const CellKey& cell, const Search& search) const
+  {
+    const double tolerance = 8 * std::numeric_limits<double>::epsilon();
+    double cellDistance2 = 0;
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      const double lower = cell.Index[d] * this->CellSize;
+      const double upper = lower + this->CellSize;
+      const double slack = tolerance * std::max(std::fabs(lower), std::fabs(upper));
+      const double gap = std::max(lower - search.Query[d], search.Query[d] - upper) - slack;
+      if(gap > 0)
+        {
+        cellDistance2 += gap * gap;
+        }
+      }
+    const std::vector<NeighborType>& neighbors = *search.Neighbors;
+    const double distanceTolerance = 1 + 16 * std::numeric_limits<TScalar>::epsilon();
+    if(search.K > 0)
+      {
+      return neighbors.size() == search.K && neighbors.front().Distance2 * distanceTolerance < cellDistance2;
+      }
+    return search.Radius2 * distanceTolerance < cellDistance2;
+  }
+
+  // Returns false once a radius search has found its maximum count
+  bool SearchIds(const std::vector<std::size_t>& ids, Search& search) const
+  {
+    std::vector<NeighborType>& neighbors = *search.Neighbors;
+    for(std::size_t i = 0; i < ids.size(); ++i)
+      {
+      const std::size_t id = ids[i];
+      if(id == search.ExcludeId)
+        {
+        continue;
+        }
+      NeighborType candidate = {id, Distance2<TScalar, Dimension>(this->GetPoint(id), search.Query)};
+      if(search.K > 0)
+        {
+        InsertNeighbor(neighbors, search.K, candidate);
+        }
+      else if(candidate.Distance2 <= search.Radius2)
+        {
+        neighbors.push_back(candidate);
+        if(neighbors.size() == search.MaxCount)
+          {
+          return false;
+          }
+        }
+      }
+    return true;
+  }
+
+  double CellSize;
+  std::size_t NumberOfLivePoints;
+  std::vector<TScalar> Coordinates;
+  std::vector<bool> Alive;
+  std::vector<std::size_t> FreeIds;
+  CellMap Cells;
+
+  // The number of occupied cells at each index along each axis, and the range of
+  // the indices of the occupied cells
+  std::map<long, std::size_t> AxisCells[Dimension];
+  long LowerCell[Dimension];
+  long UpperCell[Dimension];
+};
+
+} // end namespace SmartNeighbors
+
+#endif
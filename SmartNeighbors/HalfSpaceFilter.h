@@ -0,0 +1,330 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef HALFSPACEFILTER_H
+#define HALFSPACEFILTER_H
+
+// The halfspace test of the BSP neighbor algorithm. Each candidate q_i defines the halfspace
+// (x-q_i).(p-q_i) >= 0
+// where p is the center point, and a candidate is a BSP neighbor if it lies in the
+// halfspaces of all of the candidates.
+//
+// The candidates are stored as separate x, y and z arrays so that one candidate can
+// be tested against several halfspaces at once with AVX-512, AVX or SSE2, whichever
+// the compiler targets. Each lane computes exactly the same products and sums in the
+// same order as the scalar test, and no fused multiply-add is used, so the result is
+// bit for bit the same as the scalar code. Common candidate counts have fixed size
+// versions that keep everything on the stack.
+//
+// The test runs on float or double coordinates, in the precision of the input. Float
+// coordinates fit twice as many lanes in a register and take half the memory traffic.
+// The two agree except on near-degenerate ties, where a candidate lies within float
+// rounding of the boundary of another's halfspace, as for points that are cocircular
+// or cospherical with the center. Such a candidate may be kept in one precision and
+// rejected in the other.
+
+// STL
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace SmartNeighbors
+{
+
+namespace HalfSpaceFilterDetail
+{
+
+// The reference test that every vector version must agree with bit for bit
+template <typename TScalar>
+inline bool ScalarInAllHalfSpaces(TScalar ax, TScalar ay, TScalar az,
+                                  const TScalar* hx, const TScalar* hy, const TScalar* hz,
+                                  const TScalar* bx, const TScalar* by, const TScalar* bz,
+                                  unsigned int paddedCount)
+{
+  for(unsigned int i = 0; i < paddedCount; ++i)
+    {
+    TScalar dot = (ax - hx[i]) * bx[i];
+    dot = dot + (ay - hy[i]) * by[i];
+    dot = dot + (az - hz[i]) * bz[i];
+    if(!(dot >= 0))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+// The vector test for each scalar type. InAllHalfSpaces is true if the point
+// (ax, ay, az) is in all 'paddedCount' halfspaces given by the points h and the
+// vectors b = p - h. The padding halfspaces have h = b = 0, which every finite
+// point is in.
+template <typename TScalar>
+struct SIMD;
+
+template <>
+struct SIMD<double>
+{
+#if defined(__AVX512F__)
+  static const unsigned int Width = 8;
+#elif defined(__AVX__)
+  static const unsigned int Width = 4;
+#elif defined(__SSE2__) || defined(_M_X64)
+  static const unsigned int Width = 2;
+#else
+  static const unsigned int Width = 1;
+#endif
+
+  static bool InAllHalfSpaces(double ax, double ay, double az,
+                              const double* hx, const double* hy, const double* hz,
+                              const double* bx, const double* by, const double* bz,
+                              unsigned int paddedCount)
+  {
+#if defined(__AVX512F__)
+    const __m512d x = _mm512_set1_pd(ax);
+    const __m512d y = _mm512_set1_pd(ay);
+    const __m512d z = _mm512_set1_pd(az);
+    const __m512d zero = _mm512_setzero_pd();
+    for(unsigned int i = 0; i < paddedCount; i += Width)
+      {
+      __m512d dot = _mm512_mul_pd(_mm512_sub_pd(x, _mm512_loadu_pd(hx + i)), _mm512_loadu_pd(bx + i));
+      dot = _mm512_add_pd(dot, _mm512_mul_pd(_mm512_sub_pd(y, _mm512_loadu_pd(hy + i)), _mm512_loadu_pd(by + i)));
+      dot = _mm512_add_pd(dot, _mm512_mul_pd(_mm512_sub_pd(z, _mm512_loadu_pd(hz + i)), _mm512_loadu_pd(bz + i)));
+      // Ordered comparison, so a NaN fails the test just like !(dot >= 0) does
+      if(_mm512_cmp_pd_mask(dot, zero, _CMP_GE_OQ) != 0xFF)
+        {
+        return false;
+        }
+      }
+    return true;
+#elif defined(__AVX__)
+    const __m256d x = _mm256_set1_pd(ax);
+    const __m256d y = _mm256_set1_pd(ay);
+    const __m256d z = _mm256_set1_pd(az);
+    const __m256d zero = _mm256_setzero_pd();
+    for(unsigned int i = 0; i < paddedCount; i += Width)
+      {
+      __m256d dot = _mm256_mul_pd(_mm256_sub_pd(x, _mm256_loadu_pd(hx + i)), _mm256_loadu_pd(bx + i));
+      dot = _mm256_add_pd(dot, _mm256_mul_pd(_mm256_sub_pd(y, _mm256_loadu_pd(hy + i)), _mm256_loadu_pd(by + i)));
+      dot = _mm256_add_pd(dot, _mm256_mul_pd(_mm256_sub_pd(z, _mm256_loadu_pd(hz + i)), _mm256_loadu_pd(bz + i)));
+      if(_mm256_movemask_pd(_mm256_cmp_pd(dot, zero, _CMP_GE_OQ)) != 0xF)
+        {
+        return false;
+        }
+      }
+    return true;
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128d x = _mm_set1_pd(ax);
+    const __m128d y = _mm_set1_pd(ay);
+    const __m128d z = _mm_set1_pd(az);
+    const __m128d zero = _mm_setzero_pd();
+    for(unsigned int i = 0; i < paddedCount; i += Width)
+      {
+      __m128d dot = _mm_mul_pd(_mm_sub_pd(x, _mm_loadu_pd(hx + i)), _mm_loadu_pd(bx + i));
+      dot = _mm_add_pd(dot, _mm_mul_pd(_mm_sub_pd(y, _mm_loadu_pd(hy + i)), _mm_loadu_pd(by + i)));
+      dot = _mm_add_pd(dot, _mm_mul_pd(_mm_sub_pd(z, _mm_loadu_pd(hz + i)), _mm_loadu_pd(bz + i)));
+      if(_mm_movemask_pd(_mm_cmpge_pd(dot, zero)) != 0x3)
+        {
+        return false;
+        }
+      }
+    return true;
+#else
+    return ScalarInAllHalfSpaces(ax, ay, az, hx, hy, hz, bx, by, bz, paddedCount);
+#endif
+  }
+};
+
+template <>
+struct SIMD<float>
+{
+#if defined(__AVX512F__)
+  static const unsigned int Width = 16;
+#elif defined(__AVX__)
+  static const unsigned int Width = 8;
+#elif defined(__SSE2__) || defined(_M_X64)
+  static const unsigned int Width = 4;
+#else
+  static const unsigned int Width = 1;
+#endif
+
+  static bool InAllHalfSpaces(float ax, float ay, float az,
+                              const float* hx, const float* hy, const float* hz,
+                              const float* bx, const float* by, const float* bz,
+                              unsigned int paddedCount)
+  {
+#if defined(__AVX512F__)
+    const __m512 x = _mm512_set1_ps(ax);
+    const __m512 y = _mm512_set1_ps(ay);
+    const __m512 z = _mm512_set1_ps(az);
+    const __m512 zero = _mm512_setzero_ps();
+    for(unsigned int i = 0; i < paddedCount; i += Width)
+      {
+      __m512 dot = _mm512_mul_ps(_mm512_sub_ps(x, _mm512_loadu_ps(hx + i)), _mm512_loadu_ps(bx + i));
+      dot = _mm512_add_ps(dot, _mm512_mul_ps(_mm512_sub_ps(y, _mm512_loadu_ps(hy + i)), _mm512_loadu_ps(by + i)));
+      dot = _mm512_add_ps(dot, _mm512_mul_ps(_mm512_sub_ps(z, _mm512_loadu_ps(hz + i)), _mm512_loadu_ps(bz + i)));
+      if(_mm512_cmp_ps_mask(dot, zero, _CMP_GE_OQ) != 0xFFFF)
+        {
+        return false;
+        }
+      }
+    return true;
+#elif defined(__AVX__)
+    const __m256 x = _mm256_set1_ps(ax);
+    const __m256 y = _mm256_set1_ps(ay);
+    const __m256 z = _mm256_set1_ps(az);
+    const __m256 zero = _mm256_setzero_ps();
+    for(unsigned int i = 0; i < paddedCount; i += Width)
+      {
+      __m256 dot = _mm256_mul_ps(_mm256_sub_ps(x, _mm256_loadu_ps(hx + i)), _mm256_loadu_ps(bx + i));
+      dot = _mm256_add_ps(dot, _mm256_mul_ps(_mm256_sub_ps(y, _mm256_loadu_ps(hy + i)), _mm256_loadu_ps(by + i)));
+      dot = _mm256_add_ps(dot, _mm256_mul_ps(_mm256_sub_ps(z, _mm256_loadu_ps(hz + i)), _mm256_loadu_ps(bz + i)));
+      if(_mm256_movemask_ps(_mm256_cmp_ps(dot, zero, _CMP_GE_OQ)) != 0xFF)
+        {
+        return false;
+        }
+      }
+    return true;
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128 x = _mm_set1_ps(ax);
+    const __m128 y = _mm_set1_ps(ay);
+    const __m128 z = _mm_set1_ps(az);
+    const __m128 zero = _mm_setzero_ps();
+    for(unsigned int i = 0; i < paddedCount; i += Width)
+      {
+      __m128 dot = _mm_mul_ps(_mm_sub_ps(x, _mm_loadu_ps(hx + i)), _mm_loadu_ps(bx + i));
+      dot = _mm_add_ps(dot, _mm_mul_ps(_mm_sub_ps(y, _mm_loadu_ps(hy + i)), _mm_loadu_ps(by + i)));
+      dot = _mm_add_ps(dot, _mm_mul_ps(_mm_sub_ps(z, _mm_loadu_ps(hz + i)), _mm_loadu_ps(bz + i)));
+      if(_mm_movemask_ps(_mm_cmpge_ps(dot, zero)) != 0xF)
+        {
+        return false;
+        }
+      }
+    return true;
+#else
+    return ScalarInAllHalfSpaces(ax, ay, az, hx, hy, hz, bx, by, bz, paddedCount);
+#endif
+  }
+};
+
+// Round 'count' up to a whole number of SIMD registers
+template <typename TScalar>
+inline unsigned int PaddedCount(unsigned int count)
+{
+  return (count + SIMD<TScalar>::Width - 1) / SIMD<TScalar>::Width * SIMD<TScalar>::Width;
+}
+
+// Split the interleaved candidates into the SoA arrays used by InAllHalfSpaces
+// and pad them with halfspaces that never reject anything
+template <typename TScalar>
+inline void Deinterleave(const TScalar center[3], const TScalar* candidates, unsigned int numberOfCandidates,
+                         unsigned int paddedCount, TScalar* hx, TScalar* hy, TScalar* hz,
+                         TScalar* bx, TScalar* by, TScalar* bz)
+{
+  for(unsigned int i = 0; i < numberOfCandidates; ++i)
+    {
+    hx[i] = candidates[3*i];
+    hy[i] = candidates[3*i + 1];
+    hz[i] = candidates[3*i + 2];
+    bx[i] = center[0] - hx[i];
+    by[i] = center[1] - hy[i];
+    bz[i] = center[2] - hz[i];
+    }
+  for(unsigned int i = numberOfCandidates; i < paddedCount; ++i)
+    {
+    hx[i] = hy[i] = hz[i] = 0;
+    bx[i] = by[i] = bz[i] = 0;
+    }
+}
+
+template <typename TScalar>
+inline unsigned int FilterDeinterleaved(unsigned int numberOfCandidates, unsigned int paddedCount,
+                                        const TScalar* hx, const TScalar* hy, const TScalar* hz,
+                                        const TScalar* bx, const TScalar* by, const TScalar* bz,
+                                        unsigned int* kept)
+{
+  unsigned int numberOfKept = 0;
+  for(unsigned int i = 0; i < numberOfCandidates; ++i)
+    {
+    if(SIMD<TScalar>::InAllHalfSpaces(hx[i], hy[i], hz[i], hx, hy, hz, bx, by, bz, paddedCount))
+      {
+      kept[numberOfKept++] = i;
+      }
+    }
+  return numberOfKept;
+}
+
+} // end namespace HalfSpaceFilterDetail
+
+// Filter exactly K candidates. The fixed size lets the scratch arrays live on the
+// stack and the loops be unrolled.
+template <typename TScalar, unsigned int K>
+struct FixedHalfSpaceFilter
+{
+  static unsigned int Filter(const TScalar center[3], const TScalar* candidates, unsigned int* kept)
+  {
+    using namespace HalfSpaceFilterDetail;
+    const unsigned int paddedCount = (K + SIMD<TScalar>::Width - 1) / SIMD<TScalar>::Width * SIMD<TScalar>::Width;
+    TScalar hx[paddedCount], hy[paddedCount], hz[paddedCount];
+    TScalar bx[paddedCount], by[paddedCount], bz[paddedCount];
+    Deinterleave(center, candidates, K, paddedCount, hx, hy, hz, bx, by, bz);
+    return FilterDeinterleaved(K, paddedCount, hx, hy, hz, bx, by, bz, kept);
+  }
+};
+
+// 'candidates' holds the interleaved xyz coordinates of 'numberOfCandidates' points.
+// The indices of the candidates that are BSP neighbors of 'center' are written to 'kept',
+// which must have room for all of the candidates, and the number of them is returned.
+// TScalar is float or double.
+template <typename TScalar>
+inline unsigned int FilterHalfSpaces(const TScalar center[3], const TScalar* candidates,
+                                     unsigned int numberOfCandidates, unsigned int* kept)
+{
+  switch(numberOfCandidates)
+    {
+    case 8:
+      return FixedHalfSpaceFilter<TScalar, 8>::Filter(center, candidates, kept);
+    case 16:
+      return FixedHalfSpaceFilter<TScalar, 16>::Filter(center, candidates, kept);
+    case 32:
+      return FixedHalfSpaceFilter<TScalar, 32>::Filter(center, candidates, kept);
+    case 64:
+      return FixedHalfSpaceFilter<TScalar, 64>::Filter(center, candidates, kept);
+    default:
+      break;
+    }
+
+  using namespace HalfSpaceFilterDetail;
+  const unsigned int paddedCount = PaddedCount<TScalar>(numberOfCandidates);
+  std::vector<TScalar> scratch(6 * paddedCount);
+  TScalar* hx = scratch.empty() ? 0 : &scratch[0];
+  TScalar* hy = hx + paddedCount;
+  TScalar* hz = hy + paddedCount;
+  TScalar* bx = hz + paddedCount;
+  TScalar* by = bx + paddedCount;
+  TScalar* bz = by + paddedCount;
+  Deinterleave(center, candidates, numberOfCandidates, paddedCount, hx, hy, hz, bx, by, bz);
+  return FilterDeinterleaved(numberOfCandidates, paddedCount, hx, hy, hz, bx, by, bz, kept);
+}
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,91 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Checks that the vector halfspace filter keeps exactly the candidates that the
+// scalar test keeps, in float and in double, for counts on both sides of every
+// vector width. Run by ctest, it prints each mismatch and fails if there are any.
+
+// STL
+#include <string>
+#include <vector>
+
+// Custom
+#include "HalfSpaceFilter.h"
+#include "TestUtilities.h"
+
+namespace
+{
+// Every point of the cloud in turn as the center, the others as the candidates
+template <typename TScalar>
+void CheckHalfSpaceFilter(const std::string& distribution, const std::vector<double>& cloud)
+{
+  const unsigned int Counts[] = {1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100};
+  const unsigned int NumberOfCounts = sizeof(Counts) / sizeof(Counts[0]);
+  std::vector<TScalar> points(cloud.begin(), cloud.end());
+
+  std::vector<unsigned int> kept(101);
+  std::vector<TScalar> h[3];
+  std::vector<TScalar> b[3];
+  for(std::size_t start = 0; start + 102 < points.size() / 3; start += 101)
+    {
+    const unsigned int count = Counts[(start / 101) % NumberOfCounts];
+    const TScalar* center = &points[3 * start];
+    const TScalar* candidates = center + 3;
+    const unsigned int numberOfKept = SmartNeighbors::FilterHalfSpaces(center, candidates, count, &kept[0]);
+
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      h[d].resize(count);
+      b[d].resize(count);
+      for(unsigned int i = 0; i < count; ++i)
+        {
+        h[d][i] = candidates[3 * i + d];
+        b[d][i] = center[d] - h[d][i];
+        }
+      }
+    unsigned int expected = 0;
+    bool same = true;
+    for(unsigned int i = 0; i < count; ++i)
+      {
+      if(SmartNeighbors::HalfSpaceFilterDetail::ScalarInAllHalfSpaces(h[0][i], h[1][i], h[2][i], &h[0][0], &h[1][0],
+                                                                      &h[2][0], &b[0][0], &b[1][0], &b[2][0], count))
+        {
+        same = same && expected < numberOfKept && kept[expected] == i;
+        expected++;
+        }
+      }
+    if(!same || expected != numberOfKept)
+      {
+      Fail(sizeof(TScalar) == 4 ? "The float halfspace filter" : "The double halfspace filter", distribution, start);
+      }
+    }
+}
+}
+
+int main(int, char *[])
+{
+  const char* distributions[] = {"uniform", "plane", "lattice"};
+  for(unsigned int i = 0; i < 3; ++i)
+    {
+    std::vector<double> points;
+    GenerateCloud(distributions[i], 20000, points);
+    CheckHalfSpaceFilter<float>(distributions[i], points);
+    CheckHalfSpaceFilter<double>(distributions[i], points);
+    }
+  return ReportFailures();
+}
@@ -0,0 +1,131 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Checks that every index returns exactly the neighbors of the kd-tree: the grid,
+// both indexes over points stored in Morton order and the dynamic index. The plane
+// has a single grid cell across and the lattice many equal distances. Run by
+// ctest, it prints each mismatch and fails if there are any.
+
+// STL
+#include <string>
+#include <vector>
+
+// Custom
+#include "BSPNeighborSearch.h"
+#include "DynamicPointIndex.h"
+#include "KdTree.h"
+#include "ReorderedPointIndex.h"
+#include "TestUtilities.h"
+#include "UniformGrid.h"
+
+namespace
+{
+// The k nearest points, the points in a radius and the BSP neighbors from each index
+void CheckIndexes(const std::string& distribution, const std::vector<double>& points)
+{
+  typedef SmartNeighbors::PointIndex<double, 3> IndexType;
+  typedef IndexType::NeighborType NeighborType;
+  const std::size_t numberOfPoints = points.size() / 3;
+  const unsigned int K = 12;
+
+  // About 4 points per cell, with an outlier added and removed again so that the
+  // occupied extent has to shrink back
+  const double cellSize = distribution == "lattice" ? 3.0 : 0.03;
+  SmartNeighbors::DynamicPointIndex<double, 3> dynamic(cellSize);
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    dynamic.Insert(&points[3 * id]);
+    }
+  const double outlier[3] = {1000, -1000, 1000};
+  dynamic.Remove(dynamic.Insert(outlier));
+
+  std::vector<const IndexType*> indexes;
+  std::vector<std::string> names;
+  indexes.push_back(new SmartNeighbors::KdTree<double, 3>(&points[0], numberOfPoints));
+  names.push_back("The kd-tree");
+  indexes.push_back(new SmartNeighbors::UniformGrid<double, 3>(&points[0], numberOfPoints));
+  names.push_back("The grid");
+  indexes.push_back(new SmartNeighbors::ReorderedPointIndex<double, 3>(&points[0], numberOfPoints, 3,
+                                                                      SmartNeighbors::KdTreeIndex));
+  names.push_back("The reordered kd-tree");
+  indexes.push_back(new SmartNeighbors::ReorderedPointIndex<double, 3>(&points[0], numberOfPoints, 3,
+                                                                      SmartNeighbors::UniformGridIndex));
+  names.push_back("The reordered grid");
+  indexes.push_back(&dynamic);
+  names.push_back("The dynamic index");
+
+  std::vector<SmartNeighbors::BSPNeighborSearch<double, 3>*> searches;
+  for(std::size_t i = 0; i < indexes.size(); ++i)
+    {
+    searches.push_back(new SmartNeighbors::BSPNeighborSearch<double, 3>(indexes[i]));
+    }
+
+  const double radius = distribution == "lattice" ? 2.0 : 0.05;
+  std::vector<NeighborType> expectedNearest;
+  std::vector<NeighborType> expectedInRadius;
+  std::vector<std::size_t> expectedNeighbors;
+  std::vector<NeighborType> found;
+  std::vector<std::size_t> neighbors;
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    const double* p = &points[3 * id];
+    indexes[0]->FindKNearest(p, K, expectedNearest, id);
+    indexes[0]->FindInRadius(p, radius, 0, expectedInRadius, id);
+    searches[0]->Query(id, K, expectedNeighbors);
+    for(std::size_t i = 1; i < indexes.size(); ++i)
+      {
+      indexes[i]->FindKNearest(p, K, found, id);
+      if(!AreSame(expectedNearest, found))
+        {
+        Fail(names[i] + " k nearest search", distribution, id);
+        }
+      indexes[i]->FindInRadius(p, radius, 0, found, id);
+      if(!AreSame(expectedInRadius, found))
+        {
+        Fail(names[i] + " radius search", distribution, id);
+        }
+      searches[i]->Query(id, K, neighbors);
+      if(neighbors != expectedNeighbors)
+        {
+        Fail(names[i] + " BSP neighbors", distribution, id);
+        }
+      }
+    }
+
+  for(std::size_t i = 0; i < indexes.size(); ++i)
+    {
+    delete searches[i];
+    if(indexes[i] != &dynamic)
+      {
+      delete indexes[i];
+      }
+    }
+}
+}
+
+int main(int, char *[])
+{
+  const char* distributions[] = {"uniform", "plane", "lattice"};
+  for(unsigned int i = 0; i < 3; ++i)
+    {
+    std::vector<double> points;
+    GenerateCloud(distributions[i], 20000, points);
+    CheckIndexes(distributions[i], points);
+    }
+  return ReportFailures();
+}
@@ -0,0 +1,599 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef KDTREE_H
+#define KDTREE_H
+
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Custom
+#include "PointIndex.h"
+
+namespace SmartNeighbors
+{
+
+// A kd-tree over points stored in a plain array, with the dimension fixed at compile
+// time. It splits at the median along the axis of largest extent, so it adapts to
+// any distribution of the points. See PointIndex.h for how the points are laid out
+// and shared.
+//
+// The tree keeps its own copy of the points in one flat array, ordered so that the
+// points of every leaf are contiguous, and its nodes in another. Nodes always split
+// at the middle, so the shape of the tree only depends on the number of points and
+// every subtree has its place in the node array before it is built. That lets the
+// construction run on 'numberOfThreads' threads (0 means use all available cores):
+// the large nodes near the root are partitioned by all of the threads together, and
+// the subtrees below them are handed out to the threads one at a time. Entries with
+// the same coordinate are ordered by id, so the tree is the same whatever the number
+// of threads.
+template <typename TScalar, unsigned int Dimension>
+class KdTree : public PointIndex<TScalar, Dimension>
+{
+public:
+  typedef PointIndex<TScalar, Dimension> Superclass;
+  typedef typename Superclass::NeighborType NeighborType;
+
+  KdTree(const TScalar* points, std::size_t numberOfPoints, unsigned int stride = Dimension, int numberOfThreads = 0)
+    : Superclass(points, numberOfPoints, stride), Entries(numberOfPoints), Nodes(CountNodes(numberOfPoints))
+  {
+#ifdef _OPENMP
+    if(numberOfThreads <= 0)
+      {
+      numberOfThreads = omp_get_max_threads();
+      }
+#else
+    numberOfThreads = 1;
+#endif
+
+    const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(numberOfPoints);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numberOfThreads) schedule(static)
+#endif
+    for(std::ptrdiff_t i = 0; i < count; ++i)
+      {
+      const TScalar* p = this->GetPoint(i);
+      std::copy(p, p + Dimension, this->Entries[i].Point);
+      this->Entries[i].Id = i;
+      }
+
+    this->BuildTree(numberOfThreads);
+  }
+
+  void FindKNearest(const TScalar* query, unsigned int k, std::vector<NeighborType>& nearest,
+                    std::size_t excludeId = Superclass::NoId) const
+  {
+    this->FindKNearestApproximate(query, k, SearchBudget(), nearest, excludeId);
+  }
+
+  void FindKNearestApproximate(const TScalar* query, unsigned int k, const SearchBudget& budget,
+                               std::vector<NeighborType>& nearest, std::size_t excludeId = Superclass::NoId) const
+  {
+    nearest.clear();
+    if(k == 0 || this->NumberOfPoints == 0)
+      {
+      return;
+      }
+    // The candidates are kept as a max heap, so the farthest one is at the front
+    nearest.reserve(k);
+    const TScalar scale = static_cast<TScalar>((1 + budget.Epsilon) * (1 + budget.Epsilon));
+    KNearestSearch search = {query, k, excludeId, &nearest, std::max(scale, TScalar(1)),
+                             budget.MaxDistanceEvaluations > 0 ? budget.MaxDistanceEvaluations : ~std::size_t(0)};
+    this->SearchKNearest(0, search);
+    std::sort_heap(nearest.begin(), nearest.end());
+  }
+
+  void FindInRadius(const TScalar* query, TScalar radius, std::size_t maxCount, std::vector<NeighborType>& neighbors,
+                    std::size_t excludeId = Superclass::NoId) const
+  {
+    neighbors.clear();
+    if(this->NumberOfPoints == 0 || !(radius >= 0))
+      {
+      return;
+      }
+    this->SearchRadius(0, query, radius * radius, maxCount, excludeId, neighbors);
+    std::sort(neighbors.begin(), neighbors.end());
+  }
+
+  std::size_t GetMemorySize() const
+  {
+    return this->Entries.capacity() * sizeof(Entry) + this->Nodes.capacity() * sizeof(Node);
+  }
+
+private:
+  static const std::size_t LeafSize = 16;
+
+  // Nodes larger than this are partitioned by all of the threads together, smaller
+  // ones are partitioned faster by one thread
+  static const std::size_t ParallelSize = 1 << 16;
+
+  // A point and its id, in the order of the leaves
+  struct Entry
+  {
+    TScalar Point[Dimension];
+    std::size_t Id;
+  };
+
+  // Leaves have no children and hold the entries [Begin, End). Inner nodes split their
+  // entries at Split along Axis, the lower half goes to Left and the upper to Right.
+  struct Node
+  {
+    std::size_t Begin;
+    std::size_t End;
+    std::size_t Left;
+    std::size_t Right;
+    unsigned int Axis;
+    TScalar Split;
+  };
+
+  // A k nearest search in progress. Subtrees are skipped if they are farther than the
+  // kth candidate over Scale, the square of 1 + epsilon, and the search stops once
+  // RemainingEvaluations runs out.
+  struct KNearestSearch
+  {
+    const TScalar* Query;
+    unsigned int K;
+    std::size_t ExcludeId;
+    std::vector<NeighborType>* Nearest;
+    TScalar Scale;
+    std::size_t RemainingEvaluations;
+  };
+
+  struct Subtree
+  {
+    std::size_t NodeId;
+    std::size_t Begin;
+    std::size_t End;
+  };
+
+  // Entries are ordered by their coordinate along Axis and then by id, so that no
+  // two compare equal and the halves of every node do not depend on how the
+  // entries were shuffled before, by one thread or by several
+  struct AxisLess
+  {
+    unsigned int Axis;
+
+    bool operator()(const Entry& a, const Entry& b) const
+    {
+      return a.Point[this->Axis] < b.Point[this->Axis] ||
+             (a.Point[this->Axis] == b.Point[this->Axis] && a.Id < b.Id);
+    }
+  };
+
+  struct AxisBelow
+  {
+    unsigned int Axis;
+    TScalar Value;
+    std::size_t Id;
+
+    bool operator()(const Entry& entry) const
+    {
+      return entry.Point[this->Axis] < this->Value || (entry.Point[this->Axis] == this->Value && entry.Id < this->Id);
+    }
+  };
+
+  struct AxisNotAbove
+  {
+    unsigned int Axis;
+    TScalar Value;
+    std::size_t Id;
+
+    bool operator()(const Entry& entry) const
+    {
+      return entry.Point[this->Axis] < this->Value || (entry.Point[this->Axis] == this->Value && entry.Id <= this->Id);
+    }
+  };
+
+  struct IdLess
+  {
+    bool operator()(const Entry& a, const Entry& b) const
+    {
+      return a.Id < b.Id;
+    }
+  };
+
+  // The number of nodes of a subtree over m points. The two halves of a node differ
+  // in size by at most one, so the sizes at each depth are two consecutive numbers
+  // and the counts of both are found from the deepest level up.
+  static std::size_t CountNodes(std::size_t m)
+  {
+    std::size_t sizes[8 * sizeof(std::size_t) + 1];
+    unsigned int depth = 0;
+    sizes[0] = m;
+    while(sizes[depth] >= LeafSize)
+      {
+      sizes[depth + 1] = sizes[depth] / 2;
+      depth++;
+      }
+
+    // The counts of subtrees of sizes[d] and sizes[d] + 1 points
+    std::size_t low = 1;
+    std::size_t high = 1;
+    while(depth-- > 0)
+      {
+      const std::size_t child = sizes[depth + 1];
+      std::size_t counts[2];
+      for(unsigned int i = 0; i < 2; ++i)
+        {
+        const std::size_t size = sizes[depth] + i;
+        const std::size_t half = size / 2;
+        counts[i] = size <= LeafSize ? 1 : 1 + (half == child ? low : high) + (size - half == child ? low : high);
+        }
+      low = counts[0];
+      high = counts[1];
+      }
+    return low;
+  }
+
+  void BuildTree(int numberOfThreads)
+  {
+    Subtree root = {0, 0, this->NumberOfPoints};
+    std::vector<Subtree> subtrees(1, root);
+
+    // Split the large subtrees with every thread at once, until there are enough of
+    // them to keep all of the threads busy
+    bool split = numberOfThreads > 1;
+    while(split && subtrees.size() < 4 * static_cast<std::size_t>(numberOfThreads))
+      {
+      split = false;
+      std::vector<Subtree> next;
+      for(std::size_t i = 0; i < subtrees.size(); ++i)
+        {
+        const Subtree& subtree = subtrees[i];
+        if(subtree.End - subtree.Begin <= ParallelSize)
+          {
+          next.push_back(subtree);
+          continue;
+          }
+        const std::size_t middle = this->SplitNode(subtree.NodeId, subtree.Begin, subtree.End, numberOfThreads);
+        const Node& node = this->Nodes[subtree.NodeId];
+        Subtree left = {node.Left, subtree.Begin, middle};
+        Subtree right = {node.Right, middle, subtree.End};
+        next.push_back(left);
+        next.push_back(right);
+        split = true;
+        }
+      subtrees.swap(next);
+      }
+
+    const std::ptrdiff_t numberOfSubtrees = static_cast<std::ptrdiff_t>(subtrees.size());
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numberOfThreads) schedule(dynamic, 1)
+#endif
+    for(std::ptrdiff_t i = 0; i < numberOfSubtrees; ++i)
+      {
+      this->Build(subtrees[i].NodeId, subtrees[i].Begin, subtrees[i].End);
+      }
+  }
+
+  void Build(std::size_t nodeId, std::size_t begin, std::size_t end)
+  {
+    Node& node = this->Nodes[nodeId];
+    if(end - begin <= LeafSize)
+      {
+      // The order within a leaf is left by the partitions, sorting it by id makes
+      // the whole tree the same for any number of threads
+      std::sort(this->Entries.begin() + begin, this->Entries.begin() + end, IdLess());
+      node.Begin = begin;
+      node.End = end;
+      node.Left = 0;
+      node.Right = 0;
+      return;
+      }
+    const std::size_t middle = this->SplitNode(nodeId, begin, end, 1);
+    this->Build(node.Left, begin, middle);
+    this->Build(node.Right, middle, end);
+  }
+
+  // Split along the axis of largest extent at the median, and return where the upper
+  // half begins. The left child directly follows its parent in the node array and
+  // the right child follows the subtree of the left one.
+  std::size_t SplitNode(std::size_t nodeId, std::size_t begin, std::size_t end, int numberOfThreads)
+  {
+    TScalar lower[Dimension];
+    TScalar upper[Dimension];
+    this->ComputeBounds(begin, end, lower, upper, numberOfThreads);
+    unsigned int axis = 0;
+    for(unsigned int d = 1; d < Dimension; ++d)
+      {
+      if(upper[d] - lower[d] > upper[axis] - lower[axis])
+        {
+        axis = d;
+        }
+      }
+
+    const std::size_t middle = begin + (end - begin) / 2;
+    Entry* entries = &this->Entries[0];
+    if(numberOfThreads > 1)
+      {
+      ParallelSelect(entries + begin, entries + middle, entries + end, axis, numberOfThreads);
+      }
+    else
+      {
+      AxisLess less = {axis};
+      std::nth_element(entries + begin, entries + middle, entries + end, less);
+      }
+
+    Node& node = this->Nodes[nodeId];
+    node.Begin = begin;
+    node.End = end;
+    node.Left = nodeId + 1;
+    node.Right = nodeId + 1 + CountNodes(middle - begin);
+    node.Axis = axis;
+    node.Split = entries[middle].Point[axis];
+    return middle;
+  }
+
+  void ComputeBounds(std::size_t begin, std::size_t end, TScalar* lower, TScalar* upper, int numberOfThreads) const
+  {
+    const Entry* entries = &this->Entries[0];
+    std::copy(entries[begin].Point, entries[begin].Point + Dimension, lower);
+    std::copy(entries[begin].Point, entries[begin].Point + Dimension, upper);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numberOfThreads) if(numberOfThreads > 1)
+#else
+    (void)numberOfThreads;
+#endif
+    {
+    TScalar threadLower[Dimension];
+    TScalar threadUpper[Dimension];
+    std::copy(lower, lower + Dimension, threadLower);
+    std::copy(upper, upper + Dimension, threadUpper);
+
+    const std::ptrdiff_t first = static_cast<std::ptrdiff_t>(begin);
+    const std::ptrdiff_t last = static_cast<std::ptrdiff_t>(end);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+    for(std::ptrdiff_t i = first; i < last; ++i)
+      {
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        threadLower[d] = std::min(threadLower[d], entries[i].Point[d]);
+        threadUpper[d] = std::max(threadUpper[d], entries[i].Point[d]);
+        }
+      }
+
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      lower[d] = std::min(lower[d], threadLower[d]);
+      upper[d] = std::max(upper[d], threadUpper[d]);
+      }
+    }
+  }
+
+  // Reorder [first, last) like std::nth_element, partitioning around pivots drawn
+  // from a sample with every thread, until the range around 'nth' is small enough
+  // for std::nth_element
+  static void ParallelSelect(Entry* first, Entry* nth, Entry* last, unsigned int axis, int numberOfThreads)
+  {
+    const std::size_t SampleSize = 255;
+    while(static_cast<std::size_t>(last - first) > ParallelSize)
+      {
+      Entry sample[SampleSize];
+      const std::size_t step = static_cast<std::size_t>(last - first) / SampleSize;
+      for(std::size_t i = 0; i < SampleSize; ++i)
+        {
+        sample[i] = first[i * step];
+        }
+      AxisLess less = {axis};
+      std::nth_element(sample, sample + SampleSize / 2, sample + SampleSize, less);
+      const Entry& pivot = sample[SampleSize / 2];
+
+      // [first, below) is below the pivot, [below, notAbove) is the pivot itself and
+      // [notAbove, last) above it, in the order of AxisLess. The pivot is one of the
+      // entries, so each step leaves out at least one entry.
+      AxisBelow isBelow = {axis, pivot.Point[axis], pivot.Id};
+      Entry* below = ParallelPartition(first, last, isBelow, numberOfThreads);
+      if(nth < below)
+        {
+        last = below;
+        continue;
+        }
+      AxisNotAbove isNotAbove = {axis, pivot.Point[axis], pivot.Id};
+      Entry* notAbove = ParallelPartition(below, last, isNotAbove, numberOfThreads);
+      if(nth < notAbove)
+        {
+        return;
+        }
+      first = notAbove;
+      }
+    AxisLess less = {axis};
+    std::nth_element(first, nth, last, less);
+  }
+
+  // Move the entries that satisfy 'predicate' to the front and return the end of
+  // them. Every thread partitions a block of its own, then the entries on the wrong
+  // side of the boundary are swapped in parallel, the ith misplaced entry of the
+  // front with the ith misplaced entry of the back.
+  template <typename TPredicate>
+  static Entry* ParallelPartition(Entry* first, Entry* last, TPredicate predicate, int numberOfThreads)
+  {
+    const std::ptrdiff_t size = last - first;
+    std::vector<std::ptrdiff_t> blockBegins(numberOfThreads + 1);
+    std::vector<std::ptrdiff_t> blockSplits(numberOfThreads);
+    for(int block = 0; block <= numberOfThreads; ++block)
+      {
+      blockBegins[block] = size / numberOfThreads * block + std::min<std::ptrdiff_t>(block, size % numberOfThreads);
+      }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numberOfThreads) schedule(static, 1)
+#endif
+    for(int block = 0; block < numberOfThreads; ++block)
+      {
+      blockSplits[block] = std::partition(first + blockBegins[block], first + blockBegins[block + 1], predicate) - first;
+      }
+
+    std::ptrdiff_t boundary = 0;
+    for(int block = 0; block < numberOfThreads; ++block)
+      {
+      boundary += blockSplits[block] - blockBegins[block];
+      }
+
+    // The runs of misplaced entries on either side of the boundary, in order, and the
+    // number of misplaced entries before each run
+    std::vector<std::ptrdiff_t> frontRuns;
+    std::vector<std::ptrdiff_t> backRuns;
+    std::vector<std::ptrdiff_t> frontRanks(1, 0);
+    std::vector<std::ptrdiff_t> backRanks(1, 0);
+    for(int block = 0; block < numberOfThreads; ++block)
+      {
+      const std::ptrdiff_t frontEnd = std::min(blockBegins[block + 1], boundary);
+      if(blockSplits[block] < frontEnd)
+        {
+        frontRuns.push_back(blockSplits[block]);
+        frontRanks.push_back(frontRanks.back() + frontEnd - blockSplits[block]);
+        }
+      const std::ptrdiff_t backBegin = std::max(blockBegins[block], boundary);
+      if(backBegin < blockSplits[block])
+        {
+        backRuns.push_back(backBegin);
+        backRanks.push_back(backRanks.back() + blockSplits[block] - backBegin);
+        }
+      }
+
+    const std::ptrdiff_t numberOfMisplaced = frontRanks.back();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numberOfThreads) schedule(static, 1)
+#endif
+    for(int thread = 0; thread < numberOfThreads; ++thread)
+      {
+      std::ptrdiff_t rank = numberOfMisplaced / numberOfThreads * thread +
+                            std::min<std::ptrdiff_t>(thread, numberOfMisplaced % numberOfThreads);
+      const std::ptrdiff_t lastRank = rank + numberOfMisplaced / numberOfThreads + (thread < numberOfMisplaced % numberOfThreads);
+      std::size_t front = std::upper_bound(frontRanks.begin(), frontRanks.end(), rank) - frontRanks.begin() - 1;
+      std::size_t back = std::upper_bound(backRanks.begin(), backRanks.end(), rank) - backRanks.begin() - 1;
+      while(rank < lastRank)
+        {
+        const std::ptrdiff_t length = std::min(std::min(frontRanks[front + 1], backRanks[back + 1]), lastRank) - rank;
+        Entry* frontEntry = first + frontRuns[front] + (rank - frontRanks[front]);
+        Entry* backEntry = first + backRuns[back] + (rank - backRanks[back]);
+        std::swap_ranges(frontEntry, frontEntry + length, backEntry);
+        rank += length;
+        if(rank == frontRanks[front + 1])
+          {
+          front++;
+          }
+        if(rank == backRanks[back + 1])
+          {
+          back++;
+          }
+        }
+      }
+
+    return first + boundary;
+  }
+
+  // Returns false once the search has run out of distance evaluations, to stop it
+  bool SearchKNearest(std::size_t nodeId, KNearestSearch& search) const
+  {
+    const Node& node = this->Nodes[nodeId];
+    std::vector<NeighborType>& nearest = *search.Nearest;
+    if(node.Left == 0)
+      {
+      for(std::size_t i = node.Begin; i < node.End; ++i)
+        {
+        const Entry& entry = this->Entries[i];
+        if(entry.Id == search.ExcludeId)
+          {
+          continue;
+          }
+        NeighborType candidate = {entry.Id, Distance2<TScalar, Dimension>(entry.Point, search.Query)};
+        InsertNeighbor(nearest, search.K, candidate);
+        if(--search.RemainingEvaluations == 0)
+          {
+          return false;
+          }
+        }
+      return true;
+      }
+
+    // Search the side of the query first. The points at the split itself can be on
+    // either side, so the other side is searched unless it is strictly too far.
+    const TScalar offset = search.Query[node.Axis] - node.Split;
+    const std::size_t nearChild = offset < 0 ? node.Left : node.Right;
+    const std::size_t farChild = offset < 0 ? node.Right : node.Left;
+    if(!this->SearchKNearest(nearChild, search))
+      {
+      return false;
+      }
+    if(nearest.size() < search.K || offset * offset * search.Scale <= nearest.front().Distance2)
+      {
+      return this->SearchKNearest(farChild, search);
+      }
+    return true;
+  }
+
+  // Returns false once 'maxCount' neighbors are found, to stop the search
+  bool SearchRadius(std::size_t nodeId, const TScalar* query, TScalar radius2, std::size_t maxCount,
+                    std::size_t excludeId, std::vector<NeighborType>& neighbors) const
+  {
+    const Node& node = this->Nodes[nodeId];
+    if(node.Left == 0)
+      {
+      for(std::size_t i = node.Begin; i < node.End; ++i)
+        {
+        const Entry& entry = this->Entries[i];
+        if(entry.Id == excludeId)
+          {
+          continue;
+          }
+        NeighborType candidate = {entry.Id, Distance2<TScalar, Dimension>(entry.Point, query)};
+        if(candidate.Distance2 <= radius2)
+          {
+          neighbors.push_back(candidate);
+          if(neighbors.size() == maxCount)
+            {
+            return false;
+            }
+          }
+        }
+      return true;
+      }
+
+    const TScalar offset = query[node.Axis] - node.Split;
+    const std::size_t nearChild = offset < 0 ? node.Left : node.Right;
+    const std::size_t farChild = offset < 0 ? node.Right : node.Left;
+    if(!this->SearchRadius(nearChild, query, radius2, maxCount, excludeId, neighbors))
+      {
+      return false;
+      }
+    if(offset * offset <= radius2)
+      {
+      return this->SearchRadius(farChild, query, radius2, maxCount, excludeId, neighbors);
+      }
+    return true;
+  }
+
+  std::vector<Entry> Entries;
+  std::vector<Node> Nodes;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,73 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Checks that the kd-tree built on several threads is the tree built on one. The
+// clouds are large enough for the nodes near the root to be partitioned by all of
+// the threads together, and the lattice has many equal coordinates. Searches with
+// a budget stop partway through the tree, so they only agree if the trees match
+// leaf for leaf. Run by ctest, it prints each mismatch and fails if there are any.
+
+// STL
+#include <string>
+#include <vector>
+
+// Custom
+#include "KdTree.h"
+#include "TestUtilities.h"
+
+namespace
+{
+void CheckKdTreeThreads(const std::string& distribution, const std::vector<double>& points)
+{
+  typedef SmartNeighbors::KdTree<double, 3> TreeType;
+  const std::size_t numberOfPoints = points.size() / 3;
+  TreeType serial(&points[0], numberOfPoints, 3, 1);
+  TreeType parallel(&points[0], numberOfPoints, 3, 4);
+
+  const SmartNeighbors::SearchBudget budget(0.5, 40);
+  std::vector<TreeType::NeighborType> expected;
+  std::vector<TreeType::NeighborType> found;
+  for(std::size_t id = 0; id < numberOfPoints; id += 7)
+    {
+    serial.FindKNearest(serial.GetPoint(id), 16, expected, id);
+    parallel.FindKNearest(parallel.GetPoint(id), 16, found, id);
+    if(!AreSame(expected, found))
+      {
+      Fail("The kd-tree built on 4 threads", distribution, id);
+      }
+    serial.FindKNearestApproximate(serial.GetPoint(id), 16, budget, expected, id);
+    parallel.FindKNearestApproximate(parallel.GetPoint(id), 16, budget, found, id);
+    if(!AreSame(expected, found))
+      {
+      Fail("The budgeted search of the kd-tree built on 4 threads", distribution, id);
+      }
+    }
+}
+}
+
+int main(int, char *[])
+{
+  const char* distributions[] = {"uniform", "plane", "lattice"};
+  for(unsigned int i = 0; i < 3; ++i)
+    {
+    std::vector<double> points;
+    GenerateCloud(distributions[i], 200000, points);
+    CheckKdTreeThreads(distributions[i], points);
+    }
+  return ReportFailures();
+}
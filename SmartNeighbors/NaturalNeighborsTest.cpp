@@ -0,0 +1,157 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Checks the natural neighbor geometry in 2D and in 3D: the neighbors are those of
+// Query(), the boundary two cells share has the same measure seen from either
+// side, and the cells tile the bounds. Laplace weights at random locations must be
+// positive, sum to 1 and reproduce the location from the neighbors, since Laplace
+// interpolation is exact for linear functions. Run by ctest, it prints each
+// mismatch and fails if there are any.
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Custom
+#include "TestUtilities.h"
+#include "VoronoiNeighborSearch.h"
+
+namespace
+{
+const double Tolerance = 1e-9;
+
+bool IsClose(double a, double b, double scale)
+{
+  return std::fabs(a - b) <= Tolerance * scale;
+}
+
+template <unsigned int Dimension>
+std::string GetCheckName(const std::string& check)
+{
+  return (Dimension == 2 ? "The 2D " : "The 3D ") + check;
+}
+
+template <unsigned int Dimension>
+void CheckMeasures(const std::vector<double>& points)
+{
+  const std::size_t numberOfPoints = points.size() / 3;
+  SmartNeighbors::VoronoiNeighborSearch<double, Dimension> search(&points[0], numberOfPoints, 3);
+
+  std::vector<std::vector<std::size_t> > neighborIds(numberOfPoints);
+  std::vector<std::vector<double> > sharedMeasures(numberOfPoints);
+  std::vector<std::size_t> expected;
+  double totalMeasure = 0.0;
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    double cellMeasure = 0.0;
+    search.QueryNaturalNeighbors(id, neighborIds[id], sharedMeasures[id], &cellMeasure);
+    search.Query(id, expected);
+    if(neighborIds[id] != expected)
+      {
+      Fail(GetCheckName<Dimension>("natural neighbors"), "uniform", id);
+      }
+    totalMeasure += cellMeasure;
+    }
+
+  // A measure of the size of a shared boundary, to scale the tolerance by
+  const double* bounds = search.GetBounds();
+  double boundsMeasure = 1.0;
+  for(unsigned int d = 0; d < Dimension; ++d)
+    {
+    boundsMeasure *= bounds[2 * d + 1] - bounds[2 * d];
+    }
+  const double boundaryScale = std::pow(boundsMeasure / numberOfPoints, (Dimension - 1.0) / Dimension);
+
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    for(std::size_t i = 0; i < neighborIds[id].size(); ++i)
+      {
+      const std::size_t neighborId = neighborIds[id][i];
+      const std::vector<std::size_t>& other = neighborIds[neighborId];
+      const std::size_t j = std::find(other.begin(), other.end(), id) - other.begin();
+      if(j == other.size() || !IsClose(sharedMeasures[id][i], sharedMeasures[neighborId][j], boundaryScale))
+        {
+        Fail(GetCheckName<Dimension>("shared measure"), "uniform", id);
+        }
+      }
+    }
+  if(!IsClose(totalMeasure, boundsMeasure, boundsMeasure))
+    {
+    Fail(GetCheckName<Dimension>("sum of the cell measures"), "uniform", 0);
+    }
+}
+
+template <unsigned int Dimension>
+void CheckLaplaceWeights(const std::vector<double>& points)
+{
+  const std::size_t numberOfPoints = points.size() / 3;
+  SmartNeighbors::VoronoiNeighborSearch<double, Dimension> search(&points[0], numberOfPoints, 3);
+
+  // Locations away from the bounds, whose cells do not reach them
+  Random random(5);
+  std::vector<std::size_t> neighborIds;
+  std::vector<double> sharedMeasures;
+  std::vector<double> weights;
+  for(std::size_t query = 0; query < 2000; ++query)
+    {
+    double location[Dimension];
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      location[d] = 0.25 + 0.5 * random.Uniform();
+      }
+    search.QueryNaturalNeighborsAt(location, neighborIds, sharedMeasures);
+    search.GetLaplaceWeights(location, neighborIds, sharedMeasures, weights);
+
+    bool valid = !weights.empty();
+    double sum = 0.0;
+    double interpolated[Dimension] = {0};
+    for(std::size_t i = 0; i < weights.size(); ++i)
+      {
+      valid = valid && weights[i] > 0;
+      sum += weights[i];
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        interpolated[d] += weights[i] * points[3 * neighborIds[i] + d];
+        }
+      }
+    valid = valid && IsClose(sum, 1.0, 1.0);
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      valid = valid && IsClose(interpolated[d], location[d], 1.0);
+      }
+    if(!valid)
+      {
+      Fail(GetCheckName<Dimension>("Laplace weights"), "uniform", query);
+      }
+    }
+}
+}
+
+int main(int, char *[])
+{
+  std::vector<double> points;
+  GenerateCloud("uniform", 20000, points);
+  CheckMeasures<2>(points);
+  CheckLaplaceWeights<2>(points);
+  GenerateCloud("uniform", 5000, points);
+  CheckMeasures<3>(points);
+  CheckLaplaceWeights<3>(points);
+  return ReportFailures();
+}
@@ -0,0 +1,79 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef NEIGHBORGRAPH_H
+#define NEIGHBORGRAPH_H
+
+// STL
+#include <cstddef>
+#include <vector>
+
+namespace SmartNeighbors
+{
+
+// The neighbors of every point of a cloud in compressed sparse row form.
+// The neighbors of point i are NeighborIds[Offsets[i]] through NeighborIds[Offsets[i+1] - 1].
+// TIndex is the type used to store a neighbor id, typically vtkIdType or a
+// 32 bit unsigned integer to halve the size of graphs with fewer than 2^32 points.
+template <typename TIndex>
+struct NeighborGraph
+{
+  typedef TIndex IndexType;
+
+  std::vector<std::size_t> Offsets;
+  std::vector<TIndex> NeighborIds;
+
+  std::size_t GetNumberOfPoints() const
+  {
+    return this->Offsets.empty() ? 0 : this->Offsets.size() - 1;
+  }
+
+  std::size_t GetNumberOfEdges() const
+  {
+    return this->NeighborIds.size();
+  }
+
+  std::size_t GetNumberOfNeighbors(std::size_t pointId) const
+  {
+    return this->Offsets[pointId + 1] - this->Offsets[pointId];
+  }
+
+  // Pointers to the first and one past the last neighbor of 'pointId'
+  const TIndex* NeighborsBegin(std::size_t pointId) const
+  {
+    return this->NeighborIds.empty() ? 0 : &this->NeighborIds[0] + this->Offsets[pointId];
+  }
+
+  const TIndex* NeighborsEnd(std::size_t pointId) const
+  {
+    return this->NeighborIds.empty() ? 0 : &this->NeighborIds[0] + this->Offsets[pointId + 1];
+  }
+
+  // Size the graph for 'numberOfPoints' points and 'numberOfEdges' neighbor
+  // ids in total. Storage that is already large enough is reused.
+  void Allocate(std::size_t numberOfPoints, std::size_t numberOfEdges)
+  {
+    this->Offsets.resize(numberOfPoints + 1);
+    this->Offsets[0] = 0;
+    this->NeighborIds.resize(numberOfEdges);
+  }
+};
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,152 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef NEIGHBORSEARCHSTATS_H
+#define NEIGHBORSEARCHSTATS_H
+
+// STL
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace SmartNeighbors
+{
+
+// Counters and per phase wall clock times of neighbor searches. A search only
+// records into a stats object when one is passed to it, so production runs that
+// do not ask for statistics pay nothing. Stats from several threads or runs can
+// be combined with Accumulate().
+struct NeighborSearchStats
+{
+  enum Phase
+  {
+    CopyPhase,              // copying or sorting the input
+    IndexBuildPhase,        // building the spatial index
+    KNearestPhase,          // finding candidate neighbors
+    HalfSpaceFilterPhase,   // the BSP halfspace tests
+    VoronoiGenerationPhase, // generating Voronoi diagrams or cells
+    NeighborLookupPhase,    // reading neighbors out of a diagram built before
+    NumberOfPhases
+  };
+
+  // Seconds spent in each phase
+  double PhaseTime[NumberOfPhases];
+
+  unsigned long long NumberOfQueries;
+
+  // Candidates examined and candidates accepted as neighbors, over all queries
+  unsigned long long NumberOfCandidates;
+  unsigned long long NumberOfAccepted;
+
+  NeighborSearchStats()
+  {
+    this->Reset();
+  }
+
+  void Reset()
+  {
+    for(unsigned int i = 0; i < NumberOfPhases; ++i)
+      {
+      this->PhaseTime[i] = 0.0;
+      }
+    this->NumberOfQueries = 0;
+    this->NumberOfCandidates = 0;
+    this->NumberOfAccepted = 0;
+  }
+
+  void Accumulate(const NeighborSearchStats& other)
+  {
+    for(unsigned int i = 0; i < NumberOfPhases; ++i)
+      {
+      this->PhaseTime[i] += other.PhaseTime[i];
+      }
+    this->NumberOfQueries += other.NumberOfQueries;
+    this->NumberOfCandidates += other.NumberOfCandidates;
+    this->NumberOfAccepted += other.NumberOfAccepted;
+  }
+
+  double GetAcceptRatio() const
+  {
+    if(this->NumberOfCandidates == 0)
+      {
+      return 0.0;
+      }
+    return static_cast<double>(this->NumberOfAccepted) / static_cast<double>(this->NumberOfCandidates);
+  }
+
+  double GetRejectRatio() const
+  {
+    if(this->NumberOfCandidates == 0)
+      {
+      return 0.0;
+      }
+    return 1.0 - this->GetAcceptRatio();
+  }
+
+  // Wall clock time in seconds, for timing phases without depending on VTK
+  static double GetTime()
+  {
+#ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return static_cast<double>(count.QuadPart) / static_cast<double>(frequency.QuadPart);
+#elif defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0 && defined(CLOCK_MONOTONIC)
+    // Monotonic and finer than a microsecond, single queries take only a few
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + 1e-9 * time.tv_nsec;
+#else
+    timeval time;
+    gettimeofday(&time, 0);
+    return time.tv_sec + 1e-6 * time.tv_usec;
+#endif
+  }
+
+  static const char* GetPhaseName(unsigned int phase)
+  {
+    static const char* names[NumberOfPhases] =
+      {"copy", "index build", "k nearest", "halfspace filter", "Voronoi generation", "neighbor lookup"};
+    return phase < NumberOfPhases ? names[phase] : "unknown";
+  }
+
+  void Print(std::ostream& os) const
+  {
+    for(unsigned int i = 0; i < NumberOfPhases; ++i)
+      {
+      os << GetPhaseName(i) << " time: " << this->PhaseTime[i] << " s" << std::endl;
+      }
+    os << "queries: " << this->NumberOfQueries << std::endl
+       << "candidates: " << this->NumberOfCandidates << std::endl
+       << "accepted: " << this->NumberOfAccepted
+       << " (accept ratio " << this->GetAcceptRatio() << ", reject ratio " << this->GetRejectRatio() << ")" << std::endl;
+  }
+};
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,393 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef NEIGHBORHOODREDUCERS_H
+#define NEIGHBORHOODREDUCERS_H
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace SmartNeighbors
+{
+
+// Reducers summarize the neighborhood of each point while it is found, see
+// BSPNeighborSearch::Reduce() and ReduceAll(), so per point results such as normals
+// are computed without storing the neighbors. A reducer provides
+//
+//   void Begin(std::size_t pointId, const TScalar center[3]);
+//   void Add(std::size_t neighborId, const TScalar neighbor[3]);
+//   void End();
+//   void Finish();
+//
+// Begin() starts the neighborhood of 'pointId', Add() is called once per neighbor
+// with its coordinates while they are still in the cache, and End() closes the
+// neighborhood. Coordinates always have three components, z is 0 in 2D. When the
+// whole cloud is reduced each thread works on its own copy of the reducer, and
+// Finish() is called once by each thread after its last point, one thread at a time,
+// to merge per thread state. The built in reducers write their results to caller
+// owned arrays indexed by point id, so their copies need no merging.
+
+// The mean and covariance of a set of points. The points are accumulated relative
+// to the first one to avoid the cancellation of large coordinates.
+template <typename TScalar>
+class CovarianceAccumulator
+{
+public:
+  CovarianceAccumulator()
+    : NumberOfPoints(0)
+  {
+  }
+
+  void Reset(const TScalar* origin)
+  {
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      this->Origin[d] = origin[d];
+      this->Sum[d] = 0;
+      }
+    for(unsigned int i = 0; i < 6; ++i)
+      {
+      this->SumOfProducts[i] = 0;
+      }
+    this->NumberOfPoints = 0;
+  }
+
+  void Add(const TScalar* point)
+  {
+    double p[3];
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      p[d] = point[d] - this->Origin[d];
+      this->Sum[d] += p[d];
+      }
+    this->SumOfProducts[0] += p[0] * p[0];
+    this->SumOfProducts[1] += p[0] * p[1];
+    this->SumOfProducts[2] += p[0] * p[2];
+    this->SumOfProducts[3] += p[1] * p[1];
+    this->SumOfProducts[4] += p[1] * p[2];
+    this->SumOfProducts[5] += p[2] * p[2];
+    ++this->NumberOfPoints;
+  }
+
+  std::size_t GetNumberOfPoints() const
+  {
+    return this->NumberOfPoints;
+  }
+
+  // The covariance is stored as xx, xy, xz, yy, yz, zz. Both are 0 without points.
+  void GetCovariance(double covariance[6], double mean[3]) const
+  {
+    double m[3] = {0, 0, 0};
+    if(this->NumberOfPoints > 0)
+      {
+      for(unsigned int d = 0; d < 3; ++d)
+        {
+        m[d] = this->Sum[d] / this->NumberOfPoints;
+        }
+      }
+    const unsigned int rows[6] = {0, 0, 0, 1, 1, 2};
+    const unsigned int columns[6] = {0, 1, 2, 1, 2, 2};
+    for(unsigned int i = 0; i < 6; ++i)
+      {
+      covariance[i] = this->NumberOfPoints > 0 ?
+        this->SumOfProducts[i] / this->NumberOfPoints - m[rows[i]] * m[columns[i]] : 0;
+      }
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      mean[d] = m[d] + (this->NumberOfPoints > 0 ? this->Origin[d] : 0);
+      }
+  }
+
+private:
+  double Origin[3];
+  double Sum[3];
+  double SumOfProducts[6];
+  std::size_t NumberOfPoints;
+};
+
+// The eigenvalues of the symmetric matrix 'covariance', stored as by
+// CovarianceAccumulator, in increasing order, by Jacobi rotations. If 'vectors' is
+// given, vectors[i] is set to the unit eigenvector of values[i].
+inline void ComputeSymmetricEigensystem(const double covariance[6], double values[3], double vectors[3][3] = 0)
+{
+  double a[3][3] = {{covariance[0], covariance[1], covariance[2]},
+                    {covariance[1], covariance[3], covariance[4]},
+                    {covariance[2], covariance[4], covariance[5]}};
+  // The columns of v are the eigenvectors
+  double v[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+  for(unsigned int sweep = 0; sweep < 50; ++sweep)
+    {
+    double offDiagonal = std::fabs(a[0][1]) + std::fabs(a[0][2]) + std::fabs(a[1][2]);
+    double diagonal = std::fabs(a[0][0]) + std::fabs(a[1][1]) + std::fabs(a[2][2]);
+    if(offDiagonal <= 1e-15 * diagonal || offDiagonal == 0)
+      {
+      break;
+      }
+    for(unsigned int p = 0; p < 2; ++p)
+      {
+      for(unsigned int q = p + 1; q < 3; ++q)
+        {
+        if(a[p][q] == 0)
+          {
+          continue;
+          }
+        // Zero a[p][q] with a rotation in the p, q plane
+        double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+        double t = (theta >= 0 ? 1 : -1) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+        double c = 1 / std::sqrt(t * t + 1);
+        double s = t * c;
+        for(unsigned int i = 0; i < 3; ++i)
+          {
+          double aip = a[i][p];
+          double aiq = a[i][q];
+          a[i][p] = c * aip - s * aiq;
+          a[i][q] = s * aip + c * aiq;
+          }
+        for(unsigned int i = 0; i < 3; ++i)
+          {
+          double api = a[p][i];
+          double aqi = a[q][i];
+          a[p][i] = c * api - s * aqi;
+          a[q][i] = s * api + c * aqi;
+          }
+        for(unsigned int i = 0; i < 3; ++i)
+          {
+          double vip = v[i][p];
+          double viq = v[i][q];
+          v[i][p] = c * vip - s * viq;
+          v[i][q] = s * vip + c * viq;
+          }
+        }
+      }
+    }
+
+  unsigned int order[3] = {0, 1, 2};
+  for(unsigned int i = 0; i < 2; ++i)
+    {
+    for(unsigned int j = i + 1; j < 3; ++j)
+      {
+      if(a[order[j]][order[j]] < a[order[i]][order[i]])
+        {
+        unsigned int swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+        }
+      }
+    }
+  for(unsigned int i = 0; i < 3; ++i)
+    {
+    values[i] = a[order[i]][order[i]];
+    if(vectors)
+      {
+      for(unsigned int d = 0; d < 3; ++d)
+        {
+        vectors[i][d] = v[d][order[i]];
+        }
+      }
+    }
+}
+
+// Write the covariance of each neighborhood, six values per point as stored by
+// CovarianceAccumulator, and optionally its mean, three values per point. The point
+// itself is part of its neighborhood unless 'includeCenter' is false.
+template <typename TScalar>
+class CovarianceReducer
+{
+public:
+  CovarianceReducer(double* covariances, double* means = 0, bool includeCenter = true)
+    : Covariances(covariances), Means(means), IncludeCenter(includeCenter), PointId(0)
+  {
+  }
+
+  void Begin(std::size_t pointId, const TScalar* center)
+  {
+    this->PointId = pointId;
+    this->Accumulator.Reset(center);
+    if(this->IncludeCenter)
+      {
+      this->Accumulator.Add(center);
+      }
+  }
+
+  void Add(std::size_t, const TScalar* neighbor)
+  {
+    this->Accumulator.Add(neighbor);
+  }
+
+  void End()
+  {
+    double covariance[6];
+    double mean[3];
+    this->Accumulator.GetCovariance(covariance, mean);
+    for(unsigned int i = 0; i < 6; ++i)
+      {
+      this->Covariances[6 * this->PointId + i] = covariance[i];
+      }
+    if(this->Means)
+      {
+      for(unsigned int d = 0; d < 3; ++d)
+        {
+        this->Means[3 * this->PointId + d] = mean[d];
+        }
+      }
+  }
+
+  void Finish()
+  {
+  }
+
+private:
+  double* Covariances;
+  double* Means;
+  bool IncludeCenter;
+
+  std::size_t PointId;
+  CovarianceAccumulator<TScalar> Accumulator;
+};
+
+// Write the unit normal of each neighborhood, the direction of least variance of
+// the point and its neighbors, three values per point. The sign of a normal is
+// arbitrary. With 'curvatures' the surface variation is written as well, see
+// CurvatureReducer. Neighborhoods of fewer than three points do not define a plane
+// and get a zero normal and a curvature of 0.
+template <typename TScalar>
+class NormalReducer
+{
+public:
+  NormalReducer(double* normals, double* curvatures = 0)
+    : Normals(normals), Curvatures(curvatures), PointId(0)
+  {
+  }
+
+  void Begin(std::size_t pointId, const TScalar* center)
+  {
+    this->PointId = pointId;
+    this->Accumulator.Reset(center);
+    this->Accumulator.Add(center);
+  }
+
+  void Add(std::size_t, const TScalar* neighbor)
+  {
+    this->Accumulator.Add(neighbor);
+  }
+
+  void End()
+  {
+    double normal[3] = {0, 0, 0};
+    double curvature = 0;
+    if(this->Accumulator.GetNumberOfPoints() >= 3)
+      {
+      double covariance[6];
+      double mean[3];
+      double values[3];
+      double vectors[3][3];
+      this->Accumulator.GetCovariance(covariance, mean);
+      ComputeSymmetricEigensystem(covariance, values, vectors);
+      for(unsigned int d = 0; d < 3; ++d)
+        {
+        normal[d] = vectors[0][d];
+        }
+      curvature = SurfaceVariation(values);
+      }
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      this->Normals[3 * this->PointId + d] = normal[d];
+      }
+    if(this->Curvatures)
+      {
+      this->Curvatures[this->PointId] = curvature;
+      }
+  }
+
+  void Finish()
+  {
+  }
+
+  // The smallest of the increasing eigenvalues 'values' over their sum, from 0 for a
+  // plane to 1/3 for an isotropic neighborhood
+  static double SurfaceVariation(const double values[3])
+  {
+    double sum = values[0] + values[1] + values[2];
+    return sum > 0 ? std::max(values[0], 0.0) / sum : 0;
+  }
+
+private:
+  double* Normals;
+  double* Curvatures;
+
+  std::size_t PointId;
+  CovarianceAccumulator<TScalar> Accumulator;
+};
+
+// Write the surface variation of each neighborhood, the smallest eigenvalue of the
+// covariance of the point and its neighbors over their sum, one value per point.
+// This estimates curvature, "Efficient Simplification of Point-Sampled Surfaces"
+// (Pauly, Gross and Kobbelt). It is 0 for neighborhoods of fewer than three points.
+template <typename TScalar>
+class CurvatureReducer
+{
+public:
+  CurvatureReducer(double* curvatures)
+    : Curvatures(curvatures), PointId(0)
+  {
+  }
+
+  void Begin(std::size_t pointId, const TScalar* center)
+  {
+    this->PointId = pointId;
+    this->Accumulator.Reset(center);
+    this->Accumulator.Add(center);
+  }
+
+  void Add(std::size_t, const TScalar* neighbor)
+  {
+    this->Accumulator.Add(neighbor);
+  }
+
+  void End()
+  {
+    double curvature = 0;
+    if(this->Accumulator.GetNumberOfPoints() >= 3)
+      {
+      double covariance[6];
+      double mean[3];
+      double values[3];
+      this->Accumulator.GetCovariance(covariance, mean);
+      ComputeSymmetricEigensystem(covariance, values);
+      curvature = NormalReducer<TScalar>::SurfaceVariation(values);
+      }
+    this->Curvatures[this->PointId] = curvature;
+  }
+
+  void Finish()
+  {
+  }
+
+private:
+  double* Curvatures;
+
+  std::size_t PointId;
+  CovarianceAccumulator<TScalar> Accumulator;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
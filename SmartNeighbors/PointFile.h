@@ -0,0 +1,344 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef POINTFILE_H
+#define POINTFILE_H
+
+// A minimal binary point cloud format that can be memory mapped and used in place.
+// A 32 byte header is followed by the x, y, z coordinates of every point as one
+// contiguous array of float32 or float64 values:
+//
+//   char Magic[8]                     "SNPOINTS"
+//   unsigned int ByteOrderMark        0x01020304 in the byte order of the writer
+//   unsigned int ScalarSize           4 for float32, 8 for float64
+//   unsigned long long NumberOfPoints
+//   unsigned long long Reserved       0
+//   scalar xyz[3 * NumberOfPoints]
+//
+// The header keeps the coordinates 8 byte aligned in the file, and so in the mapping.
+// Files are written in the byte order of the machine, and one with the other byte
+// order is rejected rather than swapped, since that would need a copy.
+//
+// Only reading the file is free of copies. Every PointIndex keeps its own copy of
+// the coordinates in the order it searches them, so a search built on the mapping
+// still allocates memory in proportion to the number of points, see
+// PointIndex::GetMemorySize().
+
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Custom
+#include "PointReader.h"
+
+namespace SmartNeighbors
+{
+
+struct PointFileHeader
+{
+  char Magic[8];
+  unsigned int ByteOrderMark;
+  unsigned int ScalarSize;
+  unsigned long long NumberOfPoints;
+  unsigned long long Reserved;
+};
+
+namespace PointFileDetail
+{
+const char Magic[8] = {'S', 'N', 'P', 'O', 'I', 'N', 'T', 'S'};
+const unsigned int ByteOrderMark = 0x01020304;
+
+template <typename TScalar>
+void Write(const std::string& fileName, const TScalar* xyz, unsigned long long numberOfPoints)
+{
+  PointFileHeader header;
+  std::memcpy(header.Magic, Magic, sizeof(Magic));
+  header.ByteOrderMark = ByteOrderMark;
+  header.ScalarSize = sizeof(TScalar);
+  header.NumberOfPoints = numberOfPoints;
+  header.Reserved = 0;
+
+  std::FILE* file = std::fopen(fileName.c_str(), "wb");
+  if(!file)
+    {
+    std::cerr << "Could not open " << fileName << " for writing!" << std::endl;
+    exit(-1);
+    }
+  bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+    (numberOfPoints == 0 || std::fwrite(xyz, 3 * sizeof(TScalar), numberOfPoints, file) == numberOfPoints);
+  if(std::fclose(file) != 0 || !written)
+    {
+    std::cerr << "Could not write " << fileName << "!" << std::endl;
+    exit(-1);
+    }
+}
+}
+
+// Write 'numberOfPoints' points, given as interleaved x, y, z, to a point file
+inline void WritePointFile(const std::string& fileName, const float* xyz, unsigned long long numberOfPoints)
+{
+  PointFileDetail::Write(fileName, xyz, numberOfPoints);
+}
+
+inline void WritePointFile(const std::string& fileName, const double* xyz, unsigned long long numberOfPoints)
+{
+  PointFileDetail::Write(fileName, xyz, numberOfPoints);
+}
+
+// True if the file starts with the point file magic
+inline bool IsPointFile(const std::string& fileName)
+{
+  char magic[sizeof(PointFileDetail::Magic)];
+  std::FILE* file = std::fopen(fileName.c_str(), "rb");
+  bool isPointFile = file && std::fread(magic, sizeof(magic), 1, file) == 1 &&
+                     std::memcmp(magic, PointFileDetail::Magic, sizeof(magic)) == 0;
+  if(file)
+    {
+    std::fclose(file);
+    }
+  return isPointFile;
+}
+
+// A point file mapped read-only into memory. Opening it only reads the header, the
+// coordinates are paged in by the operating system as they are first touched, so
+// opening a file of any size is immediate. The coordinates stay valid until the
+// object is destroyed.
+//
+// A file that cannot be opened or is not a valid point file ends the program, unless
+// 'exitOnError' is false. Then IsValid() is false and GetErrorMessage() says why,
+// which lets a tool that reads many files on worker threads skip the bad ones.
+class MappedPointFile
+{
+public:
+  MappedPointFile(const std::string& fileName, bool exitOnError = true)
+    : Data(0), Size(0)
+  {
+#ifdef _WIN32
+    this->File = INVALID_HANDLE_VALUE;
+    this->Mapping = 0;
+#endif
+    if(!this->Open(fileName) && exitOnError)
+      {
+      std::cerr << this->ErrorMessage << std::endl;
+      exit(-1);
+      }
+  }
+
+  ~MappedPointFile()
+  {
+#ifdef _WIN32
+    if(this->Data)
+      {
+      UnmapViewOfFile(this->Data);
+      }
+    if(this->Mapping)
+      {
+      CloseHandle(this->Mapping);
+      }
+    if(this->File != INVALID_HANDLE_VALUE)
+      {
+      CloseHandle(this->File);
+      }
+#else
+    if(this->Data)
+      {
+      munmap(this->Data, this->Size);
+      }
+#endif
+  }
+
+  // Whether the file was mapped and is a valid point file. Nothing else may be
+  // called otherwise.
+  bool IsValid() const
+  {
+    return this->ErrorMessage.empty();
+  }
+
+  const std::string& GetErrorMessage() const
+  {
+    return this->ErrorMessage;
+  }
+
+  unsigned long long GetNumberOfPoints() const
+  {
+    return this->GetHeader()->NumberOfPoints;
+  }
+
+  // 4 for float32 coordinates, 8 for float64
+  unsigned int GetScalarSize() const
+  {
+    return this->GetHeader()->ScalarSize;
+  }
+
+  // The interleaved x, y, z coordinates. Only the one matching the scalar size is not null.
+  const float* GetFloatPoints() const
+  {
+    return this->GetScalarSize() == 4 ? reinterpret_cast<const float*>(this->GetHeader() + 1) : 0;
+  }
+
+  const double* GetDoublePoints() const
+  {
+    return this->GetScalarSize() == 8 ? reinterpret_cast<const double*>(this->GetHeader() + 1) : 0;
+  }
+
+private:
+  // Not copyable, the mapping is released by the destructor
+  MappedPointFile(const MappedPointFile&);
+  void operator=(const MappedPointFile&);
+
+  bool Open(const std::string& fileName)
+  {
+#ifdef _WIN32
+    this->File = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, 0);
+    LARGE_INTEGER size;
+    if(this->File == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->File, &size))
+      {
+      return this->Fail(fileName, "could not be opened");
+      }
+    this->Size = static_cast<std::size_t>(size.QuadPart);
+    this->Mapping = CreateFileMappingA(this->File, 0, PAGE_READONLY, 0, 0, 0);
+    this->Data = this->Mapping ? MapViewOfFile(this->Mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+    if(!this->Data)
+      {
+      return this->Fail(fileName, "could not be mapped");
+      }
+#else
+    int file = open(fileName.c_str(), O_RDONLY);
+    struct stat status;
+    if(file < 0 || fstat(file, &status) != 0)
+      {
+      if(file >= 0)
+        {
+        close(file);
+        }
+      return this->Fail(fileName, "could not be opened");
+      }
+    this->Size = static_cast<std::size_t>(status.st_size);
+    if(this->Size > 0)
+      {
+      this->Data = mmap(0, this->Size, PROT_READ, MAP_SHARED, file, 0);
+      }
+    // The mapping keeps the file alive on its own
+    close(file);
+    if(this->Size > 0 && this->Data == MAP_FAILED)
+      {
+      this->Data = 0;
+      return this->Fail(fileName, "could not be mapped");
+      }
+#endif
+
+    if(this->Size < sizeof(PointFileHeader))
+      {
+      return this->Fail(fileName, "is too short to be a point file");
+      }
+    const PointFileHeader* header = this->GetHeader();
+    if(std::memcmp(header->Magic, PointFileDetail::Magic, sizeof(PointFileDetail::Magic)) != 0)
+      {
+      return this->Fail(fileName, "is not a point file");
+      }
+    if(header->ByteOrderMark != PointFileDetail::ByteOrderMark)
+      {
+      return this->Fail(fileName, "was written with the other byte order");
+      }
+    if((header->ScalarSize != 4 && header->ScalarSize != 8) ||
+       (this->Size - sizeof(PointFileHeader)) / (3 * header->ScalarSize) < header->NumberOfPoints)
+      {
+      return this->Fail(fileName, "is truncated or corrupt");
+      }
+    return true;
+  }
+
+  bool Fail(const std::string& fileName, const char* reason)
+  {
+    this->ErrorMessage = "The point file " + fileName + " " + reason + "!";
+    return false;
+  }
+
+  const PointFileHeader* GetHeader() const
+  {
+    return static_cast<const PointFileHeader*>(this->Data);
+  }
+
+#ifdef _WIN32
+  HANDLE File;
+  HANDLE Mapping;
+#endif
+  void* Data;
+  std::size_t Size;
+  std::string ErrorMessage;
+};
+
+// Reads a mapped point file front to back, for TiledNeighborSearch. Float32
+// coordinates are widened as they are read.
+class MappedPointFileReader : public PointReader
+{
+public:
+  MappedPointFileReader(const MappedPointFile* file)
+    : File(file), Position(0)
+  {
+  }
+
+  void Start()
+  {
+    this->Position = 0;
+  }
+
+  std::size_t Read(std::size_t count, double* xyz)
+  {
+    std::size_t numberOfPoints = static_cast<std::size_t>(this->File->GetNumberOfPoints());
+    count = std::min(count, numberOfPoints - this->Position);
+    if(this->File->GetDoublePoints())
+      {
+      const double* begin = this->File->GetDoublePoints() + 3 * this->Position;
+      std::copy(begin, begin + 3 * count, xyz);
+      }
+    else
+      {
+      const float* begin = this->File->GetFloatPoints() + 3 * this->Position;
+      std::copy(begin, begin + 3 * count, xyz);
+      }
+    this->Position += count;
+    return count;
+  }
+
+private:
+  const MappedPointFile* File;
+  std::size_t Position;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,69 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef POINTFILEVTK_H
+#define POINTFILEVTK_H
+
+// VTK
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+
+// Custom
+#include "PointFile.h"
+
+namespace SmartNeighbors
+{
+
+// Wrap the coordinates of a mapped point file as vtkPoints without copying them.
+// The points keep the precision of the file and are only valid while 'file' is,
+// and they must not be modified since the mapping is read-only. A searcher built
+// on the points still copies them into its index, see PointFile.h.
+inline vtkSmartPointer<vtkPoints> WrapPointFile(const MappedPointFile* file)
+{
+  vtkIdType numberOfValues = static_cast<vtkIdType>(3 * file->GetNumberOfPoints());
+
+  vtkSmartPointer<vtkDataArray> coordinates;
+  if(file->GetDoublePoints())
+    {
+    vtkSmartPointer<vtkDoubleArray> array =
+      vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetNumberOfComponents(3);
+    // The last argument tells the array not to free the memory
+    array->SetArray(const_cast<double*>(file->GetDoublePoints()), numberOfValues, 1);
+    coordinates = array;
+    }
+  else
+    {
+    vtkSmartPointer<vtkFloatArray> array =
+      vtkSmartPointer<vtkFloatArray>::New();
+    array->SetNumberOfComponents(3);
+    array->SetArray(const_cast<float*>(file->GetFloatPoints()), numberOfValues, 1);
+    coordinates = array;
+    }
+
+  vtkSmartPointer<vtkPoints> points =
+    vtkSmartPointer<vtkPoints>::New();
+  points->SetData(coordinates);
+  return points;
+}
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,190 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef POINTINDEX_H
+#define POINTINDEX_H
+
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace SmartNeighbors
+{
+
+// Squared distance between two points of a fixed dimension. The loop has a compile
+// time trip count, so it is fully unrolled.
+template <typename TScalar, unsigned int Dimension>
+inline TScalar Distance2(const TScalar* a, const TScalar* b)
+{
+  TScalar distance2 = 0;
+  for(unsigned int d = 0; d < Dimension; ++d)
+    {
+    const TScalar difference = a[d] - b[d];
+    distance2 += difference * difference;
+    }
+  return distance2;
+}
+
+// A point found by a search and its squared distance from the query. Neighbors are
+// ordered by distance and then by id, so ties are always broken the same way
+// whatever the index and its layout.
+template <typename TScalar>
+struct Neighbor
+{
+  std::size_t Id;
+  TScalar Distance2;
+
+  bool operator<(const Neighbor& other) const
+  {
+    return this->Distance2 < other.Distance2 || (this->Distance2 == other.Distance2 && this->Id < other.Id);
+  }
+};
+
+// Offer a candidate to a max heap of at most k neighbors, as kept by the k nearest
+// searches. The farthest neighbor is at the front.
+template <typename TScalar>
+inline void InsertNeighbor(std::vector<Neighbor<TScalar> >& nearest, unsigned int k, const Neighbor<TScalar>& candidate)
+{
+  if(nearest.size() < k)
+    {
+    nearest.push_back(candidate);
+    std::push_heap(nearest.begin(), nearest.end());
+    }
+  else if(candidate < nearest.front())
+    {
+    std::pop_heap(nearest.begin(), nearest.end());
+    nearest.back() = candidate;
+    std::push_heap(nearest.begin(), nearest.end());
+    }
+}
+
+// Limits on the effort of a k nearest search, for when slightly imperfect neighbors
+// are acceptable in exchange for speed, see PointIndex::FindKNearestApproximate().
+// The default is an exact search.
+struct SearchBudget
+{
+  explicit SearchBudget(double epsilon = 0, std::size_t maxDistanceEvaluations = 0)
+    : Epsilon(epsilon), MaxDistanceEvaluations(maxDistanceEvaluations)
+  {
+  }
+
+  bool IsExact() const
+  {
+    return this->Epsilon <= 0 && this->MaxDistanceEvaluations == 0;
+  }
+
+  // The ith neighbor found is at most 1 + Epsilon times as far from the query as the
+  // true ith nearest point, as parts of the index that could only hold points that
+  // much nearer are skipped
+  double Epsilon;
+
+  // The search stops once it has computed this many distances and returns the best
+  // neighbors found by then, which bounds the cost of every query. 0 means no limit.
+  std::size_t MaxDistanceEvaluations;
+};
+
+// The spatial indexes that can find candidate neighbors, see CreatePointIndex.h
+enum PointIndexType
+{
+  AutomaticIndex,   // chosen from the point distribution
+  KdTreeIndex,      // KdTree.h, for any distribution
+  UniformGridIndex  // UniformGrid.h, for nearly uniform sampling
+};
+
+// The interface of the spatial indexes that the neighbor searches find their
+// candidates with. Point i has its coordinates at points[i * stride], so the points
+// of a vtkPoints array can be searched in 2D with a stride of 3. The points are
+// referenced and must not change while the index is in use. Every index also keeps
+// a copy of the coordinates in the order it searches them, see GetMemorySize().
+// Searches only read the index, so any number of threads may search it at once.
+//
+// All indexes return exactly the same neighbors in the same order, so they only
+// differ in speed.
+template <typename TScalar, unsigned int Dimension>
+class PointIndex
+{
+public:
+  typedef TScalar ScalarType;
+  typedef Neighbor<TScalar> NeighborType;
+
+  // Ids that are not a point, to search without excluding any point
+  static const std::size_t NoId = static_cast<std::size_t>(-1);
+
+  PointIndex(const TScalar* points, std::size_t numberOfPoints, unsigned int stride)
+    : Points(points), NumberOfPoints(numberOfPoints), Stride(stride)
+  {
+  }
+
+  virtual ~PointIndex() {}
+
+  std::size_t GetNumberOfPoints() const
+  {
+    return this->NumberOfPoints;
+  }
+
+  unsigned int GetStride() const
+  {
+    return this->Stride;
+  }
+
+  const TScalar* GetPoint(std::size_t id) const
+  {
+    return this->Points + id * this->Stride;
+  }
+
+  // Find the k points nearest to 'query', nearest first, leaving out the point
+  // 'excludeId'. Fewer are returned only if there are not k other points.
+  virtual void FindKNearest(const TScalar* query, unsigned int k, std::vector<NeighborType>& nearest,
+                            std::size_t excludeId = NoId) const = 0;
+
+  // FindKNearest() within the limits of 'budget'. Indexes that cannot search
+  // approximately search exactly.
+  virtual void FindKNearestApproximate(const TScalar* query, unsigned int k, const SearchBudget& budget,
+                                       std::vector<NeighborType>& nearest, std::size_t excludeId = NoId) const
+  {
+    (void)budget;
+    this->FindKNearest(query, k, nearest, excludeId);
+  }
+
+  // Find the points within 'radius' of 'query', nearest first, leaving out the point
+  // 'excludeId'. With a nonzero 'maxCount' the search stops as soon as that many
+  // are found, so its cost is bounded wherever the points are dense. The search
+  // looks near the query first, so the points returned then tend to be the nearer
+  // ones, but they are not guaranteed to be the nearest.
+  virtual void FindInRadius(const TScalar* query, TScalar radius, std::size_t maxCount,
+                            std::vector<NeighborType>& neighbors, std::size_t excludeId = NoId) const = 0;
+
+  // The bytes that the index has allocated, not counting the points it references,
+  // so that indexes can be compared by memory as well as by speed
+  virtual std::size_t GetMemorySize() const = 0;
+
+protected:
+  const TScalar* Points;
+  std::size_t NumberOfPoints;
+  unsigned int Stride;
+
+private:
+  // Not copyable, indexes are owned by the searches that build them
+  PointIndex(const PointIndex&);
+  void operator=(const PointIndex&);
+};
+
+} // end namespace SmartNeighbors
+
+#endif
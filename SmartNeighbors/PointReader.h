@@ -0,0 +1,117 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef POINTREADER_H
+#define POINTREADER_H
+
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace SmartNeighbors
+{
+
+// A source of points that is read front to back in chunks, so clouds that do not fit
+// in memory can be processed in several passes. The id of a point is its position in
+// the sequence.
+class PointReader
+{
+public:
+  virtual ~PointReader() {}
+
+  // Go back to the first point
+  virtual void Start() = 0;
+
+  // Read up to 'count' points as x, y, z triples into 'xyz'. Returns the number of
+  // points read, which is 0 once every point has been read.
+  virtual std::size_t Read(std::size_t count, double* xyz) = 0;
+};
+
+// Reads points that are already in memory
+class MemoryPointReader : public PointReader
+{
+public:
+  MemoryPointReader(const double* xyz, std::size_t numberOfPoints)
+    : Points(xyz), NumberOfPoints(numberOfPoints), Position(0)
+  {
+  }
+
+  void Start()
+  {
+    this->Position = 0;
+  }
+
+  std::size_t Read(std::size_t count, double* xyz)
+  {
+    count = std::min(count, this->NumberOfPoints - this->Position);
+    std::copy(this->Points + 3 * this->Position, this->Points + 3 * (this->Position + count), xyz);
+    this->Position += count;
+    return count;
+  }
+
+private:
+  const double* Points;
+  std::size_t NumberOfPoints;
+  std::size_t Position;
+};
+
+// Reads a file that is nothing but x, y, z triples of doubles in the byte order of
+// this machine
+class RawPointFileReader : public PointReader
+{
+public:
+  RawPointFileReader(const std::string& fileName)
+  {
+    this->File = std::fopen(fileName.c_str(), "rb");
+    if(!this->File)
+      {
+      std::cerr << "Could not open " << fileName << "!" << std::endl;
+      exit(-1);
+      }
+  }
+
+  ~RawPointFileReader()
+  {
+    std::fclose(this->File);
+  }
+
+  void Start()
+  {
+    std::rewind(this->File);
+  }
+
+  std::size_t Read(std::size_t count, double* xyz)
+  {
+    return std::fread(xyz, 3 * sizeof(double), count, this->File);
+  }
+
+private:
+  // Not copyable, the file is closed by the destructor
+  RawPointFileReader(const RawPointFileReader&);
+  void operator=(const RawPointFileReader&);
+
+  std::FILE* File;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
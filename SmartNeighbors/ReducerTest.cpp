@@ -0,0 +1,113 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Checks that the fused reducers give exactly the normals, curvatures and
+// covariances of a pass over the stored BSP neighbors, on one thread and on
+// several, with the points in their own order and in Morton order. Run by ctest,
+// it prints each mismatch and fails if there are any.
+
+// STL
+#include <string>
+#include <vector>
+
+// Custom
+#include "BSPNeighborSearch.h"
+#include "NeighborhoodReducers.h"
+#include "TestUtilities.h"
+
+namespace
+{
+// Run 'reducer' over the BSP neighbors that Query() stores, the way a caller would
+// without the fused pass
+template <typename TScalar, typename TReducer>
+void ReduceStored(const SmartNeighbors::BSPNeighborSearch<TScalar, 3>& search, const TScalar* points,
+                  std::size_t numberOfPoints, unsigned int k, TReducer reducer)
+{
+  std::vector<std::size_t> neighbors;
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    search.Query(id, k, neighbors);
+    reducer.Begin(id, points + 3 * id);
+    for(std::size_t i = 0; i < neighbors.size(); ++i)
+      {
+      reducer.Add(neighbors[i], points + 3 * neighbors[i]);
+      }
+    reducer.End();
+    }
+  reducer.Finish();
+}
+
+void CheckReducers(const std::string& distribution, const std::vector<double>& cloud)
+{
+  typedef float ScalarType;
+  typedef SmartNeighbors::NormalReducer<ScalarType> NormalReducerType;
+  typedef SmartNeighbors::CovarianceReducer<ScalarType> CovarianceReducerType;
+  const std::vector<ScalarType> points(cloud.begin(), cloud.end());
+  const std::size_t numberOfPoints = points.size() / 3;
+  const unsigned int K = 16;
+
+  std::vector<double> expectedNormals(3 * numberOfPoints);
+  std::vector<double> expectedCurvatures(numberOfPoints);
+  std::vector<double> expectedCovariances(6 * numberOfPoints);
+  SmartNeighbors::BSPNeighborSearch<ScalarType, 3> search(&points[0], numberOfPoints);
+  ReduceStored(search, &points[0], numberOfPoints, K, NormalReducerType(&expectedNormals[0], &expectedCurvatures[0]));
+  ReduceStored(search, &points[0], numberOfPoints, K, CovarianceReducerType(&expectedCovariances[0]));
+
+  for(int reorder = 0; reorder < 2; ++reorder)
+    {
+    SmartNeighbors::BSPNeighborSearch<ScalarType, 3> fusedSearch(&points[0], numberOfPoints, 3,
+                                                                SmartNeighbors::AutomaticIndex, reorder != 0);
+    for(int numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads += 3)
+      {
+      std::vector<double> normals(3 * numberOfPoints);
+      std::vector<double> curvatures(numberOfPoints);
+      std::vector<double> covariances(6 * numberOfPoints);
+      fusedSearch.ReduceAll(K, NormalReducerType(&normals[0], &curvatures[0]), numberOfThreads);
+      fusedSearch.ReduceAll(K, CovarianceReducerType(&covariances[0]), numberOfThreads);
+      for(std::size_t id = 0; id < numberOfPoints; ++id)
+        {
+        bool same = curvatures[id] == expectedCurvatures[id];
+        for(unsigned int d = 0; d < 3; ++d)
+          {
+          same = same && normals[3 * id + d] == expectedNormals[3 * id + d];
+          }
+        for(unsigned int d = 0; d < 6; ++d)
+          {
+          same = same && covariances[6 * id + d] == expectedCovariances[6 * id + d];
+          }
+        if(!same)
+          {
+          Fail(reorder ? "The fused reducers on reordered points" : "The fused reducers", distribution, id);
+          }
+        }
+      }
+    }
+}
+}
+
+int main(int, char *[])
+{
+  const char* distributions[] = {"uniform", "plane", "lattice"};
+  for(unsigned int i = 0; i < 3; ++i)
+    {
+    std::vector<double> points;
+    GenerateCloud(distributions[i], 20000, points);
+    CheckReducers(distributions[i], points);
+    }
+  return ReportFailures();
+}
@@ -0,0 +1,211 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef REORDEREDPOINTINDEX_H
+#define REORDEREDPOINTINDEX_H
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Custom
+#include "CreatePointIndex.h"
+#include "SpaceFillingCurve.h"
+
+namespace SmartNeighbors
+{
+
+// An index over a copy of the points in the order of a Morton curve, see
+// SpaceFillingCurve.h. Points that are near each other in space are then near each
+// other in memory, so reading the coordinates of a point's neighbors touches a few
+// cache lines rather than one per neighbor.
+//
+// The reordering stays inside the index. FindKNearest() and FindInRadius() take and
+// return the caller's ids and find the same neighbors as any other index. Callers
+// that want to work in the reordered layout too can use the positions along the
+// curve instead: position i holds the point GetPermutation()[i] at
+// GetReorderedPoint(i), and the "Reordered" searches take and return positions.
+// Neighbors are still ordered by the caller's ids where they are equally far.
+template <typename TScalar, unsigned int Dimension>
+class ReorderedPointIndex : public PointIndex<TScalar, Dimension>
+{
+public:
+  typedef PointIndex<TScalar, Dimension> Superclass;
+  typedef typename Superclass::NeighborType NeighborType;
+
+  ReorderedPointIndex(const TScalar* points, std::size_t numberOfPoints, unsigned int stride = Dimension,
+                      PointIndexType indexType = AutomaticIndex)
+    : Superclass(points, numberOfPoints, stride), Positions(numberOfPoints), ReorderedPoints(Dimension * numberOfPoints)
+  {
+    ComputeMortonOrder<TScalar, Dimension>(points, numberOfPoints, stride, this->Permutation);
+    for(std::size_t position = 0; position < numberOfPoints; ++position)
+      {
+      const std::size_t id = this->Permutation[position];
+      this->Positions[id] = position;
+      const TScalar* p = this->GetPoint(id);
+      std::copy(p, p + Dimension, this->ReorderedPoints.begin() + Dimension * position);
+      }
+    this->ReorderedIndex = CreatePointIndex<TScalar, Dimension>(
+      this->ReorderedPoints.empty() ? 0 : &this->ReorderedPoints[0], numberOfPoints, Dimension, indexType);
+  }
+
+  ~ReorderedPointIndex()
+  {
+    delete this->ReorderedIndex;
+  }
+
+  // The point at each position along the curve
+  const std::vector<std::size_t>& GetPermutation() const
+  {
+    return this->Permutation;
+  }
+
+  // The position of the point 'id' along the curve
+  std::size_t GetPosition(std::size_t id) const
+  {
+    return this->Positions[id];
+  }
+
+  const TScalar* GetReorderedPoint(std::size_t position) const
+  {
+    return &this->ReorderedPoints[Dimension * position];
+  }
+
+  void FindKNearest(const TScalar* query, unsigned int k, std::vector<NeighborType>& nearest,
+                    std::size_t excludeId = Superclass::NoId) const
+  {
+    this->FindKNearestReordered(query, k, nearest, this->ToPosition(excludeId));
+    this->ToIds(nearest);
+  }
+
+  // An approximate search has no exact ties to break, so it reads the reordered
+  // index directly
+  void FindKNearestApproximate(const TScalar* query, unsigned int k, const SearchBudget& budget,
+                               std::vector<NeighborType>& nearest, std::size_t excludeId = Superclass::NoId) const
+  {
+    if(budget.IsExact())
+      {
+      this->FindKNearest(query, k, nearest, excludeId);
+      return;
+      }
+    this->ReorderedIndex->FindKNearestApproximate(query, k, budget, nearest, this->ToPosition(excludeId));
+    this->ToIds(nearest);
+    std::sort(nearest.begin(), nearest.end());
+  }
+
+  void FindInRadius(const TScalar* query, TScalar radius, std::size_t maxCount, std::vector<NeighborType>& neighbors,
+                    std::size_t excludeId = Superclass::NoId) const
+  {
+    this->FindInRadiusReordered(query, radius, maxCount, neighbors, this->ToPosition(excludeId));
+    this->ToIds(neighbors);
+  }
+
+  // FindKNearest() with the neighbors and 'excludePosition' given as positions
+  void FindKNearestReordered(const TScalar* query, unsigned int k, std::vector<NeighborType>& nearest,
+                             std::size_t excludePosition = Superclass::NoId) const
+  {
+    nearest.clear();
+    if(k == 0)
+      {
+      return;
+      }
+
+    // The index breaks ties by position, so one more neighbor shows whether points
+    // equally far as the kth could have been left out in its place
+    this->ReorderedIndex->FindKNearest(query, k + 1, nearest, excludePosition);
+    if(nearest.size() > k && !(nearest[k - 1].Distance2 < nearest[k].Distance2))
+      {
+      const TScalar distance2 = nearest[k - 1].Distance2;
+      const TScalar radius = std::sqrt(distance2) * (1 + 4 * std::numeric_limits<TScalar>::epsilon());
+      this->ReorderedIndex->FindInRadius(query, radius, 0, nearest, excludePosition);
+      std::size_t count = 0;
+      while(count < nearest.size() && nearest[count].Distance2 <= distance2)
+        {
+        count++;
+        }
+      nearest.resize(count);
+      }
+    this->SortById(nearest);
+    if(nearest.size() > k)
+      {
+      nearest.resize(k);
+      }
+  }
+
+  // FindInRadius() with the neighbors and 'excludePosition' given as positions
+  void FindInRadiusReordered(const TScalar* query, TScalar radius, std::size_t maxCount,
+                             std::vector<NeighborType>& neighbors, std::size_t excludePosition = Superclass::NoId) const
+  {
+    this->ReorderedIndex->FindInRadius(query, radius, maxCount, neighbors, excludePosition);
+    this->SortById(neighbors);
+  }
+
+  // The copy of the points in Morton order and the index of the copy
+  std::size_t GetMemorySize() const
+  {
+    return (this->Permutation.capacity() + this->Positions.capacity()) * sizeof(std::size_t) +
+           this->ReorderedPoints.capacity() * sizeof(TScalar) + this->ReorderedIndex->GetMemorySize();
+  }
+
+private:
+  // Orders neighbors given by position by distance and then by the caller's id
+  struct IdLess
+  {
+    const std::size_t* Permutation;
+
+    bool operator()(const NeighborType& a, const NeighborType& b) const
+    {
+      return a.Distance2 < b.Distance2 ||
+             (a.Distance2 == b.Distance2 && this->Permutation[a.Id] < this->Permutation[b.Id]);
+    }
+  };
+
+  void SortById(std::vector<NeighborType>& neighbors) const
+  {
+    if(!neighbors.empty())
+      {
+      IdLess less = {&this->Permutation[0]};
+      std::sort(neighbors.begin(), neighbors.end(), less);
+      }
+  }
+
+  std::size_t ToPosition(std::size_t id) const
+  {
+    return id < this->NumberOfPoints ? this->Positions[id] : Superclass::NoId;
+  }
+
+  void ToIds(std::vector<NeighborType>& neighbors) const
+  {
+    for(std::size_t i = 0; i < neighbors.size(); ++i)
+      {
+      neighbors[i].Id = this->Permutation[neighbors[i].Id];
+      }
+  }
+
+  std::vector<std::size_t> Permutation;
+  std::vector<std::size_t> Positions;
+  std::vector<TScalar> ReorderedPoints;
+  PointIndex<TScalar, Dimension>* ReorderedIndex;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,169 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef SPACEFILLINGCURVE_H
+#define SPACEFILLINGCURVE_H
+
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace SmartNeighbors
+{
+
+namespace SpaceFillingCurveDetail
+{
+// The position of a point on the Morton curve through its bounding box, the bits of
+// its quantized coordinates interleaved. Each axis gets an equal share of 63 bits.
+template <unsigned int Dimension>
+struct MortonBits
+{
+  static const unsigned int BitsPerAxis = 63 / Dimension;
+};
+
+template <typename TScalar, unsigned int Dimension>
+unsigned long long MortonCode(const TScalar* point, const double* lower, const double* scale)
+{
+  const unsigned int BitsPerAxis = MortonBits<Dimension>::BitsPerAxis;
+  const unsigned long long MaxCell = (1ULL << BitsPerAxis) - 1;
+
+  unsigned long long cells[Dimension];
+  for(unsigned int d = 0; d < Dimension; ++d)
+    {
+    const double cell = (static_cast<double>(point[d]) - lower[d]) * scale[d];
+    // Also catches NaN, which fails every comparison
+    cells[d] = cell > 0 ? std::min(static_cast<unsigned long long>(cell), MaxCell) : 0;
+    }
+
+  unsigned long long code = 0;
+  for(unsigned int bit = BitsPerAxis; bit-- > 0; )
+    {
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      code = (code << 1) | ((cells[d] >> bit) & 1);
+      }
+    }
+  return code;
+}
+
+// Sort 'numberOfPoints' points by their Morton codes. TPoints maps a position in
+// 0 .. numberOfPoints - 1 to the coordinates of a point.
+template <typename TScalar, unsigned int Dimension, typename TPoints>
+void ComputeMortonOrder(const TPoints& getPoint, std::size_t numberOfPoints, std::vector<std::size_t>& order)
+{
+  order.resize(numberOfPoints);
+  if(numberOfPoints == 0)
+    {
+    return;
+    }
+
+  double lower[Dimension];
+  double upper[Dimension];
+  for(unsigned int d = 0; d < Dimension; ++d)
+    {
+    lower[d] = upper[d] = getPoint(0)[d];
+    }
+  for(std::size_t i = 1; i < numberOfPoints; ++i)
+    {
+    const TScalar* p = getPoint(i);
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      lower[d] = std::min(lower[d], static_cast<double>(p[d]));
+      upper[d] = std::max(upper[d], static_cast<double>(p[d]));
+      }
+    }
+
+  // All axes are scaled alike, so the curve follows the shape of the points rather
+  // than stretching them to a cube
+  double extent = 0;
+  for(unsigned int d = 0; d < Dimension; ++d)
+    {
+    extent = std::max(extent, upper[d] - lower[d]);
+    }
+  double scale[Dimension];
+  for(unsigned int d = 0; d < Dimension; ++d)
+    {
+    scale[d] = extent > 0 ? static_cast<double>(1ULL << MortonBits<Dimension>::BitsPerAxis) / extent : 0;
+    }
+
+  std::vector<std::pair<unsigned long long, std::size_t> > codes(numberOfPoints);
+  for(std::size_t i = 0; i < numberOfPoints; ++i)
+    {
+    codes[i].first = MortonCode<TScalar, Dimension>(getPoint(i), lower, scale);
+    codes[i].second = i;
+    }
+  // Equal codes keep their original order, as the pairs compare by position next
+  std::sort(codes.begin(), codes.end());
+  for(std::size_t i = 0; i < numberOfPoints; ++i)
+    {
+    order[i] = codes[i].second;
+    }
+}
+
+template <typename TScalar>
+struct StridedPoints
+{
+  const TScalar* Points;
+  unsigned int Stride;
+
+  const TScalar* operator()(std::size_t i) const
+  {
+    return this->Points + i * this->Stride;
+  }
+};
+
+template <typename TScalar>
+struct SelectedPoints
+{
+  const TScalar* Points;
+  unsigned int Stride;
+  const std::size_t* Ids;
+
+  const TScalar* operator()(std::size_t i) const
+  {
+    return this->Points + this->Ids[i] * this->Stride;
+  }
+};
+}
+
+// The order of the points along a Morton (Z order) curve. Points that are near each
+// other in space tend to be near each other in this order, so processing them in it
+// keeps the data they touch in the caches. order[i] is the point at the ith position
+// along the curve. The points are laid out as for PointIndex.
+template <typename TScalar, unsigned int Dimension>
+void ComputeMortonOrder(const TScalar* points, std::size_t numberOfPoints, unsigned int stride,
+                        std::vector<std::size_t>& order)
+{
+  SpaceFillingCurveDetail::StridedPoints<TScalar> getPoint = {points, stride};
+  SpaceFillingCurveDetail::ComputeMortonOrder<TScalar, Dimension>(getPoint, numberOfPoints, order);
+}
+
+// The same for the points 'ids' of the array, order[i] is a position in 'ids'
+template <typename TScalar, unsigned int Dimension>
+void ComputeMortonOrder(const TScalar* points, unsigned int stride, const std::size_t* ids, std::size_t numberOfIds,
+                        std::vector<std::size_t>& order)
+{
+  SpaceFillingCurveDetail::SelectedPoints<TScalar> getPoint = {points, stride, ids};
+  SpaceFillingCurveDetail::ComputeMortonOrder<TScalar, Dimension>(getPoint, numberOfIds, order);
+}
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,246 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef SYMMETRIZENEIGHBORGRAPH_H
+#define SYMMETRIZENEIGHBORGRAPH_H
+
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Custom
+#include "NeighborGraph.h"
+
+namespace SmartNeighbors
+{
+
+// How to make a neighbor graph undirected
+enum Symmetrization
+{
+  UnionSymmetrization, // j and i are neighbors if either is a neighbor of the other
+  MutualSymmetrization // j and i are neighbors only if each is a neighbor of the other
+};
+
+namespace SymmetrizeNeighborGraphDetail
+{
+// The rows are merged in ranges of this many points. The ranges do not depend on
+// the thread count, so neither does the work each one does.
+const std::size_t RowRangeSize = 4096;
+
+template <typename TIndex>
+struct RowRange
+{
+  std::vector<std::size_t> NumberOfNeighbors;
+  std::vector<TIndex> NeighborIds;
+};
+
+// Sort and deduplicate [first, last), returning the new end
+template <typename TIndex>
+TIndex* SortUnique(TIndex* first, TIndex* last)
+{
+  std::sort(first, last);
+  return std::unique(first, last);
+}
+}
+
+// Make 'graph' undirected. Every edge i -> j is paired with j -> i, and 'symmetric'
+// keeps the pair if either edge is in the graph (union) or only if both are
+// (mutual). Self edges and repeated edges are dropped, and the neighbors of every
+// point are sorted by id. BSP and Voronoi neighborhoods found from k nearest
+// candidates are not symmetric, while meshing and smoothing need them to be.
+//
+// This runs on 'numberOfThreads' threads (0 means use all available cores). Each
+// thread sorts the reversed edges of a range of points into its own buffers, one
+// per range of target points, and then each range of points is merged from the
+// buffers of every thread by one thread, so no locks are needed. The result does
+// not depend on the number of threads. 'symmetric' must not be 'graph'.
+template <typename TIndex>
+void SymmetrizeNeighborGraph(const NeighborGraph<TIndex>& graph, Symmetrization symmetrization,
+                             NeighborGraph<TIndex>* symmetric, int numberOfThreads = 0)
+{
+  using SymmetrizeNeighborGraphDetail::RowRangeSize;
+  using SymmetrizeNeighborGraphDetail::SortUnique;
+  typedef SymmetrizeNeighborGraphDetail::RowRange<TIndex> RangeType;
+  typedef std::pair<TIndex, TIndex> EdgeType;
+
+  const std::size_t numberOfPoints = graph.GetNumberOfPoints();
+  const std::ptrdiff_t numberOfRanges = static_cast<std::ptrdiff_t>((numberOfPoints + RowRangeSize - 1) / RowRangeSize);
+
+#ifdef _OPENMP
+  if(numberOfThreads <= 0)
+    {
+    numberOfThreads = omp_get_max_threads();
+    }
+#else
+  numberOfThreads = 1;
+#endif
+
+  // reversedEdges[t][r] holds the edges j -> i, as (j, i), that thread t found
+  // reversed from i -> j with j in the range r
+  std::vector<std::vector<std::vector<EdgeType> > > reversedEdges(numberOfThreads,
+                                                                  std::vector<std::vector<EdgeType> >(numberOfRanges));
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numberOfThreads)
+#endif
+  {
+#ifdef _OPENMP
+  std::vector<std::vector<EdgeType> >& threadEdges = reversedEdges[omp_get_thread_num()];
+#pragma omp for schedule(static)
+#else
+  std::vector<std::vector<EdgeType> >& threadEdges = reversedEdges[0];
+#endif
+  for(std::ptrdiff_t range = 0; range < numberOfRanges; ++range)
+    {
+    const std::size_t begin = range * RowRangeSize;
+    const std::size_t end = std::min(begin + RowRangeSize, numberOfPoints);
+    for(std::size_t pointId = begin; pointId < end; ++pointId)
+      {
+      for(const TIndex* neighbor = graph.NeighborsBegin(pointId); neighbor != graph.NeighborsEnd(pointId); ++neighbor)
+        {
+        const std::size_t neighborId = static_cast<std::size_t>(*neighbor);
+        if(neighborId != pointId)
+          {
+          threadEdges[neighborId / RowRangeSize].push_back(EdgeType(*neighbor, static_cast<TIndex>(pointId)));
+          }
+        }
+      }
+    }
+  }
+
+  // Merge the edges of every range of points from the graph and from the buffers
+  std::vector<RangeType> ranges(numberOfRanges);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numberOfThreads)
+#endif
+  {
+  std::vector<std::size_t> reversedOffsets;
+  std::vector<TIndex> reversedIds;
+  std::vector<TIndex> forwardIds;
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+  for(std::ptrdiff_t rangeId = 0; rangeId < numberOfRanges; ++rangeId)
+    {
+    const std::size_t begin = rangeId * RowRangeSize;
+    const std::size_t end = std::min(begin + RowRangeSize, numberOfPoints);
+
+    // Counting sort of the reversed edges by point
+    reversedOffsets.assign(end - begin + 1, 0);
+    for(int thread = 0; thread < numberOfThreads; ++thread)
+      {
+      const std::vector<EdgeType>& edges = reversedEdges[thread][rangeId];
+      for(std::size_t i = 0; i < edges.size(); ++i)
+        {
+        reversedOffsets[static_cast<std::size_t>(edges[i].first) - begin + 1]++;
+        }
+      }
+    for(std::size_t i = 0; i + begin < end; ++i)
+      {
+      reversedOffsets[i + 1] += reversedOffsets[i];
+      }
+    reversedIds.resize(reversedOffsets.back());
+    for(int thread = 0; thread < numberOfThreads; ++thread)
+      {
+      std::vector<EdgeType>& edges = reversedEdges[thread][rangeId];
+      for(std::size_t i = 0; i < edges.size(); ++i)
+        {
+        reversedIds[reversedOffsets[static_cast<std::size_t>(edges[i].first) - begin]++] = edges[i].second;
+        }
+      std::vector<EdgeType>().swap(edges);
+      }
+    // The offsets have moved up by one row while filling
+    for(std::size_t i = end - begin; i > 0; --i)
+      {
+      reversedOffsets[i] = reversedOffsets[i - 1];
+      }
+    reversedOffsets[0] = 0;
+
+    RangeType& range = ranges[rangeId];
+    range.NumberOfNeighbors.resize(end - begin);
+    for(std::size_t pointId = begin; pointId < end; ++pointId)
+      {
+      forwardIds.clear();
+      for(const TIndex* neighbor = graph.NeighborsBegin(pointId); neighbor != graph.NeighborsEnd(pointId); ++neighbor)
+        {
+        if(static_cast<std::size_t>(*neighbor) != pointId)
+          {
+          forwardIds.push_back(*neighbor);
+          }
+        }
+
+      TIndex* forwardBegin = forwardIds.empty() ? 0 : &forwardIds[0];
+      TIndex* forwardEnd = SortUnique(forwardBegin, forwardBegin + forwardIds.size());
+      TIndex* reversedBegin = reversedIds.empty() ? 0 : &reversedIds[0] + reversedOffsets[pointId - begin];
+      TIndex* reversedEnd = SortUnique(reversedBegin, reversedBegin + (reversedOffsets[pointId - begin + 1] -
+                                                                        reversedOffsets[pointId - begin]));
+
+      const std::size_t numberOfIds = range.NeighborIds.size();
+      if(symmetrization == UnionSymmetrization)
+        {
+        std::set_union(forwardBegin, forwardEnd, reversedBegin, reversedEnd, std::back_inserter(range.NeighborIds));
+        }
+      else
+        {
+        std::set_intersection(forwardBegin, forwardEnd, reversedBegin, reversedEnd,
+                              std::back_inserter(range.NeighborIds));
+        }
+      range.NumberOfNeighbors[pointId - begin] = range.NeighborIds.size() - numberOfIds;
+      }
+    }
+  }
+
+  // Lay the ranges out one after another, as BuildNeighborGraph() does
+  std::vector<std::size_t> rangeOffsets(numberOfRanges + 1, 0);
+  for(std::ptrdiff_t rangeId = 0; rangeId < numberOfRanges; ++rangeId)
+    {
+    rangeOffsets[rangeId + 1] = rangeOffsets[rangeId] + ranges[rangeId].NeighborIds.size();
+    }
+
+  symmetric->Allocate(numberOfPoints, rangeOffsets[numberOfRanges]);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(numberOfThreads) schedule(static)
+#endif
+  for(std::ptrdiff_t rangeId = 0; rangeId < numberOfRanges; ++rangeId)
+    {
+    RangeType& range = ranges[rangeId];
+    std::size_t offset = rangeOffsets[rangeId];
+    const std::size_t pointId = rangeId * RowRangeSize;
+    for(std::size_t i = 0; i < range.NumberOfNeighbors.size(); ++i)
+      {
+      offset += range.NumberOfNeighbors[i];
+      symmetric->Offsets[pointId + i + 1] = offset;
+      }
+    std::copy(range.NeighborIds.begin(), range.NeighborIds.end(), symmetric->NeighborIds.begin() + rangeOffsets[rangeId]);
+    std::vector<TIndex>().swap(range.NeighborIds);
+    }
+}
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,138 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Checks the union and the mutual symmetrization of BSP neighbor graphs, on one
+// thread and on several, against sets of edges built one edge at a time. Some
+// points get a self edge and a repeated edge that the symmetrization must drop.
+// Run by ctest, it prints each mismatch and fails if there are any.
+
+// STL
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Custom
+#include "BSPNeighborSearch.h"
+#include "NeighborGraph.h"
+#include "SymmetrizeNeighborGraph.h"
+#include "TestUtilities.h"
+
+namespace
+{
+typedef SmartNeighbors::NeighborGraph<unsigned int> GraphType;
+typedef std::set<std::pair<unsigned int, unsigned int> > EdgeSet;
+
+// The BSP neighbors of every point, with a self edge and a repeated edge at every
+// fifth point
+void BuildGraph(const std::vector<double>& points, GraphType& graph)
+{
+  const std::size_t numberOfPoints = points.size() / 3;
+  SmartNeighbors::BSPNeighborSearch<double, 3> search(&points[0], numberOfPoints);
+  std::vector<std::size_t> neighborIds;
+  graph.Offsets.assign(1, 0);
+  graph.NeighborIds.clear();
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    search.Query(id, 12, neighborIds);
+    graph.NeighborIds.insert(graph.NeighborIds.end(), neighborIds.begin(), neighborIds.end());
+    if(id % 5 == 0 && !neighborIds.empty())
+      {
+      graph.NeighborIds.push_back(static_cast<unsigned int>(id));
+      graph.NeighborIds.push_back(static_cast<unsigned int>(neighborIds[0]));
+      }
+    graph.Offsets.push_back(graph.NeighborIds.size());
+    }
+}
+
+void CheckSymmetrization(const std::string& distribution, const std::vector<double>& points)
+{
+  GraphType graph;
+  BuildGraph(points, graph);
+
+  EdgeSet edges;
+  for(std::size_t id = 0; id < graph.GetNumberOfPoints(); ++id)
+    {
+    for(const unsigned int* neighbor = graph.NeighborsBegin(id); neighbor != graph.NeighborsEnd(id); ++neighbor)
+      {
+      if(*neighbor != id)
+        {
+        edges.insert(std::make_pair(static_cast<unsigned int>(id), *neighbor));
+        }
+      }
+    }
+  EdgeSet unionEdges;
+  EdgeSet mutualEdges;
+  for(EdgeSet::const_iterator edge = edges.begin(); edge != edges.end(); ++edge)
+    {
+    const std::pair<unsigned int, unsigned int> reversed(edge->second, edge->first);
+    unionEdges.insert(*edge);
+    unionEdges.insert(reversed);
+    if(edges.count(reversed))
+      {
+      mutualEdges.insert(*edge);
+      }
+    }
+
+  const SmartNeighbors::Symmetrization symmetrizations[] = {SmartNeighbors::UnionSymmetrization,
+                                                            SmartNeighbors::MutualSymmetrization};
+  const EdgeSet* expectedEdges[] = {&unionEdges, &mutualEdges};
+  const char* names[] = {"The union", "The mutual symmetrization"};
+  for(unsigned int i = 0; i < 2; ++i)
+    {
+    for(int numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads += 3)
+      {
+      GraphType symmetric;
+      SmartNeighbors::SymmetrizeNeighborGraph(graph, symmetrizations[i], &symmetric, numberOfThreads);
+      if(symmetric.GetNumberOfPoints() != graph.GetNumberOfPoints() ||
+         symmetric.GetNumberOfEdges() != expectedEdges[i]->size())
+        {
+        Fail(std::string(names[i]) + " edge count", distribution, 0);
+        continue;
+        }
+      // The set is sorted by point and then by neighbor, as the rows should be
+      EdgeSet::const_iterator edge = expectedEdges[i]->begin();
+      for(std::size_t id = 0; id < symmetric.GetNumberOfPoints(); ++id)
+        {
+        bool same = true;
+        for(const unsigned int* neighbor = symmetric.NeighborsBegin(id); neighbor != symmetric.NeighborsEnd(id);
+            ++neighbor, ++edge)
+          {
+          same = same && edge->first == id && edge->second == *neighbor;
+          }
+        if(!same)
+          {
+          Fail(names[i], distribution, id);
+          }
+        }
+      }
+    }
+}
+}
+
+int main(int, char *[])
+{
+  const char* distributions[] = {"uniform", "plane", "lattice"};
+  for(unsigned int i = 0; i < 3; ++i)
+    {
+    std::vector<double> points;
+    GenerateCloud(distributions[i], 20000, points);
+    CheckSymmetrization(distributions[i], points);
+    }
+  return ReportFailures();
+}
@@ -0,0 +1,131 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef TESTUTILITIES_H
+#define TESTUTILITIES_H
+
+// What the tests share: reproducible clouds and a count of the failed checks. Each
+// test is one translation unit that includes this once, prints each mismatch with
+// Fail() and returns ReportFailures() from main.
+
+// STL
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// The same sequence on every platform, see Benchmark.cpp
+class Random
+{
+public:
+  explicit Random(unsigned int seed)
+    : State(0x9E3779B97F4A7C15ULL ^ seed)
+  {
+  }
+
+  // Uniform in [0, 1)
+  double Uniform()
+  {
+    // xorshift64*
+    this->State ^= this->State >> 12;
+    this->State ^= this->State << 25;
+    this->State ^= this->State >> 27;
+    unsigned long long value = this->State * 2685821657736338717ULL;
+    return (value >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+private:
+  unsigned long long State;
+};
+
+// Clouds that exercise different paths:
+//  uniform - uniform in the unit cube, where the grid is chosen
+//  plane   - a thin slab, whose grid has a single cell across
+//  lattice - integer coordinates, so that many points are equally far and the
+//            halfspace tests hit exact zeros
+void GenerateCloud(const std::string& distribution, std::size_t numberOfPoints, std::vector<double>& points)
+{
+  Random random(7);
+  points.resize(3 * numberOfPoints);
+  for(std::size_t i = 0; i < numberOfPoints; ++i)
+    {
+    double* p = &points[3 * i];
+    if(distribution == "lattice")
+      {
+      for(unsigned int d = 0; d < 3; ++d)
+        {
+        p[d] = static_cast<int>(20 * random.Uniform());
+        }
+      }
+    else
+      {
+      for(unsigned int d = 0; d < 3; ++d)
+        {
+        p[d] = random.Uniform();
+        }
+      if(distribution == "plane")
+        {
+        p[2] *= 1e-6;
+        }
+      }
+    }
+}
+
+unsigned int NumberOfFailures = 0;
+
+void Fail(const std::string& check, const std::string& distribution, std::size_t id)
+{
+  if(NumberOfFailures < 20)
+    {
+    std::cerr << check << " differs on the " << distribution << " cloud at " << id << "!" << std::endl;
+    }
+  NumberOfFailures++;
+}
+
+template <typename TNeighbor>
+bool AreSame(const std::vector<TNeighbor>& a, const std::vector<TNeighbor>& b)
+{
+  if(a.size() != b.size())
+    {
+    return false;
+    }
+  for(std::size_t i = 0; i < a.size(); ++i)
+    {
+    if(a[i].Id != b[i].Id || a[i].Distance2 != b[i].Distance2)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+int ReportFailures()
+{
+  if(NumberOfFailures > 0)
+    {
+    std::cerr << NumberOfFailures << " checks failed!" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "All checks passed." << std::endl;
+  return EXIT_SUCCESS;
+}
+}
+
+#endif
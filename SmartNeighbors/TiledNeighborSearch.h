@@ -0,0 +1,751 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef TILEDNEIGHBORSEARCH_H
+#define TILEDNEIGHBORSEARCH_H
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Custom
+#include "PointReader.h"
+
+namespace SmartNeighbors
+{
+
+// The neighbor search that TiledNeighborSearch runs on the points of each tile
+class TileNeighborQuery
+{
+public:
+  virtual ~TileNeighborQuery() {}
+
+  // 2 if the search only uses x and y, in which case tiles are only split in x and y
+  virtual unsigned int GetDimension() const = 0;
+
+  // About how much memory the search needs per point of a tile, not counting the
+  // coordinates and ids that TiledNeighborSearch keeps itself
+  virtual std::size_t GetBytesPerPoint() const = 0;
+
+  // Prepare to search the points of one tile, interior and halo. 'bounds' are the
+  // bounds of the whole cloud as {xmin, xmax, ymin, ymax, zmin, zmax}.
+  virtual void SetTilePoints(const std::vector<double>& xyz, const double bounds[6]) = 0;
+
+  // Find the neighbors of the tile point 'pointIndex' as indices of tile points.
+  // Returns the radius of the ball around the point that the result depends on: it
+  // is exact if every point of the cloud within that ball is a tile point. This is
+  // called from several threads at once.
+  virtual double Query(std::size_t pointIndex, std::vector<std::size_t>& neighborIndices) const = 0;
+};
+
+// Computes the neighbors of every point of a cloud that does not fit in memory.
+// Space is split into tiles, each holding about as many points as fit in the memory
+// budget. Each tile is loaded together with a halo, the points within the halo width
+// of it, and the neighbors of the points inside the tile are found among the loaded
+// points and appended to the output file. Peak memory is set by the budget rather
+// than by the size of the cloud.
+//
+// The input is read front to back several times: once for its bounds, once for its
+// density, and once for every 256 tiles to copy the tile points to scratch files.
+//
+// A result is exact when the ball it depends on (see TileNeighborQuery::Query) lies
+// inside the loaded region. Results that are not exact are still written, marked as
+// such and counted, so the halo width can be increased if there are too many of them.
+//
+// The output file is a sequence of records, one per point in no particular order:
+//
+//   unsigned long long pointId
+//   unsigned int numberOfNeighbors
+//   unsigned int exact                  (1 or 0)
+//   unsigned long long neighborIds[numberOfNeighbors]
+//
+// NeighborRecordReader reads it back.
+class TiledNeighborSearch
+{
+public:
+  TiledNeighborSearch()
+    : MemoryBudget(std::size_t(1) << 30), HaloWidth(0.0), ScratchDirectory("."), NumberOfThreads(0)
+  {
+    this->ResetCounts();
+  }
+
+  // In bytes, 1 GB by default
+  void SetMemoryBudget(std::size_t memoryBudget)
+  {
+    this->MemoryBudget = memoryBudget;
+  }
+
+  // Should be at least the distance to the farthest neighbor a point can have
+  void SetHaloWidth(double haloWidth)
+  {
+    this->HaloWidth = haloWidth;
+  }
+
+  // Where the tile points are copied to, the current directory by default
+  void SetScratchDirectory(const std::string& scratchDirectory)
+  {
+    this->ScratchDirectory = scratchDirectory;
+  }
+
+  // 0, the default, means use all available cores
+  void SetNumberOfThreads(int numberOfThreads)
+  {
+    this->NumberOfThreads = numberOfThreads;
+  }
+
+  void Run(PointReader* reader, TileNeighborQuery* query, const std::string& outputFileName)
+  {
+    this->ResetCounts();
+    this->Dimension = query->GetDimension() == 2 ? 2 : 3;
+
+    this->ComputeBounds(reader);
+    if(this->NumberOfPoints == 0)
+      {
+      return;
+      }
+    this->ComputeHistogram(reader);
+
+    // Everything but the tile points has a fixed size. That includes the lists of the
+    // tiles that load each histogram cell in SpillTiles(), allowed 2^Dimension tiles
+    // per cell, as where tiles meet at a corner with halos narrower than the tiles.
+    const std::size_t numberOfCells = static_cast<std::size_t>(this->GridSize[0]) * this->GridSize[1] * this->GridSize[2];
+    const std::size_t cellBytes = (numberOfCells + 1) * sizeof(std::size_t) + numberOfCells * sizeof(unsigned int)
+                                + (numberOfCells << this->Dimension) * sizeof(unsigned int);
+    const std::size_t fixedBytes = ReadChunkSize * 3 * sizeof(double) + MaxOpenTiles * SpillBufferSize
+                                 + this->CellCounts.size() * sizeof(unsigned long long) + cellBytes;
+    const std::size_t bytesPerPoint = query->GetBytesPerPoint() + sizeof(SpillRecord) + 2 * sizeof(std::size_t);
+    if(this->MemoryBudget <= fixedBytes + 1000 * bytesPerPoint)
+      {
+      std::cerr << "A memory budget of " << this->MemoryBudget << " bytes is too small, at least "
+                << fixedBytes + 1000 * bytesPerPoint << " bytes are needed!" << std::endl;
+      exit(-1);
+      }
+    this->SplitTiles((this->MemoryBudget - fixedBytes) / bytesPerPoint);
+
+    std::FILE* output = std::fopen(outputFileName.c_str(), "wb");
+    if(!output)
+      {
+      std::cerr << "Could not open " << outputFileName << " for writing!" << std::endl;
+      exit(-1);
+      }
+
+    for(std::size_t first = 0; first < this->Tiles.size(); first += MaxOpenTiles)
+      {
+      std::size_t last = std::min(first + MaxOpenTiles, this->Tiles.size());
+      this->SpillTiles(reader, first, last);
+      for(std::size_t tileId = first; tileId < last; ++tileId)
+        {
+        this->ProcessTile(tileId, query, output);
+        }
+      }
+
+    std::fclose(output);
+  }
+
+  std::size_t GetNumberOfTiles() const
+  {
+    return this->Tiles.size();
+  }
+
+  unsigned long long GetNumberOfPoints() const
+  {
+    return this->NumberOfPoints;
+  }
+
+  // Points whose result depends on points outside of their tile and halo
+  unsigned long long GetNumberOfInexactPoints() const
+  {
+    return this->NumberOfInexactPoints;
+  }
+
+  // The most points loaded at once, halo included
+  std::size_t GetLargestTileSize() const
+  {
+    return this->LargestTileSize;
+  }
+
+private:
+  static const std::size_t ReadChunkSize = 1 << 16;
+  static const std::size_t MaxOpenTiles = 256;
+  static const std::size_t SpillBufferSize = 1 << 14;
+  static const std::size_t QueryBlockSize = 4096;
+
+  // The point id has the top bit set if the point is inside the tile rather than in its halo
+  struct SpillRecord
+  {
+    double Point[3];
+    unsigned long long Id;
+  };
+  static const unsigned long long InteriorFlag = 1ULL << 63;
+
+  // A box of histogram cells [Lo, Hi) and the region loaded for it
+  struct Tile
+  {
+    unsigned int Lo[3];
+    unsigned int Hi[3];
+    double Loaded[6];
+    std::size_t NumberOfLoadedPoints;
+  };
+
+  void ResetCounts()
+  {
+    this->NumberOfPoints = 0;
+    this->NumberOfInexactPoints = 0;
+    this->LargestTileSize = 0;
+    this->Tiles.clear();
+  }
+
+  void ComputeBounds(PointReader* reader)
+  {
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      this->Bounds[2*d] = HUGE_VAL;
+      this->Bounds[2*d + 1] = -HUGE_VAL;
+      }
+
+    std::vector<double> chunk(3 * ReadChunkSize);
+    reader->Start();
+    std::size_t numberRead;
+    while((numberRead = reader->Read(ReadChunkSize, &chunk[0])) > 0)
+      {
+      for(std::size_t i = 0; i < numberRead; ++i)
+        {
+        for(unsigned int d = 0; d < 3; ++d)
+          {
+          this->Bounds[2*d] = std::min(this->Bounds[2*d], chunk[3*i + d]);
+          this->Bounds[2*d + 1] = std::max(this->Bounds[2*d + 1], chunk[3*i + d]);
+          }
+        }
+      this->NumberOfPoints += numberRead;
+      }
+  }
+
+  // The histogram has about 2^18 cells in the dimensions that are split
+  void ComputeHistogram(PointReader* reader)
+  {
+    const unsigned int cellsPerAxis = this->Dimension == 2 ? 512 : 64;
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      double extent = this->Bounds[2*d + 1] - this->Bounds[2*d];
+      this->GridSize[d] = (d < this->Dimension && extent > 0.0) ? cellsPerAxis : 1;
+      this->CellSize[d] = extent > 0.0 ? extent / this->GridSize[d] : 1.0;
+      }
+
+    // Prefix sums of the counts, so the count of any box of cells takes 8 lookups
+    this->CellCounts.assign(static_cast<std::size_t>(this->GridSize[0] + 1) * (this->GridSize[1] + 1)
+                            * (this->GridSize[2] + 1), 0);
+
+    std::vector<double> chunk(3 * ReadChunkSize);
+    reader->Start();
+    std::size_t numberRead;
+    while((numberRead = reader->Read(ReadChunkSize, &chunk[0])) > 0)
+      {
+      for(std::size_t i = 0; i < numberRead; ++i)
+        {
+        unsigned int cell[3];
+        this->GetCell(&chunk[3*i], cell);
+        this->CellCounts[this->PrefixIndex(cell[0] + 1, cell[1] + 1, cell[2] + 1)]++;
+        }
+      }
+
+    for(unsigned int i = 1; i <= this->GridSize[0]; ++i)
+      {
+      for(unsigned int j = 1; j <= this->GridSize[1]; ++j)
+        {
+        for(unsigned int k = 1; k <= this->GridSize[2]; ++k)
+          {
+          this->CellCounts[this->PrefixIndex(i, j, k)] +=
+              this->CellCounts[this->PrefixIndex(i - 1, j, k)] + this->CellCounts[this->PrefixIndex(i, j - 1, k)]
+            + this->CellCounts[this->PrefixIndex(i, j, k - 1)] - this->CellCounts[this->PrefixIndex(i - 1, j - 1, k)]
+            - this->CellCounts[this->PrefixIndex(i - 1, j, k - 1)] - this->CellCounts[this->PrefixIndex(i, j - 1, k - 1)]
+            + this->CellCounts[this->PrefixIndex(i - 1, j - 1, k - 1)];
+          }
+        }
+      }
+  }
+
+  std::size_t PrefixIndex(unsigned int i, unsigned int j, unsigned int k) const
+  {
+    return (static_cast<std::size_t>(i) * (this->GridSize[1] + 1) + j) * (this->GridSize[2] + 1) + k;
+  }
+
+  void GetCell(const double point[3], unsigned int cell[3]) const
+  {
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      double c = std::floor((point[d] - this->Bounds[2*d]) / this->CellSize[d]);
+      cell[d] = static_cast<unsigned int>(std::max(0.0, std::min(c, this->GridSize[d] - 1.0)));
+      }
+  }
+
+  // The number of points in the cells [lo, hi)
+  unsigned long long CountPoints(const unsigned int lo[3], const unsigned int hi[3]) const
+  {
+    return this->CellCounts[this->PrefixIndex(hi[0], hi[1], hi[2])]
+         - this->CellCounts[this->PrefixIndex(lo[0], hi[1], hi[2])]
+         - this->CellCounts[this->PrefixIndex(hi[0], lo[1], hi[2])]
+         - this->CellCounts[this->PrefixIndex(hi[0], hi[1], lo[2])]
+         + this->CellCounts[this->PrefixIndex(lo[0], lo[1], hi[2])]
+         + this->CellCounts[this->PrefixIndex(lo[0], hi[1], lo[2])]
+         + this->CellCounts[this->PrefixIndex(hi[0], lo[1], lo[2])]
+         - this->CellCounts[this->PrefixIndex(lo[0], lo[1], lo[2])];
+  }
+
+  // Set the loaded region of a tile, and the cells that overlap it. Sides of the tile
+  // on the boundary of the cloud are open, since there are no points beyond them.
+  void SetLoadedRegion(Tile& tile, unsigned int loadedLo[3], unsigned int loadedHi[3]) const
+  {
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      tile.Loaded[2*d] = tile.Lo[d] == 0 ? -HUGE_VAL
+                       : this->Bounds[2*d] + tile.Lo[d] * this->CellSize[d] - this->HaloWidth;
+      tile.Loaded[2*d + 1] = tile.Hi[d] == this->GridSize[d] ? HUGE_VAL
+                           : this->Bounds[2*d] + tile.Hi[d] * this->CellSize[d] + this->HaloWidth;
+
+      double lo = std::floor((tile.Loaded[2*d] - this->Bounds[2*d]) / this->CellSize[d]);
+      double hi = std::floor((tile.Loaded[2*d + 1] - this->Bounds[2*d]) / this->CellSize[d]) + 1.0;
+      loadedLo[d] = static_cast<unsigned int>(std::max(0.0, std::min(lo, this->GridSize[d] - 1.0)));
+      loadedHi[d] = static_cast<unsigned int>(std::max(1.0, std::min(hi, static_cast<double>(this->GridSize[d]))));
+      }
+  }
+
+  // Split the cloud until each tile and its halo hold at most 'capacity' points,
+  // halving the points of a tile along its longest side each time
+  void SplitTiles(std::size_t capacity)
+  {
+    std::vector<Tile> stack(1);
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      stack[0].Lo[d] = 0;
+      stack[0].Hi[d] = this->GridSize[d];
+      }
+
+    bool overBudget = false;
+    while(!stack.empty())
+      {
+      Tile tile = stack.back();
+      stack.pop_back();
+
+      const unsigned long long numberOfPoints = this->CountPoints(tile.Lo, tile.Hi);
+      if(numberOfPoints == 0)
+        {
+        continue;
+        }
+
+      unsigned int loadedLo[3], loadedHi[3];
+      this->SetLoadedRegion(tile, loadedLo, loadedHi);
+      tile.NumberOfLoadedPoints = static_cast<std::size_t>(this->CountPoints(loadedLo, loadedHi));
+
+      int axis = -1;
+      for(unsigned int d = 0; d < this->Dimension; ++d)
+        {
+        if(tile.Hi[d] - tile.Lo[d] > 1 &&
+           (axis < 0 || (tile.Hi[d] - tile.Lo[d]) * this->CellSize[d] > (tile.Hi[axis] - tile.Lo[axis]) * this->CellSize[axis]))
+          {
+          axis = d;
+          }
+        }
+
+      if(tile.NumberOfLoadedPoints <= capacity || axis < 0)
+        {
+        overBudget = overBudget || tile.NumberOfLoadedPoints > capacity;
+        this->Tiles.push_back(tile);
+        continue;
+        }
+
+      // Split where half of the points of the tile are on either side
+      Tile lower = tile;
+      for(lower.Hi[axis] = tile.Lo[axis] + 1; lower.Hi[axis] < tile.Hi[axis] - 1; ++lower.Hi[axis])
+        {
+        if(2 * this->CountPoints(lower.Lo, lower.Hi) >= numberOfPoints)
+          {
+          break;
+          }
+        }
+      Tile upper = tile;
+      upper.Lo[axis] = lower.Hi[axis];
+      stack.push_back(upper);
+      stack.push_back(lower);
+      }
+
+    if(overBudget)
+      {
+      std::cerr << "Warning: some points are too densely packed to split into tiles that fit "
+                << "the memory budget, so the budget will be exceeded." << std::endl;
+      }
+  }
+
+  std::string GetScratchFileName(std::size_t tileId) const
+  {
+    std::stringstream fileName;
+    fileName << this->ScratchDirectory << "/tile" << tileId << ".tmp";
+    return fileName.str();
+  }
+
+  // Copy the points of the tiles [first, last) and their halos to scratch files
+  void SpillTiles(PointReader* reader, std::size_t first, std::size_t last)
+  {
+    // The tiles whose loaded region overlaps each histogram cell
+    const std::size_t numberOfCells = static_cast<std::size_t>(this->GridSize[0]) * this->GridSize[1] * this->GridSize[2];
+    std::vector<std::size_t> cellOffsets(numberOfCells + 1, 0);
+    std::vector<unsigned int> cellTiles;
+    std::vector<unsigned int> cellOwners(numberOfCells, static_cast<unsigned int>(-1));
+    for(unsigned int pass = 0; pass < 2; ++pass)
+      {
+      for(std::size_t tileId = first; tileId < last; ++tileId)
+        {
+        Tile& tile = this->Tiles[tileId];
+        unsigned int lo[3], hi[3];
+        this->SetLoadedRegion(tile, lo, hi);
+        for(unsigned int i = lo[0]; i < hi[0]; ++i)
+          {
+          for(unsigned int j = lo[1]; j < hi[1]; ++j)
+            {
+            for(unsigned int k = lo[2]; k < hi[2]; ++k)
+              {
+              std::size_t cell = (static_cast<std::size_t>(i) * this->GridSize[1] + j) * this->GridSize[2] + k;
+              if(pass == 0)
+                {
+                cellOffsets[cell + 1]++;
+                }
+              else
+                {
+                cellTiles[cellOffsets[cell]++] = static_cast<unsigned int>(tileId);
+                }
+              if(i >= tile.Lo[0] && i < tile.Hi[0] && j >= tile.Lo[1] && j < tile.Hi[1] && k >= tile.Lo[2] && k < tile.Hi[2])
+                {
+                cellOwners[cell] = static_cast<unsigned int>(tileId);
+                }
+              }
+            }
+          }
+        }
+
+      if(pass == 0)
+        {
+        for(std::size_t cell = 0; cell < numberOfCells; ++cell)
+          {
+          cellOffsets[cell + 1] += cellOffsets[cell];
+          }
+        cellTiles.resize(cellOffsets[numberOfCells]);
+        }
+      else
+        {
+        // The fill moved each offset to the start of the next cell
+        for(std::size_t cell = numberOfCells; cell > 0; --cell)
+          {
+          cellOffsets[cell] = cellOffsets[cell - 1];
+          }
+        cellOffsets[0] = 0;
+        }
+      }
+
+    std::vector<std::FILE*> files(last - first);
+    for(std::size_t tileId = first; tileId < last; ++tileId)
+      {
+      std::string fileName = this->GetScratchFileName(tileId);
+      files[tileId - first] = std::fopen(fileName.c_str(), "wb");
+      if(!files[tileId - first])
+        {
+        std::cerr << "Could not open the scratch file " << fileName << "!" << std::endl;
+        exit(-1);
+        }
+      std::setvbuf(files[tileId - first], 0, _IOFBF, SpillBufferSize);
+      }
+
+    std::vector<double> chunk(3 * ReadChunkSize);
+    unsigned long long pointId = 0;
+    reader->Start();
+    std::size_t numberRead;
+    while((numberRead = reader->Read(ReadChunkSize, &chunk[0])) > 0)
+      {
+      for(std::size_t i = 0; i < numberRead; ++i, ++pointId)
+        {
+        SpillRecord record;
+        std::copy(&chunk[3*i], &chunk[3*i] + 3, record.Point);
+
+        unsigned int cell[3];
+        this->GetCell(record.Point, cell);
+        std::size_t cellId = (static_cast<std::size_t>(cell[0]) * this->GridSize[1] + cell[1]) * this->GridSize[2] + cell[2];
+        // The owner of the cell gets the point whatever its loaded box says, since
+        // that box is computed differently from the cell and could round the point
+        // out of every tile. The other tiles get it if it is in their halo.
+        const unsigned int ownerId = cellOwners[cellId];
+        if(ownerId != static_cast<unsigned int>(-1))
+          {
+          record.Id = pointId | InteriorFlag;
+          std::fwrite(&record, sizeof(SpillRecord), 1, files[ownerId - first]);
+          }
+        record.Id = pointId;
+        for(std::size_t t = cellOffsets[cellId]; t < cellOffsets[cellId + 1]; ++t)
+          {
+          const unsigned int tileId = cellTiles[t];
+          if(tileId != ownerId && Contains(this->Tiles[tileId].Loaded, record.Point, 0.0, this->Dimension))
+            {
+            std::fwrite(&record, sizeof(SpillRecord), 1, files[tileId - first]);
+            }
+          }
+        }
+      }
+
+    for(std::size_t i = 0; i < files.size(); ++i)
+      {
+      std::fclose(files[i]);
+      }
+  }
+
+  // Whether the ball of radius 'radius' around 'point' is inside 'box'
+  static bool Contains(const double box[6], const double point[3], double radius, unsigned int dimension)
+  {
+    for(unsigned int d = 0; d < dimension; ++d)
+      {
+      if(point[d] - radius < box[2*d] || point[d] + radius > box[2*d + 1])
+        {
+        return false;
+        }
+      }
+    return true;
+  }
+
+  void ProcessTile(std::size_t tileId, TileNeighborQuery* query, std::FILE* output)
+  {
+    const Tile& tile = this->Tiles[tileId];
+
+    // Load the tile points
+    std::string fileName = this->GetScratchFileName(tileId);
+    std::FILE* file = std::fopen(fileName.c_str(), "rb");
+    if(!file)
+      {
+      std::cerr << "Could not open the scratch file " << fileName << "!" << std::endl;
+      exit(-1);
+      }
+    // The loaded count bounds what was spilled, so nothing grows past the budget
+    std::vector<double> xyz;
+    std::vector<unsigned long long> pointIds;
+    std::vector<std::size_t> interior;
+    xyz.reserve(3 * tile.NumberOfLoadedPoints);
+    pointIds.reserve(tile.NumberOfLoadedPoints);
+    interior.reserve(tile.NumberOfLoadedPoints);
+    SpillRecord record;
+    while(std::fread(&record, sizeof(SpillRecord), 1, file) == 1)
+      {
+      if(record.Id & InteriorFlag)
+        {
+        interior.push_back(pointIds.size());
+        }
+      pointIds.push_back(record.Id & ~InteriorFlag);
+      xyz.insert(xyz.end(), record.Point, record.Point + 3);
+      }
+    std::fclose(file);
+    std::remove(fileName.c_str());
+
+    this->LargestTileSize = std::max(this->LargestTileSize, pointIds.size());
+    query->SetTilePoints(xyz, this->Bounds);
+
+    std::vector<std::vector<std::size_t> > neighbors(QueryBlockSize);
+    std::vector<char> exact(QueryBlockSize);
+    std::vector<unsigned long long> neighborIds;
+    for(std::size_t begin = 0; begin < interior.size(); begin += QueryBlockSize)
+      {
+      const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(std::min(interior.size() - begin, std::size_t(QueryBlockSize)));
+
+#ifdef _OPENMP
+      int numberOfThreads = this->NumberOfThreads > 0 ? this->NumberOfThreads : omp_get_max_threads();
+#pragma omp parallel for num_threads(numberOfThreads) schedule(dynamic, 64)
+#endif
+      for(std::ptrdiff_t i = 0; i < count; ++i)
+        {
+        const std::size_t pointIndex = interior[begin + i];
+        neighbors[i].clear();
+        double radius = query->Query(pointIndex, neighbors[i]);
+        exact[i] = Contains(tile.Loaded, &xyz[3 * pointIndex], radius, this->Dimension);
+        }
+
+      // Write the block in order, so the output does not depend on the thread count
+      for(std::ptrdiff_t i = 0; i < count; ++i)
+        {
+        unsigned long long pointId = pointIds[interior[begin + i]];
+        unsigned int header[2] = {static_cast<unsigned int>(neighbors[i].size()), exact[i] ? 1u : 0u};
+        neighborIds.resize(neighbors[i].size());
+        for(std::size_t j = 0; j < neighbors[i].size(); ++j)
+          {
+          neighborIds[j] = pointIds[neighbors[i][j]];
+          }
+        std::fwrite(&pointId, sizeof(pointId), 1, output);
+        std::fwrite(header, sizeof(header), 1, output);
+        if(!neighborIds.empty())
+          {
+          std::fwrite(&neighborIds[0], sizeof(unsigned long long), neighborIds.size(), output);
+          }
+        this->NumberOfInexactPoints += exact[i] ? 0 : 1;
+        }
+      }
+  }
+
+  std::size_t MemoryBudget;
+  double HaloWidth;
+  std::string ScratchDirectory;
+  int NumberOfThreads;
+
+  unsigned int Dimension;
+  double Bounds[6];
+  unsigned int GridSize[3];
+  double CellSize[3];
+  std::vector<unsigned long long> CellCounts;
+  std::vector<Tile> Tiles;
+
+  unsigned long long NumberOfPoints;
+  unsigned long long NumberOfInexactPoints;
+  std::size_t LargestTileSize;
+};
+
+// Reads the records written by TiledNeighborSearch
+class NeighborRecordReader
+{
+public:
+  NeighborRecordReader(const std::string& fileName)
+  {
+    this->File = std::fopen(fileName.c_str(), "rb");
+    if(!this->File)
+      {
+      std::cerr << "Could not open " << fileName << "!" << std::endl;
+      exit(-1);
+      }
+  }
+
+  ~NeighborRecordReader()
+  {
+    std::fclose(this->File);
+  }
+
+  // Returns false at the end of the file
+  bool ReadNext(unsigned long long& pointId, std::vector<unsigned long long>& neighborIds, bool& exact)
+  {
+    unsigned int header[2];
+    if(std::fread(&pointId, sizeof(pointId), 1, this->File) != 1 ||
+       std::fread(header, sizeof(header), 1, this->File) != 1)
+      {
+      return false;
+      }
+    neighborIds.resize(header[0]);
+    exact = header[1] != 0;
+    return header[0] == 0 ||
+           std::fread(&neighborIds[0], sizeof(unsigned long long), header[0], this->File) == header[0];
+  }
+
+private:
+  // Not copyable, the file is closed by the destructor
+  NeighborRecordReader(const NeighborRecordReader&);
+  void operator=(const NeighborRecordReader&);
+
+  std::FILE* File;
+};
+
+// Writes records in the format of TiledNeighborSearch, for neighbors found some
+// other way, so one NeighborRecordReader reads both. A file that cannot be opened
+// or written ends the program, unless 'exitOnError' is false. Then Write() and
+// Close() return false, and the caller decides what to do with the file.
+class NeighborRecordWriter
+{
+public:
+  NeighborRecordWriter(const std::string& fileName, bool exitOnError = true)
+    : FileName(fileName), ExitOnError(exitOnError)
+  {
+    this->File = std::fopen(fileName.c_str(), "wb");
+    if(!this->File)
+      {
+      this->Fail("Could not open " + fileName + " for writing!");
+      }
+  }
+
+  ~NeighborRecordWriter()
+  {
+    this->Close();
+  }
+
+  bool Write(unsigned long long pointId, const std::vector<unsigned long long>& neighborIds, bool exact)
+  {
+    if(!this->File)
+      {
+      return false;
+      }
+    unsigned int header[2] = {static_cast<unsigned int>(neighborIds.size()), exact ? 1u : 0u};
+    bool written = std::fwrite(&pointId, sizeof(pointId), 1, this->File) == 1 &&
+                   std::fwrite(header, sizeof(header), 1, this->File) == 1 &&
+                   (neighborIds.empty() ||
+                    std::fwrite(&neighborIds[0], sizeof(unsigned long long), neighborIds.size(), this->File) ==
+                      neighborIds.size());
+    if(!written)
+      {
+      std::fclose(this->File);
+      this->File = 0;
+      this->Fail("Could not write " + this->FileName + "!");
+      }
+    return written;
+  }
+
+  // Flush and close the file, returns whether everything was written. A failed
+  // write has closed the file already.
+  bool Close()
+  {
+    if(!this->File)
+      {
+      return false;
+      }
+    const bool closed = std::fclose(this->File) == 0;
+    this->File = 0;
+    if(!closed)
+      {
+      this->Fail("Could not write " + this->FileName + "!");
+      }
+    return closed;
+  }
+
+private:
+  // Not copyable, the file is closed by the destructor
+  NeighborRecordWriter(const NeighborRecordWriter&);
+  void operator=(const NeighborRecordWriter&);
+
+  void Fail(const std::string& message) const
+  {
+    std::cerr << message << std::endl;
+    if(this->ExitOnError)
+      {
+      exit(-1);
+      }
+  }
+
+  std::string FileName;
+  bool ExitOnError;
+  std::FILE* File;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
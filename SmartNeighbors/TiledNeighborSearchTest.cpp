@@ -0,0 +1,245 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Checks that the tiled search gives every point of the cloud exactly one record,
+// and that the records it marks as exact hold the neighbors that a search over the
+// whole cloud finds: BSP neighbors in 3D, whose results depend on the ball of their
+// k nearest points, and Voronoi neighbors in 2D, whose results depend on the
+// security radius of their cells. The memory budgets split the cloud into several
+// tiles. Run by ctest, it prints each mismatch and fails if there are any.
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Custom
+#include "BSPNeighborSearch.h"
+#include "PointReader.h"
+#include "TestUtilities.h"
+#include "TiledNeighborSearch.h"
+#include "VoronoiNeighborSearch.h"
+
+namespace
+{
+const unsigned int K = 12;
+
+// The BSP neighbors of the points of a tile
+class BSPTileQuery : public SmartNeighbors::TileNeighborQuery
+{
+public:
+  typedef SmartNeighbors::BSPNeighborSearch<double, 3> SearchType;
+
+  BSPTileQuery()
+    : Search(0)
+  {
+  }
+
+  ~BSPTileQuery()
+  {
+    delete this->Search;
+  }
+
+  unsigned int GetDimension() const
+  {
+    return 3;
+  }
+
+  std::size_t GetBytesPerPoint() const
+  {
+    return 64;
+  }
+
+  void SetTilePoints(const std::vector<double>& xyz, const double[6])
+  {
+    delete this->Search;
+    this->Search = new SearchType(xyz.empty() ? 0 : &xyz[0], xyz.size() / 3);
+  }
+
+  double Query(std::size_t pointIndex, std::vector<std::size_t>& neighborIndices) const
+  {
+    std::vector<SearchType::NeighborType> kNearest;
+    this->Search->Query(pointIndex, K, neighborIndices, kNearest);
+    return kNearest.size() < K ? HUGE_VAL : std::sqrt(kNearest.back().Distance2);
+  }
+
+private:
+  BSPTileQuery(const BSPTileQuery&);
+  void operator=(const BSPTileQuery&);
+
+  SearchType* Search;
+};
+
+// The Voronoi neighbors in x and y of the points of a tile, clipped to the bounds
+// of the cloud
+class VoronoiTileQuery : public SmartNeighbors::TileNeighborQuery
+{
+public:
+  typedef SmartNeighbors::VoronoiNeighborSearch<double, 2> SearchType;
+
+  VoronoiTileQuery()
+    : Search(0)
+  {
+  }
+
+  ~VoronoiTileQuery()
+  {
+    delete this->Search;
+  }
+
+  unsigned int GetDimension() const
+  {
+    return 2;
+  }
+
+  std::size_t GetBytesPerPoint() const
+  {
+    return 64;
+  }
+
+  void SetTilePoints(const std::vector<double>& xyz, const double bounds[6])
+  {
+    delete this->Search;
+    this->Search = new SearchType(xyz.empty() ? 0 : &xyz[0], xyz.size() / 3, 3);
+    this->Search->SetBounds(bounds);
+  }
+
+  double Query(std::size_t pointIndex, std::vector<std::size_t>& neighborIndices) const
+  {
+    double securityRadius = 0;
+    this->Search->Query(pointIndex, neighborIndices, 16, 0, &securityRadius);
+    return securityRadius;
+  }
+
+private:
+  VoronoiTileQuery(const VoronoiTileQuery&);
+  void operator=(const VoronoiTileQuery&);
+
+  SearchType* Search;
+};
+
+// Run the tiled search with 'query' and compare its records with 'expected', the
+// neighbors of every point found over the whole cloud. Most of 'memoryBudget' goes
+// to buffers of a fixed size, so a budget a little over their size splits the
+// cloud into several tiles.
+void CheckTiles(const std::string& name, const std::vector<double>& points, SmartNeighbors::TileNeighborQuery* query,
+                std::size_t memoryBudget, const std::vector<std::vector<std::size_t> >& expected)
+{
+  const std::size_t numberOfPoints = points.size() / 3;
+  const std::string outputFileName = "TiledNeighborSearchTest.bin";
+
+  SmartNeighbors::MemoryPointReader reader(&points[0], numberOfPoints);
+  SmartNeighbors::TiledNeighborSearch search;
+  search.SetMemoryBudget(memoryBudget);
+  search.SetHaloWidth(0.1);
+  search.Run(&reader, query, outputFileName);
+  if(search.GetNumberOfTiles() < 4)
+    {
+    Fail(name + " tile count", "uniform", search.GetNumberOfTiles());
+    }
+
+  std::vector<unsigned int> numberOfRecords(numberOfPoints, 0);
+  unsigned long long numberOfInexactRecords = 0;
+  {
+  SmartNeighbors::NeighborRecordReader records(outputFileName);
+  unsigned long long pointId;
+  std::vector<unsigned long long> neighborIds;
+  bool exact;
+  while(records.ReadNext(pointId, neighborIds, exact))
+    {
+    if(pointId >= numberOfPoints)
+      {
+      Fail(name + " point id", "uniform", static_cast<std::size_t>(pointId));
+      continue;
+      }
+    numberOfRecords[pointId]++;
+    if(!exact)
+      {
+      numberOfInexactRecords++;
+      continue;
+      }
+    std::vector<std::size_t> found(neighborIds.begin(), neighborIds.end());
+    std::vector<std::size_t> expectedIds = expected[pointId];
+    std::sort(found.begin(), found.end());
+    std::sort(expectedIds.begin(), expectedIds.end());
+    if(found != expectedIds)
+      {
+      Fail(name + " exact record", "uniform", static_cast<std::size_t>(pointId));
+      }
+    }
+  }
+  std::remove(outputFileName.c_str());
+
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    if(numberOfRecords[id] != 1)
+      {
+      Fail(name + " record count", "uniform", id);
+      }
+    }
+  // The halo is several times the spacing of the points, so few results should
+  // depend on points beyond it
+  if(numberOfInexactRecords != search.GetNumberOfInexactPoints() || numberOfInexactRecords > numberOfPoints / 100)
+    {
+    Fail(name + " inexact count", "uniform", static_cast<std::size_t>(numberOfInexactRecords));
+    }
+}
+}
+
+int main(int, char *[])
+{
+  std::vector<double> points;
+  GenerateCloud("uniform", 20000, points);
+  const std::size_t numberOfPoints = points.size() / 3;
+
+  std::vector<std::vector<std::size_t> > expected(numberOfPoints);
+  {
+  SmartNeighbors::BSPNeighborSearch<double, 3> search(&points[0], numberOfPoints);
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    search.Query(id, K, expected[id]);
+    }
+  }
+  BSPTileQuery bspQuery;
+  CheckTiles("The tiled BSP search", points, &bspQuery, 20000000, expected);
+
+  // The bounds of the cloud, as the tiled search computes them
+  double bounds[6] = {points[0], points[0], points[1], points[1], points[2], points[2]};
+  for(std::size_t id = 1; id < numberOfPoints; ++id)
+    {
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      bounds[2 * d] = std::min(bounds[2 * d], points[3 * id + d]);
+      bounds[2 * d + 1] = std::max(bounds[2 * d + 1], points[3 * id + d]);
+      }
+    }
+  {
+  SmartNeighbors::VoronoiNeighborSearch<double, 2> search(&points[0], numberOfPoints, 3);
+  search.SetBounds(bounds);
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    search.Query(id, expected[id]);
+    }
+  }
+  VoronoiTileQuery voronoiQuery;
+  CheckTiles("The tiled Voronoi search", points, &voronoiQuery, 18000000, expected);
+
+  return ReportFailures();
+}
@@ -0,0 +1,423 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef UNIFORMGRID_H
+#define UNIFORMGRID_H
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Custom
+#include "PointIndex.h"
+
+namespace SmartNeighbors
+{
+
+// A uniform grid over the bounding box of the points, sized for a few points per
+// cell. The points are counting sorted by cell and copied in that order, so a cell
+// is one contiguous run of coordinates and the grid is built in linear time. A k
+// nearest search visits rings of cells around the query until no farther cell can
+// hold a nearer point. This beats the kd-tree when the sampling is close to uniform,
+// and degrades when many points share a few cells, see ChoosePointIndexType().
+template <typename TScalar, unsigned int Dimension>
+class UniformGrid : public PointIndex<TScalar, Dimension>
+{
+public:
+  typedef PointIndex<TScalar, Dimension> Superclass;
+  typedef typename Superclass::NeighborType NeighborType;
+
+  // The number of points per cell that the grid is sized for
+  static const unsigned int PointsPerCell = 4;
+
+  UniformGrid(const TScalar* points, std::size_t numberOfPoints, unsigned int stride = Dimension)
+    : Superclass(points, numberOfPoints, stride)
+  {
+    ComputeGeometry(points, numberOfPoints, stride, this->Origin, this->Spacing, this->Size);
+    std::size_t numberOfCells = 1;
+    double magnitude = 0;
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      numberOfCells *= this->Size[d];
+      magnitude = std::max(magnitude, std::fabs(this->Origin[d]) + this->Size[d] * this->Spacing[d]);
+      }
+    this->Slack = 64 * std::numeric_limits<double>::epsilon() * magnitude;
+
+    // Counting sort of the points by cell
+    std::vector<std::size_t> cellIds(numberOfPoints);
+    this->Offsets.assign(numberOfCells + 1, 0);
+    for(std::size_t i = 0; i < numberOfPoints; ++i)
+      {
+      cellIds[i] = this->GetCellId(this->GetPoint(i));
+      this->Offsets[cellIds[i] + 1]++;
+      }
+    for(std::size_t cell = 0; cell < numberOfCells; ++cell)
+      {
+      this->Offsets[cell + 1] += this->Offsets[cell];
+      }
+
+    std::vector<std::size_t> next(this->Offsets.begin(), this->Offsets.end() - 1);
+    this->SortedIds.resize(numberOfPoints);
+    this->SortedPoints.resize(numberOfPoints * Dimension);
+    for(std::size_t i = 0; i < numberOfPoints; ++i)
+      {
+      const std::size_t position = next[cellIds[i]]++;
+      this->SortedIds[position] = i;
+      const TScalar* p = this->GetPoint(i);
+      std::copy(p, p + Dimension, &this->SortedPoints[position * Dimension]);
+      }
+  }
+
+  void FindKNearest(const TScalar* query, unsigned int k, std::vector<NeighborType>& nearest,
+                    std::size_t excludeId = Superclass::NoId) const
+  {
+    this->FindKNearestApproximate(query, k, SearchBudget(), nearest, excludeId);
+  }
+
+  void FindKNearestApproximate(const TScalar* query, unsigned int k, const SearchBudget& budget,
+                               std::vector<NeighborType>& nearest, std::size_t excludeId = Superclass::NoId) const
+  {
+    nearest.clear();
+    if(k == 0 || this->NumberOfPoints == 0)
+      {
+      return;
+      }
+    nearest.reserve(k);
+
+    const double scale = std::max(1.0, (1 + budget.Epsilon) * (1 + budget.Epsilon));
+    Search search = {query, excludeId, &nearest, k, 0, 0, scale,
+                     budget.MaxDistanceEvaluations > 0 ? budget.MaxDistanceEvaluations : ~std::size_t(0)};
+    unsigned int center[Dimension];
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      center[d] = this->GetCellIndex(query, d);
+      }
+
+    for(unsigned int ring = 0; ; ++ring)
+      {
+      unsigned int cell[Dimension];
+      if(!this->SearchRing(center, ring, 0, false, cell, search))
+        {
+        break;
+        }
+
+      // A point exactly at the bound could still win a tie on its id
+      const double bound = this->GetSearchedDistance(center, ring, query);
+      const double distance2 = nearest.size() == k ? nearest.front().Distance2 : HUGE_VAL;
+      if(bound == HUGE_VAL ||
+         (bound > 0 && distance2 * (1 + 16 * std::numeric_limits<TScalar>::epsilon()) < bound * bound * scale))
+        {
+        break;
+        }
+      }
+    std::sort_heap(nearest.begin(), nearest.end());
+  }
+
+  void FindInRadius(const TScalar* query, TScalar radius, std::size_t maxCount, std::vector<NeighborType>& neighbors,
+                    std::size_t excludeId = Superclass::NoId) const
+  {
+    neighbors.clear();
+    if(this->NumberOfPoints == 0 || !(radius >= 0))
+      {
+      return;
+      }
+
+    Search search = {query, excludeId, &neighbors, 0, radius * radius, maxCount, 1, 0};
+    unsigned int center[Dimension];
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      center[d] = this->GetCellIndex(query, d);
+      }
+
+    for(unsigned int ring = 0; ; ++ring)
+      {
+      unsigned int cell[Dimension];
+      if(!this->SearchRing(center, ring, 0, false, cell, search))
+        {
+        break;
+        }
+      const double bound = this->GetSearchedDistance(center, ring, query);
+      if(bound == HUGE_VAL || bound > radius)
+        {
+        break;
+        }
+      }
+    std::sort(neighbors.begin(), neighbors.end());
+  }
+
+  // The grid that UniformGrid would build over these points: its lower corner, the
+  // size of a cell and the number of cells along each axis. Axes that are thinner
+  // than a cell, such as the normal of a planar scan, get a single cell, so there
+  // are at most 2^Dimension times as many cells as the grid is sized for.
+  static void ComputeGeometry(const TScalar* points, std::size_t numberOfPoints, unsigned int stride,
+                              double origin[Dimension], double spacing[Dimension], unsigned int size[Dimension])
+  {
+    double upper[Dimension];
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      origin[d] = numberOfPoints > 0 ? points[d] : 0;
+      upper[d] = origin[d];
+      }
+    for(std::size_t i = 1; i < numberOfPoints; ++i)
+      {
+      const TScalar* p = points + i * stride;
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        origin[d] = std::min(origin[d], static_cast<double>(p[d]));
+        upper[d] = std::max(upper[d], static_cast<double>(p[d]));
+        }
+      }
+
+    // Cube cells over the axes that are at least a cell thick, so that the box holds
+    // about PointsPerCell points per cell if they fill it. Flattening an axis makes
+    // the cells larger, which can flatten another.
+    const double numberOfCells = std::max(1.0, static_cast<double>(numberOfPoints) / PointsPerCell);
+    bool flat[Dimension];
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      flat[d] = !(upper[d] > origin[d]);
+      }
+    double cellSize = 1;
+    for(bool flattened = true; flattened; )
+      {
+      double volume = 1;
+      unsigned int extendedAxes = 0;
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        if(!flat[d])
+          {
+          volume *= upper[d] - origin[d];
+          extendedAxes++;
+          }
+        }
+      cellSize = extendedAxes > 0 ? std::pow(volume / numberOfCells, 1.0 / extendedAxes) : 1;
+
+      flattened = false;
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        if(!flat[d] && upper[d] - origin[d] < cellSize)
+          {
+          flat[d] = true;
+          flattened = true;
+          }
+        }
+      }
+
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      const double extent = upper[d] - origin[d];
+      size[d] = 1;
+      if(!flat[d])
+        {
+        size[d] = static_cast<unsigned int>(std::max(1.0, std::ceil(extent / cellSize)));
+        }
+      spacing[d] = extent > 0 ? extent / size[d] : 1;
+      }
+  }
+
+  std::size_t GetMemorySize() const
+  {
+    return this->Offsets.capacity() * sizeof(std::size_t) + this->SortedIds.capacity() * sizeof(std::size_t) +
+           this->SortedPoints.capacity() * sizeof(TScalar);
+  }
+
+private:
+  unsigned int GetCellIndex(const TScalar* p, unsigned int d) const
+  {
+    const double position = (p[d] - this->Origin[d]) / this->Spacing[d];
+    if(!(position > 0))
+      {
+      return 0;
+      }
+    return static_cast<unsigned int>(std::min(position, static_cast<double>(this->Size[d] - 1)));
+  }
+
+  std::size_t GetCellId(const TScalar* p) const
+  {
+    std::size_t cellId = 0;
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      cellId = cellId * this->Size[d] + this->GetCellIndex(p, d);
+      }
+    return cellId;
+  }
+
+  // A search in progress, for the k nearest points if K is nonzero and for the
+  // points within a radius otherwise. A k nearest search skips the cells that are
+  // farther than the kth candidate over Scale, the square of 1 + epsilon, and stops
+  // once RemainingEvaluations runs out.
+  struct Search
+  {
+    const TScalar* Query;
+    std::size_t ExcludeId;
+    std::vector<NeighborType>* Neighbors;
+    unsigned int K;
+    TScalar Radius2;
+    std::size_t MaxCount;
+    double Scale;
+    std::size_t RemainingEvaluations;
+  };
+
+  // Every point outside the cells within 'ring' cells of 'center' is at least this
+  // far from the query, the distance to the nearest face of their box that is not
+  // on the boundary of the grid. The bound is loosened by the rounding of the cell
+  // of each point. HUGE_VAL means that the box is the whole grid.
+  double GetSearchedDistance(const unsigned int* center, unsigned int ring, const TScalar* query) const
+  {
+    double bound = HUGE_VAL;
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      if(center[d] > ring)
+        {
+        const double face = this->Origin[d] + (center[d] - ring) * this->Spacing[d];
+        bound = std::min(bound, query[d] - face - this->Slack);
+        }
+      if(center[d] + ring + 1 < this->Size[d])
+        {
+        const double face = this->Origin[d] + (center[d] + ring + 1) * this->Spacing[d];
+        bound = std::min(bound, face - query[d] - this->Slack);
+        }
+      }
+    return bound;
+  }
+
+  // Search the cells at a Chebyshev distance of exactly 'ring' cells from 'center'.
+  // The axes are walked in order, and once none of the earlier axes is on the ring
+  // only the two cells at the ends of the last axis are. Returns false once a radius
+  // search has found its maximum count, or a k nearest search has run out of
+  // distance evaluations.
+  bool SearchRing(const unsigned int* center, unsigned int ring, unsigned int axis, bool onRing, unsigned int* cell,
+                  Search& search) const
+  {
+    const unsigned int lower = center[axis] > ring ? center[axis] - ring : 0;
+    const unsigned int upper = std::min(center[axis] + ring, this->Size[axis] - 1);
+    if(axis + 1 < Dimension)
+      {
+      for(cell[axis] = lower; cell[axis] <= upper; ++cell[axis])
+        {
+        const bool atEnd = cell[axis] + ring == center[axis] || cell[axis] == center[axis] + ring;
+        if(!this->SearchRing(center, ring, axis + 1, onRing || atEnd, cell, search))
+          {
+          return false;
+          }
+        }
+      return true;
+      }
+
+    if(onRing)
+      {
+      for(cell[axis] = lower; cell[axis] <= upper; ++cell[axis])
+        {
+        if(!this->SearchCell(cell, search))
+          {
+          return false;
+          }
+        }
+      return true;
+      }
+    if(center[axis] >= ring)
+      {
+      cell[axis] = center[axis] - ring;
+      if(!this->SearchCell(cell, search))
+        {
+        return false;
+        }
+      }
+    if(ring > 0 && center[axis] + ring < this->Size[axis])
+      {
+      cell[axis] = center[axis] + ring;
+      return this->SearchCell(cell, search);
+      }
+    return true;
+  }
+
+  bool SearchCell(const unsigned int* cell, Search& search) const
+  {
+    // Skip cells that are strictly farther than the kth candidate so far, or than
+    // the radius
+    std::size_t cellId = 0;
+    double cellDistance2 = 0;
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      cellId = cellId * this->Size[d] + cell[d];
+      const double lower = this->Origin[d] + cell[d] * this->Spacing[d];
+      const double gap = std::max(lower - search.Query[d], search.Query[d] - (lower + this->Spacing[d]));
+      if(gap > this->Slack)
+        {
+        cellDistance2 += (gap - this->Slack) * (gap - this->Slack);
+        }
+      }
+    std::vector<NeighborType>& neighbors = *search.Neighbors;
+    const double tolerance = 1 + 16 * std::numeric_limits<TScalar>::epsilon();
+    if(search.K > 0)
+      {
+      if(neighbors.size() == search.K && neighbors.front().Distance2 * tolerance < cellDistance2 * search.Scale)
+        {
+        return true;
+        }
+      }
+    else if(search.Radius2 * tolerance < cellDistance2)
+      {
+      return true;
+      }
+
+    for(std::size_t i = this->Offsets[cellId]; i < this->Offsets[cellId + 1]; ++i)
+      {
+      const std::size_t id = this->SortedIds[i];
+      if(id == search.ExcludeId)
+        {
+        continue;
+        }
+      NeighborType candidate = {id, Distance2<TScalar, Dimension>(&this->SortedPoints[i * Dimension], search.Query)};
+      if(search.K > 0)
+        {
+        InsertNeighbor(neighbors, search.K, candidate);
+        if(--search.RemainingEvaluations == 0)
+          {
+          return false;
+          }
+        }
+      else if(candidate.Distance2 <= search.Radius2)
+        {
+        neighbors.push_back(candidate);
+        if(neighbors.size() == search.MaxCount)
+          {
+          return false;
+          }
+        }
+      }
+    return true;
+  }
+
+  double Origin[Dimension];
+  double Spacing[Dimension];
+  unsigned int Size[Dimension];
+  double Slack;
+
+  // The points of cell c are [Offsets[c], Offsets[c + 1]) of SortedIds and SortedPoints
+  std::vector<std::size_t> Offsets;
+  std::vector<std::size_t> SortedIds;
+  std::vector<TScalar> SortedPoints;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,230 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef VORONOICELL2D_H
+#define VORONOICELL2D_H
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace SmartNeighbors
+{
+
+// The Voronoi cell of one point in the plane, built locally. The cell starts as
+// a box and is clipped by the bisector of the center and each nearby point in turn.
+// Whatever is left after all of the points that could matter have been used is the
+// exact cell of the center, and the points that define its edges are its Voronoi
+// neighbors.
+//
+// Coordinates are stored relative to the center to keep the clipping accurate far
+// from the origin. Each edge remembers the id of the point whose bisector created it,
+// edges of the initial box have id -1.
+class VoronoiCell2D
+{
+public:
+  typedef long long IdType;
+
+  // Start from the box [bounds[0], bounds[1]] x [bounds[2], bounds[3]], which must contain the center
+  void Initialize(const double center[2], const double bounds[4])
+  {
+    this->Center[0] = center[0];
+    this->Center[1] = center[1];
+    this->X.clear();
+    this->Y.clear();
+    this->EdgeIds.clear();
+
+    // Counter clockwise, vertex i is the start of edge i
+    const double corners[4][2] = {{bounds[0], bounds[2]}, {bounds[1], bounds[2]},
+                                  {bounds[1], bounds[3]}, {bounds[0], bounds[3]}};
+    for(unsigned int i = 0; i < 4; ++i)
+      {
+      this->X.push_back(corners[i][0] - center[0]);
+      this->Y.push_back(corners[i][1] - center[1]);
+      this->EdgeIds.push_back(-1);
+      }
+  }
+
+  // Keep the part of the cell that is at least as close to the center as to 'point'.
+  // Returns true if anything was cut off. A point at the center does not cut anything.
+  bool Clip(const double point[2], IdType pointId)
+  {
+    const double dx = point[0] - this->Center[0];
+    const double dy = point[1] - this->Center[1];
+    const double offset = 0.5 * (dx * dx + dy * dy);
+    if(offset == 0.0)
+      {
+      return false;
+      }
+
+    // Vertices with side > 0 are strictly closer to 'point'
+    const std::size_t numberOfVertices = this->X.size();
+    this->Side.resize(numberOfVertices);
+    bool cut = false;
+    for(std::size_t i = 0; i < numberOfVertices; ++i)
+      {
+      this->Side[i] = this->X[i] * dx + this->Y[i] * dy - offset;
+      cut = cut || this->Side[i] > 0.0;
+      }
+    if(!cut)
+      {
+      return false;
+      }
+
+    this->NewX.clear();
+    this->NewY.clear();
+    this->NewEdgeIds.clear();
+    for(std::size_t i = 0; i < numberOfVertices; ++i)
+      {
+      const std::size_t next = (i + 1) % numberOfVertices;
+      const double sa = this->Side[i];
+      const double sb = this->Side[next];
+      if(sa <= 0.0)
+        {
+        // A vertex exactly on the bisector where the cell leaves the halfplane starts the new edge
+        bool leaving = sb > 0.0;
+        this->NewX.push_back(this->X[i]);
+        this->NewY.push_back(this->Y[i]);
+        this->NewEdgeIds.push_back(leaving && sa == 0.0 ? pointId : this->EdgeIds[i]);
+        if(leaving && sa < 0.0)
+          {
+          this->AddIntersection(i, next, sa, sb, pointId);
+          }
+        }
+      else if(sb < 0.0)
+        {
+        // Entering the halfplane, the rest of edge i is kept
+        this->AddIntersection(i, next, sa, sb, this->EdgeIds[i]);
+        }
+      }
+
+    this->X.swap(this->NewX);
+    this->Y.swap(this->NewY);
+    this->EdgeIds.swap(this->NewEdgeIds);
+    return true;
+  }
+
+  // Squared distance from the center to the farthest vertex. A point farther than
+  // twice this distance from the center cannot cut the cell.
+  double GetSecurityRadius2() const
+  {
+    double maxRadius2 = 0.0;
+    for(std::size_t i = 0; i < this->X.size(); ++i)
+      {
+      maxRadius2 = std::max(maxRadius2, this->X[i] * this->X[i] + this->Y[i] * this->Y[i]);
+      }
+    return 4.0 * maxRadius2;
+  }
+
+  std::size_t GetNumberOfVertices() const
+  {
+    return this->X.size();
+  }
+
+  // Vertex i in absolute coordinates. Edge i runs from vertex i to vertex i+1.
+  void GetVertex(std::size_t i, double vertex[2]) const
+  {
+    vertex[0] = this->X[i] + this->Center[0];
+    vertex[1] = this->Y[i] + this->Center[1];
+  }
+
+  IdType GetEdgeId(std::size_t i) const
+  {
+    return this->EdgeIds[i];
+  }
+
+  double GetEdgeLength(std::size_t i) const
+  {
+    const std::size_t next = (i + 1) % this->X.size();
+    const double dx = this->X[next] - this->X[i];
+    const double dy = this->Y[next] - this->Y[i];
+    return std::sqrt(dx * dx + dy * dy);
+  }
+
+  double GetArea() const
+  {
+    double twiceArea = 0.0;
+    for(std::size_t i = 0; i < this->X.size(); ++i)
+      {
+      const std::size_t next = (i + 1) % this->X.size();
+      twiceArea += this->X[i] * this->Y[next] - this->X[next] * this->Y[i];
+      }
+    return 0.5 * twiceArea;
+  }
+
+  // GetNeighborIds() with the length of the edge that each neighbor shares with the cell
+  void GetNeighbors(std::vector<IdType>& neighborIds, std::vector<double>& edgeLengths,
+                    double relativeTolerance = 1e-10) const
+  {
+    neighborIds.clear();
+    edgeLengths.clear();
+    const double minimumLength = relativeTolerance * std::sqrt(this->GetSecurityRadius2());
+    for(std::size_t i = 0; i < this->X.size(); ++i)
+      {
+      const double length = this->GetEdgeLength(i);
+      if(this->EdgeIds[i] >= 0 && length > minimumLength)
+        {
+        neighborIds.push_back(this->EdgeIds[i]);
+        edgeLengths.push_back(length);
+        }
+      }
+  }
+
+  // The ids of the points that define an edge of the cell, counter clockwise.
+  // Edges shorter than 'relativeTolerance' times the cell size only touch the
+  // cell at a vertex and are skipped.
+  void GetNeighborIds(std::vector<IdType>& neighborIds, double relativeTolerance = 1e-10) const
+  {
+    neighborIds.clear();
+    const double minimumLength = relativeTolerance * std::sqrt(this->GetSecurityRadius2());
+    for(std::size_t i = 0; i < this->X.size(); ++i)
+      {
+      if(this->EdgeIds[i] < 0 || this->GetEdgeLength(i) <= minimumLength)
+        {
+        continue;
+        }
+      // A bisector can only contribute one edge to a convex cell
+      neighborIds.push_back(this->EdgeIds[i]);
+      }
+  }
+
+private:
+  void AddIntersection(std::size_t i, std::size_t next, double sa, double sb, IdType edgeId)
+  {
+    const double t = sa / (sa - sb);
+    this->NewX.push_back(this->X[i] + t * (this->X[next] - this->X[i]));
+    this->NewY.push_back(this->Y[i] + t * (this->Y[next] - this->Y[i]));
+    this->NewEdgeIds.push_back(edgeId);
+  }
+
+  double Center[2];
+  std::vector<double> X;
+  std::vector<double> Y;
+  std::vector<IdType> EdgeIds;
+
+  // Scratch space reused by every clip
+  std::vector<double> Side;
+  std::vector<double> NewX;
+  std::vector<double> NewY;
+  std::vector<IdType> NewEdgeIds;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
@@ -0,0 +1,425 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef VORONOICELL3D_H
+#define VORONOICELL3D_H
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace SmartNeighbors
+{
+
+// The Voronoi cell of one point in space, built locally. This is the 3D version of
+// VoronoiCell2D: the cell starts as a box and is clipped by the bisector plane of the
+// center and each nearby point in turn, and the points that define its faces are its
+// Voronoi neighbors.
+//
+// The cell is a convex polyhedron stored as a list of vertices, relative to the center,
+// and a list of faces. Each face is a polygon of vertex indices, counter clockwise seen
+// from outside the cell, and remembers the id of the point whose bisector created it.
+// Faces of the initial box have id -1.
+class VoronoiCell3D
+{
+public:
+  typedef long long IdType;
+
+  // Start from the box given as {xmin, xmax, ymin, ymax, zmin, zmax}, which must contain the center
+  void Initialize(const double center[3], const double bounds[6])
+  {
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      this->Center[d] = center[d];
+      }
+
+    this->Vertices.clear();
+    for(unsigned int i = 0; i < 8; ++i)
+      {
+      this->Vertices.push_back(bounds[(i & 1) ? 1 : 0] - center[0]);
+      this->Vertices.push_back(bounds[(i & 2) ? 3 : 2] - center[1]);
+      this->Vertices.push_back(bounds[(i & 4) ? 5 : 4] - center[2]);
+      }
+
+    // Vertex i has x from bit 0, y from bit 1 and z from bit 2
+    const unsigned int faces[6][4] = {{0, 4, 6, 2}, {1, 3, 7, 5},   // -x, +x
+                                      {0, 1, 5, 4}, {2, 6, 7, 3},   // -y, +y
+                                      {0, 2, 3, 1}, {4, 5, 7, 6}};  // -z, +z
+    this->FaceOffsets.assign(1, 0);
+    this->FaceVertices.clear();
+    this->FaceIds.assign(6, -1);
+    for(unsigned int f = 0; f < 6; ++f)
+      {
+      this->FaceVertices.insert(this->FaceVertices.end(), faces[f], faces[f] + 4);
+      this->FaceOffsets.push_back(this->FaceVertices.size());
+      }
+  }
+
+  // Keep the part of the cell that is at least as close to the center as to 'point'.
+  // Returns true if anything was cut off. A point at the center does not cut anything.
+  bool Clip(const double point[3], IdType pointId)
+  {
+    double normal[3];
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      normal[d] = point[d] - this->Center[d];
+      }
+    const double offset = 0.5 * Dot(normal, normal);
+    if(offset == 0.0)
+      {
+      return false;
+      }
+
+    // Vertices with side > 0 are strictly closer to 'point'
+    const std::size_t numberOfVertices = this->Vertices.size() / 3;
+    this->Side.resize(numberOfVertices);
+    bool cut = false;
+    for(std::size_t i = 0; i < numberOfVertices; ++i)
+      {
+      this->Side[i] = Dot(&this->Vertices[3*i], normal) - offset;
+      cut = cut || this->Side[i] > 0.0;
+      }
+    if(!cut)
+      {
+      return false;
+      }
+
+    // Clip every face. Edges that cross the plane get one new vertex, shared by the
+    // two faces on either side of the edge.
+    this->CrossedEdges.clear();
+    this->CapVertices.clear();
+    this->NewFaceOffsets.assign(1, 0);
+    this->NewFaceVertices.clear();
+    this->NewFaceIds.clear();
+    for(std::size_t f = 0; f + 1 < this->FaceOffsets.size(); ++f)
+      {
+      const std::size_t begin = this->FaceOffsets[f];
+      const std::size_t count = this->FaceOffsets[f + 1] - begin;
+      const std::size_t faceStart = this->NewFaceVertices.size();
+      for(std::size_t i = 0; i < count; ++i)
+        {
+        const unsigned int a = this->FaceVertices[begin + i];
+        const unsigned int b = this->FaceVertices[begin + (i + 1) % count];
+        const double sa = this->Side[a];
+        const double sb = this->Side[b];
+        if(sa <= 0.0)
+          {
+          this->NewFaceVertices.push_back(a);
+          if(sa == 0.0)
+            {
+            this->CapVertices.push_back(a);
+            }
+          else if(sb > 0.0)
+            {
+            this->NewFaceVertices.push_back(this->EdgeVertex(a, b));
+            }
+          }
+        else if(sb < 0.0)
+          {
+          this->NewFaceVertices.push_back(this->EdgeVertex(a, b));
+          }
+        }
+
+      // Faces cut down to an edge or a point are gone
+      if(this->NewFaceVertices.size() - faceStart < 3)
+        {
+        this->NewFaceVertices.resize(faceStart);
+        continue;
+        }
+      this->NewFaceOffsets.push_back(this->NewFaceVertices.size());
+      this->NewFaceIds.push_back(this->FaceIds[f]);
+      }
+
+    this->AddCap(normal, pointId);
+
+    this->FaceOffsets.swap(this->NewFaceOffsets);
+    this->FaceVertices.swap(this->NewFaceVertices);
+    this->FaceIds.swap(this->NewFaceIds);
+    this->RemoveUnusedVertices();
+    return true;
+  }
+
+  // Squared distance from the center to the farthest vertex times four. A point whose
+  // squared distance from the center is at least this cannot cut the cell.
+  double GetSecurityRadius2() const
+  {
+    double maxRadius2 = 0.0;
+    for(std::size_t i = 0; i < this->Vertices.size(); i += 3)
+      {
+      maxRadius2 = std::max(maxRadius2, Dot(&this->Vertices[i], &this->Vertices[i]));
+      }
+    return 4.0 * maxRadius2;
+  }
+
+  std::size_t GetNumberOfVertices() const
+  {
+    return this->Vertices.size() / 3;
+  }
+
+  // Vertex i in absolute coordinates
+  void GetVertex(std::size_t i, double vertex[3]) const
+  {
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      vertex[d] = this->Vertices[3*i + d] + this->Center[d];
+      }
+  }
+
+  std::size_t GetNumberOfFaces() const
+  {
+    return this->FaceIds.size();
+  }
+
+  IdType GetFaceId(std::size_t f) const
+  {
+    return this->FaceIds[f];
+  }
+
+  // The vertex indices of face f
+  const unsigned int* FaceBegin(std::size_t f) const
+  {
+    return &this->FaceVertices[0] + this->FaceOffsets[f];
+  }
+
+  const unsigned int* FaceEnd(std::size_t f) const
+  {
+    return &this->FaceVertices[0] + this->FaceOffsets[f + 1];
+  }
+
+  double GetFaceArea(std::size_t f) const
+  {
+    double areaVector[3] = {0.0, 0.0, 0.0};
+    const unsigned int* begin = this->FaceBegin(f);
+    const std::size_t count = this->FaceEnd(f) - begin;
+    const double* origin = &this->Vertices[3 * begin[0]];
+    for(std::size_t i = 1; i + 1 < count; ++i)
+      {
+      double u[3], v[3], n[3];
+      for(unsigned int d = 0; d < 3; ++d)
+        {
+        u[d] = this->Vertices[3 * begin[i] + d] - origin[d];
+        v[d] = this->Vertices[3 * begin[i + 1] + d] - origin[d];
+        }
+      Cross(u, v, n);
+      for(unsigned int d = 0; d < 3; ++d)
+        {
+        areaVector[d] += n[d];
+        }
+      }
+    return 0.5 * std::sqrt(Dot(areaVector, areaVector));
+  }
+
+  // The volume of the cell, as the sum of the cones from the center over its faces
+  double GetVolume() const
+  {
+    double sixTimesVolume = 0.0;
+    for(std::size_t f = 0; f < this->FaceIds.size(); ++f)
+      {
+      const unsigned int* begin = this->FaceBegin(f);
+      const std::size_t count = this->FaceEnd(f) - begin;
+      const double* origin = &this->Vertices[3 * begin[0]];
+      for(std::size_t i = 1; i + 1 < count; ++i)
+        {
+        double n[3];
+        Cross(&this->Vertices[3 * begin[i]], &this->Vertices[3 * begin[i + 1]], n);
+        sixTimesVolume += Dot(origin, n);
+        }
+      }
+    return sixTimesVolume / 6.0;
+  }
+
+  // GetNeighborIds() with the area of the face that each neighbor shares with the cell
+  void GetNeighbors(std::vector<IdType>& neighborIds, std::vector<double>& faceAreas,
+                    double relativeTolerance = 1e-10) const
+  {
+    neighborIds.clear();
+    faceAreas.clear();
+    const double minimumArea = relativeTolerance * this->GetSecurityRadius2();
+    for(std::size_t f = 0; f < this->FaceIds.size(); ++f)
+      {
+      const double area = this->FaceIds[f] < 0 ? 0.0 : this->GetFaceArea(f);
+      if(this->FaceIds[f] >= 0 && area > minimumArea)
+        {
+        neighborIds.push_back(this->FaceIds[f]);
+        faceAreas.push_back(area);
+        }
+      }
+  }
+
+  // The ids of the points that define a face of the cell. Faces with an area below
+  // 'relativeTolerance' times the squared cell size only touch the cell along an
+  // edge or at a vertex and are skipped.
+  void GetNeighborIds(std::vector<IdType>& neighborIds, double relativeTolerance = 1e-10) const
+  {
+    neighborIds.clear();
+    const double minimumArea = relativeTolerance * this->GetSecurityRadius2();
+    for(std::size_t f = 0; f < this->FaceIds.size(); ++f)
+      {
+      if(this->FaceIds[f] < 0 || this->GetFaceArea(f) <= minimumArea)
+        {
+        continue;
+        }
+      // A bisector can only contribute one face to a convex cell
+      neighborIds.push_back(this->FaceIds[f]);
+      }
+  }
+
+private:
+  static double Dot(const double a[3], const double b[3])
+  {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  }
+
+  static void Cross(const double a[3], const double b[3], double c[3])
+  {
+    c[0] = a[1] * b[2] - a[2] * b[1];
+    c[1] = a[2] * b[0] - a[0] * b[2];
+    c[2] = a[0] * b[1] - a[1] * b[0];
+  }
+
+  // The vertex where the edge (a, b) crosses the plane, created the first time either
+  // of the two faces sharing the edge asks for it
+  unsigned int EdgeVertex(unsigned int a, unsigned int b)
+  {
+    const std::pair<unsigned int, unsigned int> edge(std::min(a, b), std::max(a, b));
+    for(std::size_t i = 0; i < this->CrossedEdges.size(); ++i)
+      {
+      if(this->CrossedEdges[i].first == edge)
+        {
+        return this->CrossedEdges[i].second;
+        }
+      }
+
+    // Interpolate from the inside vertex so the result does not depend on the edge direction
+    const unsigned int inside = this->Side[edge.first] <= 0.0 ? edge.first : edge.second;
+    const unsigned int outside = inside == edge.first ? edge.second : edge.first;
+    const double t = this->Side[inside] / (this->Side[inside] - this->Side[outside]);
+    const unsigned int vertex = static_cast<unsigned int>(this->Vertices.size() / 3);
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      const double x = this->Vertices[3*inside + d];
+      this->Vertices.push_back(x + t * (this->Vertices[3*outside + d] - x));
+      }
+    this->Side.push_back(0.0);
+    this->CrossedEdges.push_back(std::make_pair(edge, vertex));
+    this->CapVertices.push_back(vertex);
+    return vertex;
+  }
+
+  // Close the cell with a new face in the clipping plane. The face is convex, so its
+  // vertices are put in order by their angle around its centroid.
+  void AddCap(const double normal[3], IdType pointId)
+  {
+    std::sort(this->CapVertices.begin(), this->CapVertices.end());
+    this->CapVertices.erase(std::unique(this->CapVertices.begin(), this->CapVertices.end()),
+                            this->CapVertices.end());
+    if(this->CapVertices.size() < 3)
+      {
+      return;
+      }
+
+    double centroid[3] = {0.0, 0.0, 0.0};
+    for(std::size_t i = 0; i < this->CapVertices.size(); ++i)
+      {
+      for(unsigned int d = 0; d < 3; ++d)
+        {
+        centroid[d] += this->Vertices[3 * this->CapVertices[i] + d];
+        }
+      }
+    for(unsigned int d = 0; d < 3; ++d)
+      {
+      centroid[d] /= this->CapVertices.size();
+      }
+
+    // An orthogonal basis of the plane with u x v along the outward normal
+    double u[3] = {0.0, 0.0, 0.0};
+    unsigned int smallest = 0;
+    for(unsigned int d = 1; d < 3; ++d)
+      {
+      if(std::fabs(normal[d]) < std::fabs(normal[smallest]))
+        {
+        smallest = d;
+        }
+      }
+    u[smallest] = 1.0;
+    double v[3];
+    Cross(normal, u, v);
+    Cross(v, normal, u);
+
+    this->CapAngles.clear();
+    for(std::size_t i = 0; i < this->CapVertices.size(); ++i)
+      {
+      double r[3];
+      for(unsigned int d = 0; d < 3; ++d)
+        {
+        r[d] = this->Vertices[3 * this->CapVertices[i] + d] - centroid[d];
+        }
+      this->CapAngles.push_back(std::make_pair(std::atan2(Dot(r, v), Dot(r, u)), this->CapVertices[i]));
+      }
+    std::sort(this->CapAngles.begin(), this->CapAngles.end());
+
+    for(std::size_t i = 0; i < this->CapAngles.size(); ++i)
+      {
+      this->NewFaceVertices.push_back(this->CapAngles[i].second);
+      }
+    this->NewFaceOffsets.push_back(this->NewFaceVertices.size());
+    this->NewFaceIds.push_back(pointId);
+  }
+
+  void RemoveUnusedVertices()
+  {
+    const unsigned int unused = static_cast<unsigned int>(-1);
+    this->VertexMap.assign(this->Vertices.size() / 3, unused);
+    this->NewVertices.clear();
+    for(std::size_t i = 0; i < this->FaceVertices.size(); ++i)
+      {
+      unsigned int& newIndex = this->VertexMap[this->FaceVertices[i]];
+      if(newIndex == unused)
+        {
+        newIndex = static_cast<unsigned int>(this->NewVertices.size() / 3);
+        const double* vertex = &this->Vertices[3 * this->FaceVertices[i]];
+        this->NewVertices.insert(this->NewVertices.end(), vertex, vertex + 3);
+        }
+      this->FaceVertices[i] = newIndex;
+      }
+    this->Vertices.swap(this->NewVertices);
+  }
+
+  double Center[3];
+  std::vector<double> Vertices;
+  std::vector<std::size_t> FaceOffsets;
+  std::vector<unsigned int> FaceVertices;
+  std::vector<IdType> FaceIds;
+
+  // Scratch space reused by every clip
+  std::vector<double> Side;
+  std::vector<std::pair<std::pair<unsigned int, unsigned int>, unsigned int> > CrossedEdges;
+  std::vector<unsigned int> CapVertices;
+  std::vector<std::pair<double, unsigned int> > CapAngles;
+  std::vector<std::size_t> NewFaceOffsets;
+  std::vector<unsigned int> NewFaceVertices;
+  std::vector<IdType> NewFaceIds;
+  std::vector<unsigned int> VertexMap;
+  std::vector<double> NewVertices;
+};
+
+} // end namespace SmartNeighbors
+
+#endif
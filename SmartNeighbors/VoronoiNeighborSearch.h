@@ -0,0 +1,390 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef VORONOINEIGHBORSEARCH_H
+#define VORONOINEIGHBORSEARCH_H
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Custom
+#include "CreatePointIndex.h"
+#include "NeighborSearchStats.h"
+#include "VoronoiCell2D.h"
+#include "VoronoiCell3D.h"
+
+namespace SmartNeighbors
+{
+
+template <unsigned int Dimension>
+struct VoronoiCellType;
+
+template <>
+struct VoronoiCellType<2>
+{
+  typedef VoronoiCell2D Type;
+};
+
+template <>
+struct VoronoiCellType<3>
+{
+  typedef VoronoiCell3D Type;
+};
+
+// Voronoi neighbor queries on points in a plain array, in 2 or 3 dimensions, with
+// float or double coordinates. This is the VTK free core behind
+// LocalVoronoiNeighborSearcher and LocalVoronoiNeighborSearcher3D.
+//
+// The cell of the query point is clipped by the bisectors of its k nearest points
+// (see VoronoiCell2D.h and VoronoiCell3D.h). A point farther from the query than
+// the security radius of the cell cannot change it, so once the kth nearest point is
+// beyond it the cell is exact. Otherwise k is doubled and the query repeated. The
+// cells are clipped to the bounding box of the points unless other bounds are set.
+// The cells are computed in double whatever the precision of the points.
+//
+// Queries only read the search, so they may run concurrently as long as each thread
+// passes its own output vectors and stats.
+template <typename TScalar, unsigned int Dimension>
+class VoronoiNeighborSearch
+{
+public:
+  typedef PointIndex<TScalar, Dimension> IndexType;
+  typedef typename IndexType::NeighborType NeighborType;
+  typedef typename VoronoiCellType<Dimension>::Type CellType;
+
+  // In 2D only the first two coordinates of each point are used
+  VoronoiNeighborSearch(const TScalar* points, std::size_t numberOfPoints, unsigned int stride = Dimension,
+                        PointIndexType indexType = AutomaticIndex)
+    : Index(CreatePointIndex<TScalar, Dimension>(points, numberOfPoints, stride, indexType)), OwnsIndex(true)
+  {
+    for(unsigned int d = 0; d < Dimension; ++d)
+      {
+      this->Bounds[2*d] = 0.0;
+      this->Bounds[2*d + 1] = 0.0;
+      }
+    for(std::size_t i = 0; i < numberOfPoints; ++i)
+      {
+      const TScalar* p = this->Index->GetPoint(i);
+      for(unsigned int d = 0; d < Dimension; ++d)
+        {
+        if(i == 0 || p[d] < this->Bounds[2*d])
+          {
+          this->Bounds[2*d] = p[d];
+          }
+        if(i == 0 || p[d] > this->Bounds[2*d + 1])
+          {
+          this->Bounds[2*d + 1] = p[d];
+          }
+        }
+      }
+  }
+
+  // Search an index that the caller owns and may change between queries, such as a
+  // DynamicPointIndex. The bounds are the first 2 * Dimension values of
+  // {xmin, xmax, ymin, ymax, zmin, zmax}, see SetBounds().
+  VoronoiNeighborSearch(const IndexType* index, const double* bounds)
+    : Index(index), OwnsIndex(false)
+  {
+    this->SetBounds(bounds);
+  }
+
+  ~VoronoiNeighborSearch()
+  {
+    if(this->OwnsIndex)
+      {
+      delete this->Index;
+      }
+  }
+
+  const IndexType& GetIndex() const
+  {
+    return *this->Index;
+  }
+
+  // The first 2 * Dimension values of {xmin, xmax, ymin, ymax, zmin, zmax}
+  void SetBounds(const double* bounds)
+  {
+    std::copy(bounds, bounds + 2 * Dimension, this->Bounds);
+  }
+
+  const double* GetBounds() const
+  {
+    return this->Bounds;
+  }
+
+  // Find the Voronoi neighbors of the point 'centerPointId', starting from 'initialK'
+  // candidates. In 2D the neighbors are in counter clockwise order around the point,
+  // in 3D they are sorted by id. If 'securityRadius' is given it is set to the radius
+  // of the ball around the point that the result depends on.
+  void Query(std::size_t centerPointId, std::vector<std::size_t>& neighborIds, unsigned int initialK = 16,
+             NeighborSearchStats* stats = 0, double* securityRadius = 0) const
+  {
+    CellType cell;
+    std::vector<NeighborType> kNearest;
+    this->Query(centerPointId, neighborIds, initialK, stats, securityRadius, cell, kNearest);
+  }
+
+  // The same, with the cell and candidates as scratch space that repeated queries reuse
+  void Query(std::size_t centerPointId, std::vector<std::size_t>& neighborIds, unsigned int initialK,
+             NeighborSearchStats* stats, double* securityRadius, CellType& cell,
+             std::vector<NeighborType>& kNearest) const
+  {
+    neighborIds.clear();
+    if(securityRadius)
+      {
+      // A lone point's cell is the whole box, which any other point would cut
+      *securityRadius = HUGE_VAL;
+      }
+    if(this->Index->GetNumberOfPoints() <= 1)
+      {
+      return;
+      }
+
+    this->ComputeCell(this->Index->GetPoint(centerPointId), centerPointId, initialK, stats, cell, kNearest);
+    if(securityRadius)
+      {
+      *securityRadius = std::sqrt(cell.GetSecurityRadius2());
+      }
+
+    std::vector<typename CellType::IdType> cellNeighborIds;
+    cell.GetNeighborIds(cellNeighborIds);
+    neighborIds.assign(cellNeighborIds.begin(), cellNeighborIds.end());
+    if(Dimension == 3)
+      {
+      std::sort(neighborIds.begin(), neighborIds.end());
+      }
+
+    if(stats)
+      {
+      stats->NumberOfQueries++;
+      stats->NumberOfAccepted += neighborIds.size();
+      }
+  }
+
+  // Query() that also returns the geometry natural neighbor interpolation needs:
+  // sharedMeasures[i] is the length (2D) or area (3D) of the boundary that the cell
+  // shares with the cell of neighborIds[i], and 'cellMeasure', if given, is set to
+  // the area (2D) or volume (3D) of the cell. The measures come from the cell the
+  // query builds anyway, so they cost next to nothing.
+  void QueryNaturalNeighbors(std::size_t centerPointId, std::vector<std::size_t>& neighborIds,
+                             std::vector<double>& sharedMeasures, double* cellMeasure = 0,
+                             unsigned int initialK = 16, NeighborSearchStats* stats = 0) const
+  {
+    CellType cell;
+    std::vector<NeighborType> kNearest;
+    neighborIds.clear();
+    sharedMeasures.clear();
+    if(cellMeasure)
+      {
+      *cellMeasure = 0.0;
+      }
+    if(this->Index->GetNumberOfPoints() <= 1)
+      {
+      return;
+      }
+    this->ComputeCell(this->Index->GetPoint(centerPointId), centerPointId, initialK, stats, cell, kNearest);
+    this->GetNaturalNeighbors(cell, neighborIds, sharedMeasures, cellMeasure, stats);
+  }
+
+  // The same for the location 'queryPoint', which need not be one of the points: the
+  // cell is the one the location would have if it were added to the points, as for
+  // interpolating there. A point at the location itself cannot bound the cell, so
+  // there the value of that point should be used instead. The location must lie
+  // within the bounds, see SetBounds(). 'cell' and 'kNearest' are scratch space that
+  // repeated queries reuse.
+  void QueryNaturalNeighborsAt(const TScalar* queryPoint, std::vector<std::size_t>& neighborIds,
+                               std::vector<double>& sharedMeasures, double* cellMeasure, unsigned int initialK,
+                               NeighborSearchStats* stats, CellType& cell, std::vector<NeighborType>& kNearest) const
+  {
+    neighborIds.clear();
+    sharedMeasures.clear();
+    if(cellMeasure)
+      {
+      *cellMeasure = 0.0;
+      }
+    if(this->Index->GetNumberOfPoints() == 0)
+      {
+      return;
+      }
+    this->ComputeCell(queryPoint, IndexType::NoId, initialK, stats, cell, kNearest);
+    this->GetNaturalNeighbors(cell, neighborIds, sharedMeasures, cellMeasure, stats);
+  }
+
+  void QueryNaturalNeighborsAt(const TScalar* queryPoint, std::vector<std::size_t>& neighborIds,
+                               std::vector<double>& sharedMeasures, double* cellMeasure = 0,
+                               unsigned int initialK = 16, NeighborSearchStats* stats = 0) const
+  {
+    CellType cell;
+    std::vector<NeighborType> kNearest;
+    this->QueryNaturalNeighborsAt(queryPoint, neighborIds, sharedMeasures, cellMeasure, initialK, stats, cell,
+                                  kNearest);
+  }
+
+  // The Laplace (non-Sibsonian) interpolation weights of the natural neighbors of
+  // 'queryPoint', as found by QueryNaturalNeighborsAt(): each shared measure over the
+  // distance to the neighbor, normalized to sum to 1
+  void GetLaplaceWeights(const TScalar* queryPoint, const std::vector<std::size_t>& neighborIds,
+                         const std::vector<double>& sharedMeasures, std::vector<double>& weights) const
+  {
+    weights.resize(neighborIds.size());
+    double sum = 0.0;
+    for(std::size_t i = 0; i < neighborIds.size(); ++i)
+      {
+      double p[Dimension];
+      double q[Dimension];
+      const TScalar* neighbor = this->Index->GetPoint(neighborIds[i]);
+      std::copy(neighbor, neighbor + Dimension, p);
+      std::copy(queryPoint, queryPoint + Dimension, q);
+      weights[i] = sharedMeasures[i] / std::sqrt(Distance2<double, Dimension>(p, q));
+      sum += weights[i];
+      }
+    for(std::size_t i = 0; i < weights.size(); ++i)
+      {
+      weights[i] /= sum;
+      }
+  }
+
+private:
+  // Clip 'cell' around 'center' by the nearest points other than 'excludeId' until no
+  // other point can change it
+  void ComputeCell(const TScalar* center, std::size_t excludeId, unsigned int initialK, NeighborSearchStats* stats,
+                   CellType& cell, std::vector<NeighborType>& kNearest) const
+  {
+    const std::size_t numberOfOtherPoints =
+      this->Index->GetNumberOfPoints() - (excludeId == IndexType::NoId ? 0 : 1);
+
+    double centerPoint[Dimension];
+    std::copy(center, center + Dimension, centerPoint);
+
+    unsigned int k = std::max(initialK, 1u);
+    while(true)
+      {
+      if(k > numberOfOtherPoints)
+        {
+        k = static_cast<unsigned int>(numberOfOtherPoints);
+        }
+
+      double startTime = stats ? NeighborSearchStats::GetTime() : 0.0;
+
+      this->Index->FindKNearest(center, k, kNearest, excludeId);
+
+      if(stats)
+        {
+        double time = NeighborSearchStats::GetTime();
+        stats->PhaseTime[NeighborSearchStats::KNearestPhase] += time - startTime;
+        startTime = time;
+        }
+
+      // Clip the cell by every candidate, nearest first. Once a candidate is beyond
+      // the security radius so are all of the rest, so they are skipped.
+      cell.Initialize(centerPoint, this->Bounds);
+      double kthDistance2 = 0.0;
+      double securityRadius2 = cell.GetSecurityRadius2();
+      for(std::size_t i = 0; i < kNearest.size(); ++i)
+        {
+        double p[Dimension];
+        const TScalar* candidate = this->Index->GetPoint(kNearest[i].Id);
+        std::copy(candidate, candidate + Dimension, p);
+        kthDistance2 = Distance2<double, Dimension>(p, centerPoint);
+        if(kthDistance2 >= securityRadius2)
+          {
+          break;
+          }
+        if(cell.Clip(p, static_cast<typename CellType::IdType>(kNearest[i].Id)))
+          {
+          securityRadius2 = cell.GetSecurityRadius2();
+          }
+        }
+
+      if(stats)
+        {
+        stats->PhaseTime[NeighborSearchStats::VoronoiGenerationPhase] += NeighborSearchStats::GetTime() - startTime;
+        stats->NumberOfCandidates += kNearest.size();
+        }
+
+      // Every point that was not a candidate is at least as far away as the kth one.
+      // If that is beyond the security radius, none of them can cut the cell.
+      // Fewer than k candidates means that there are no more points, as when some of
+      // the ids of a dynamic index are free.
+      if(k == numberOfOtherPoints || kNearest.size() < k || kthDistance2 >= securityRadius2)
+        {
+        break;
+        }
+      k *= 2;
+      }
+  }
+
+  // The neighbors of a finished cell with their shared measures, in the order of Query()
+  void GetNaturalNeighbors(const CellType& cell, std::vector<std::size_t>& neighborIds,
+                           std::vector<double>& sharedMeasures, double* cellMeasure, NeighborSearchStats* stats) const
+  {
+    std::vector<typename CellType::IdType> cellNeighborIds;
+    cell.GetNeighbors(cellNeighborIds, sharedMeasures);
+    if(Dimension == 3)
+      {
+      std::vector<std::pair<typename CellType::IdType, double> > neighbors(cellNeighborIds.size());
+      for(std::size_t i = 0; i < neighbors.size(); ++i)
+        {
+        neighbors[i] = std::make_pair(cellNeighborIds[i], sharedMeasures[i]);
+        }
+      std::sort(neighbors.begin(), neighbors.end());
+      for(std::size_t i = 0; i < neighbors.size(); ++i)
+        {
+        cellNeighborIds[i] = neighbors[i].first;
+        sharedMeasures[i] = neighbors[i].second;
+        }
+      }
+    neighborIds.assign(cellNeighborIds.begin(), cellNeighborIds.end());
+    if(cellMeasure)
+      {
+      *cellMeasure = GetMeasure(cell);
+      }
+
+    if(stats)
+      {
+      stats->NumberOfQueries++;
+      stats->NumberOfAccepted += neighborIds.size();
+      }
+  }
+
+  static double GetMeasure(const VoronoiCell2D& cell)
+  {
+    return cell.GetArea();
+  }
+
+  static double GetMeasure(const VoronoiCell3D& cell)
+  {
+    return cell.GetVolume();
+  }
+
+  // Not copyable, the search may own its index
+  VoronoiNeighborSearch(const VoronoiNeighborSearch&);
+  void operator=(const VoronoiNeighborSearch&);
+
+  const IndexType* Index;
+  bool OwnsIndex;
+  double Bounds[2 * Dimension];
+};
+
+} // end namespace SmartNeighbors
+
+#endif
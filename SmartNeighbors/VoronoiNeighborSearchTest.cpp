@@ -0,0 +1,117 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// Checks the local Voronoi cells in 2D and in 3D. Queries start from only 4
+// candidates, so most of them have to double k until the exactness certificate
+// holds, and their neighbors are compared with those of cells clipped by every
+// other point of the cloud. The neighbor relation of a larger cloud is also checked
+// to be symmetric, as that of a Voronoi diagram is. Run by ctest, it prints each
+// mismatch and fails if there are any.
+
+// STL
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Custom
+#include "TestUtilities.h"
+#include "VoronoiNeighborSearch.h"
+
+namespace
+{
+template <unsigned int Dimension>
+const char* GetCheckName()
+{
+  return Dimension == 2 ? "The 2D Voronoi neighbors" : "The 3D Voronoi neighbors";
+}
+
+// The cell of every point clipped by all of the other points, against the query
+template <unsigned int Dimension>
+void CheckCertificate(const std::vector<double>& points)
+{
+  typedef SmartNeighbors::VoronoiNeighborSearch<double, Dimension> SearchType;
+  typedef typename SearchType::CellType CellType;
+  const std::size_t numberOfPoints = points.size() / 3;
+  SearchType search(&points[0], numberOfPoints, 3);
+
+  CellType cell;
+  std::vector<typename CellType::IdType> cellNeighborIds;
+  std::vector<std::size_t> neighborIds;
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    search.Query(id, neighborIds, 4);
+
+    cell.Initialize(&points[3 * id], search.GetBounds());
+    for(std::size_t other = 0; other < numberOfPoints; ++other)
+      {
+      if(other != id)
+        {
+        cell.Clip(&points[3 * other], static_cast<typename CellType::IdType>(other));
+        }
+      }
+    cell.GetNeighborIds(cellNeighborIds);
+    std::vector<std::size_t> expected(cellNeighborIds.begin(), cellNeighborIds.end());
+    std::sort(expected.begin(), expected.end());
+    std::sort(neighborIds.begin(), neighborIds.end());
+    if(neighborIds != expected)
+      {
+      Fail(std::string(GetCheckName<Dimension>()) + " from 4 candidates", "uniform", id);
+      }
+    }
+}
+
+template <unsigned int Dimension>
+void CheckSymmetry(const std::vector<double>& points)
+{
+  const std::size_t numberOfPoints = points.size() / 3;
+  SmartNeighbors::VoronoiNeighborSearch<double, Dimension> search(&points[0], numberOfPoints, 3);
+
+  std::vector<std::vector<std::size_t> > neighborIds(numberOfPoints);
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    search.Query(id, neighborIds[id]);
+    std::sort(neighborIds[id].begin(), neighborIds[id].end());
+    }
+  for(std::size_t id = 0; id < numberOfPoints; ++id)
+    {
+    for(std::size_t i = 0; i < neighborIds[id].size(); ++i)
+      {
+      const std::vector<std::size_t>& other = neighborIds[neighborIds[id][i]];
+      if(!std::binary_search(other.begin(), other.end(), id))
+        {
+        Fail(std::string(GetCheckName<Dimension>()) + " relation", "uniform", id);
+        }
+      }
+    }
+}
+}
+
+int main(int, char *[])
+{
+  std::vector<double> points;
+  GenerateCloud("uniform", 2000, points);
+  CheckCertificate<2>(points);
+  GenerateCloud("uniform", 20000, points);
+  CheckSymmetry<2>(points);
+
+  GenerateCloud("uniform", 1000, points);
+  CheckCertificate<3>(points);
+  GenerateCloud("uniform", 5000, points);
+  CheckSymmetry<3>(points);
+  return ReportFailures();
+}
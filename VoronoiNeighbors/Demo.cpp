@@ -104,7 +104,9 @@ int main(int argc, char *argv[])
   
   // Find the Voronoi Neighbors of the center point
   vtkSmartPointer<vtkPoints> neighbors = vtkSmartPointer<vtkPoints>::New();
-  VoronoiNeighbors(points2D, centerPointId, neighbors);
+  // Also write the Voronoi diagram to voronoi.vtk
+  VoronoiNeighborsFileDebugSink debugSink;
+  VoronoiNeighbors(points2D, centerPointId, neighbors, 0, &debugSink);
   
   // Add the resulting neighbors to a polydata
   vtkSmartPointer<vtkPolyData> polydata = vtkSmartPointer<vtkPolyData>::New();
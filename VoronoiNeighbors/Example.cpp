@@ -75,7 +75,7 @@ int main(int argc, char *argv[])
 
   vtkSmartPointer<vtkXMLPolyDataWriter> writer =
     vtkSmartPointer<vtkXMLPolyDataWriter>::New();
-  writer->SetFileName("VoronoiNeighbors.vtp");
+  writer->SetFileName(outputFileName.c_str());
   writer->SetInputConnection(vertexGlyphFilter->GetOutputPort());
   writer->Write();
   
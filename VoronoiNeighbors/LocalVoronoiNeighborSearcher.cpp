@@ -0,0 +1,209 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "LocalVoronoiNeighborSearcher.h"
+
+// VTK
+#include <vtkTimerLog.h>
+
+namespace
+{
+template <typename TSearch>
+void QueryNeighbors(const TSearch* search, vtkIdType centerPointId, vtkIdList* neighborIds, unsigned int initialK,
+                    SmartNeighbors::NeighborSearchStats* stats, double* securityRadius)
+{
+  std::vector<std::size_t> ids;
+  search->Query(static_cast<std::size_t>(centerPointId), ids, initialK, stats, securityRadius);
+  neighborIds->SetNumberOfIds(static_cast<vtkIdType>(ids.size()));
+  for(std::size_t i = 0; i < ids.size(); ++i)
+    {
+    neighborIds->SetId(static_cast<vtkIdType>(i), static_cast<vtkIdType>(ids[i]));
+    }
+}
+
+void CopyNaturalNeighbors(const std::vector<std::size_t>& ids, const std::vector<double>& measures,
+                          vtkIdList* neighborIds, vtkDoubleArray* sharedMeasures)
+{
+  neighborIds->SetNumberOfIds(static_cast<vtkIdType>(ids.size()));
+  sharedMeasures->SetNumberOfComponents(1);
+  sharedMeasures->SetNumberOfTuples(static_cast<vtkIdType>(measures.size()));
+  for(std::size_t i = 0; i < ids.size(); ++i)
+    {
+    neighborIds->SetId(static_cast<vtkIdType>(i), static_cast<vtkIdType>(ids[i]));
+    sharedMeasures->SetValue(static_cast<vtkIdType>(i), measures[i]);
+    }
+}
+
+template <typename TSearch>
+void QueryNaturalNeighbors(const TSearch* search, vtkIdType centerPointId, vtkIdList* neighborIds,
+                           vtkDoubleArray* sharedMeasures, double* cellMeasure,
+                           unsigned int initialK, SmartNeighbors::NeighborSearchStats* stats)
+{
+  std::vector<std::size_t> ids;
+  std::vector<double> measures;
+  search->QueryNaturalNeighbors(static_cast<std::size_t>(centerPointId), ids, measures, cellMeasure, initialK, stats);
+  CopyNaturalNeighbors(ids, measures, neighborIds, sharedMeasures);
+}
+
+template <typename TSearch>
+void QueryNaturalNeighborsAt(const TSearch* search, const double queryPoint[3], vtkIdList* neighborIds,
+                             vtkDoubleArray* sharedMeasures, double* cellMeasure, vtkDoubleArray* laplaceWeights,
+                             unsigned int initialK, SmartNeighbors::NeighborSearchStats* stats)
+{
+  // The location in the precision of the points
+  typedef typename TSearch::IndexType::ScalarType ScalarType;
+  ScalarType point[3] = {static_cast<ScalarType>(queryPoint[0]), static_cast<ScalarType>(queryPoint[1]),
+                         static_cast<ScalarType>(queryPoint[2])};
+  std::vector<std::size_t> ids;
+  std::vector<double> measures;
+  search->QueryNaturalNeighborsAt(point, ids, measures, cellMeasure, initialK, stats);
+  CopyNaturalNeighbors(ids, measures, neighborIds, sharedMeasures);
+
+  if(laplaceWeights)
+    {
+    std::vector<double> weights;
+    search->GetLaplaceWeights(point, ids, measures, weights);
+    laplaceWeights->SetNumberOfComponents(1);
+    laplaceWeights->SetNumberOfTuples(static_cast<vtkIdType>(weights.size()));
+    for(std::size_t i = 0; i < weights.size(); ++i)
+      {
+      laplaceWeights->SetValue(static_cast<vtkIdType>(i), weights[i]);
+      }
+    }
+}
+}
+
+LocalVoronoiNeighborSearcher::LocalVoronoiNeighborSearcher(vtkPoints* points, SmartNeighbors::NeighborSearchStats* stats,
+                                                           SmartNeighbors::PointIndexType indexType)
+  : FloatSearch(0), DoubleSearch(0)
+{
+  this->Points = points;
+
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  std::size_t numberOfPoints = static_cast<std::size_t>(this->Points->GetNumberOfPoints());
+  if(this->Points->GetDataType() == VTK_FLOAT && numberOfPoints > 0)
+    {
+    this->FloatSearch = new SmartNeighbors::VoronoiNeighborSearch<float, 2>(
+      static_cast<const float*>(this->Points->GetVoidPointer(0)), numberOfPoints, 3, indexType);
+    }
+  else if(this->Points->GetDataType() == VTK_DOUBLE && numberOfPoints > 0)
+    {
+    this->DoubleSearch = new SmartNeighbors::VoronoiNeighborSearch<double, 2>(
+      static_cast<const double*>(this->Points->GetVoidPointer(0)), numberOfPoints, 3, indexType);
+    }
+  else
+    {
+    this->Coordinates.resize(3 * numberOfPoints);
+    for(vtkIdType i = 0; i < this->Points->GetNumberOfPoints(); ++i)
+      {
+      this->Points->GetPoint(i, &this->Coordinates[3*i]);
+      }
+    this->DoubleSearch = new SmartNeighbors::VoronoiNeighborSearch<double, 2>(
+      this->Coordinates.empty() ? 0 : &this->Coordinates[0], numberOfPoints, 3, indexType);
+    }
+
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::IndexBuildPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    }
+}
+
+LocalVoronoiNeighborSearcher::~LocalVoronoiNeighborSearcher()
+{
+  delete this->FloatSearch;
+  delete this->DoubleSearch;
+}
+
+vtkPoints* LocalVoronoiNeighborSearcher::GetPoints()
+{
+  return this->Points;
+}
+
+void LocalVoronoiNeighborSearcher::SetBounds(const double bounds[6])
+{
+  if(this->FloatSearch)
+    {
+    this->FloatSearch->SetBounds(bounds);
+    }
+  else
+    {
+    this->DoubleSearch->SetBounds(bounds);
+    }
+}
+
+void LocalVoronoiNeighborSearcher::Query(vtkIdType centerPointId, vtkIdList* neighborIds, unsigned int initialK,
+                                         SmartNeighbors::NeighborSearchStats* stats, double* securityRadius)
+{
+  if(this->FloatSearch)
+    {
+    QueryNeighbors(this->FloatSearch, centerPointId, neighborIds, initialK, stats, securityRadius);
+    }
+  else
+    {
+    QueryNeighbors(this->DoubleSearch, centerPointId, neighborIds, initialK, stats, securityRadius);
+    }
+}
+
+void LocalVoronoiNeighborSearcher::Query(vtkIdType centerPointId, vtkPoints* neighbors, unsigned int initialK,
+                                         SmartNeighbors::NeighborSearchStats* stats)
+{
+  vtkSmartPointer<vtkIdList> neighborIds =
+    vtkSmartPointer<vtkIdList>::New();
+  this->Query(centerPointId, neighborIds, initialK, stats);
+
+  for(vtkIdType i = 0; i < neighborIds->GetNumberOfIds(); ++i)
+    {
+    double p[3];
+    this->Points->GetPoint(neighborIds->GetId(i), p);
+    neighbors->InsertNextPoint(p);
+    }
+}
+
+void LocalVoronoiNeighborSearcher::QueryNaturalNeighbors(vtkIdType centerPointId, vtkIdList* neighborIds,
+                                                         vtkDoubleArray* sharedMeasures, double* cellMeasure,
+                                                         unsigned int initialK, SmartNeighbors::NeighborSearchStats* stats)
+{
+  if(this->FloatSearch)
+    {
+    ::QueryNaturalNeighbors(this->FloatSearch, centerPointId, neighborIds, sharedMeasures, cellMeasure, initialK,
+                            stats);
+    }
+  else
+    {
+    ::QueryNaturalNeighbors(this->DoubleSearch, centerPointId, neighborIds, sharedMeasures, cellMeasure, initialK,
+                            stats);
+    }
+}
+
+void LocalVoronoiNeighborSearcher::QueryNaturalNeighborsAt(const double queryPoint[3], vtkIdList* neighborIds,
+                                                           vtkDoubleArray* sharedMeasures, double* cellMeasure,
+                                                           vtkDoubleArray* laplaceWeights, unsigned int initialK,
+                                                           SmartNeighbors::NeighborSearchStats* stats)
+{
+  if(this->FloatSearch)
+    {
+    ::QueryNaturalNeighborsAt(this->FloatSearch, queryPoint, neighborIds, sharedMeasures, cellMeasure, laplaceWeights,
+                              initialK, stats);
+    }
+  else
+    {
+    ::QueryNaturalNeighborsAt(this->DoubleSearch, queryPoint, neighborIds, sharedMeasures, cellMeasure, laplaceWeights,
+                              initialK, stats);
+    }
+}
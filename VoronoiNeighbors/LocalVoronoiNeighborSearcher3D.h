@@ -0,0 +1,103 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef LOCALVORONOINEIGHBORSEARCHER3D_H
+#define LOCALVORONOINEIGHBORSEARCHER3D_H
+
+// STL
+#include <vector>
+
+// VTK
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+
+// Custom
+#include "NeighborSearchStats.h"
+#include "VoronoiNeighborSearch.h"
+
+// This class finds the 3D Voronoi neighbors of single points. It works like
+// LocalVoronoiNeighborSearcher: the query's cell is clipped by the bisector planes of
+// its k nearest points (see VoronoiCell3D.h), and k is doubled until the kth nearest
+// point is beyond the security radius of the cell, at which point the cell is exact.
+// No global diagram is ever built, so the cost per query stays about O(k log k)
+// however large the cloud is.
+//
+// The cells are clipped to the bounding box of the points. Neighbors whose shared
+// face has no area, as happens where five or more points are cospherical, are left out.
+//
+// This is a VTK adapter around SmartNeighbors::VoronoiNeighborSearch<TScalar, 3>.
+class LocalVoronoiNeighborSearcher3D
+{
+public:
+  // The points are referenced, not copied, so they must not be modified while the
+  // searcher is in use. Queries only read the searcher, so they may run concurrently
+  // from several threads as long as each thread passes its own output lists.
+  LocalVoronoiNeighborSearcher3D(vtkPoints* points, SmartNeighbors::NeighborSearchStats* stats = 0,
+                                 SmartNeighbors::PointIndexType indexType = SmartNeighbors::AutomaticIndex);
+  ~LocalVoronoiNeighborSearcher3D();
+
+  // Find the Voronoi neighbors of the point 'centerPointId', starting from 'initialK'
+  // candidates. The neighbors are sorted by id.
+  // If 'securityRadius' is given it is set to the radius of the ball around the point
+  // that the result depends on: no point outside of it can change the cell.
+  void Query(vtkIdType centerPointId, vtkIdList* neighborIds, unsigned int initialK = 32,
+             SmartNeighbors::NeighborSearchStats* stats = 0, double* securityRadius = 0);
+  void Query(vtkIdType centerPointId, vtkPoints* neighbors, unsigned int initialK = 32,
+             SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // Query() that also sets the i-th value of 'sharedMeasures' to the area of the face that
+  // the cell shares with the cell of the i-th neighbor and 'cellMeasure', if given, to
+  // the volume of the cell, for natural neighbor interpolation. The geometry comes
+  // from the same cell as the neighbors.
+  void QueryNaturalNeighbors(vtkIdType centerPointId, vtkIdList* neighborIds, vtkDoubleArray* sharedMeasures,
+                             double* cellMeasure = 0, unsigned int initialK = 32,
+                             SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // The same for the location 'queryPoint', which need not be one of the points but
+  // must lie within the bounds, using the cell it would have if it were added to the
+  // points. If 'laplaceWeights' is given it is set to the Laplace interpolation weight
+  // of each neighbor, see SmartNeighbors::VoronoiNeighborSearch::GetLaplaceWeights().
+  void QueryNaturalNeighborsAt(const double queryPoint[3], vtkIdList* neighborIds, vtkDoubleArray* sharedMeasures,
+                               double* cellMeasure = 0, vtkDoubleArray* laplaceWeights = 0,
+                               unsigned int initialK = 32, SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  vtkPoints* GetPoints();
+
+  // The cells are clipped to these bounds, given as {xmin, xmax, ymin, ymax, zmin, zmax},
+  // instead of the bounds of the points. A part of a larger cloud should use the
+  // bounds of the whole cloud so that its cells agree with it.
+  void SetBounds(const double bounds[6]);
+
+private:
+  // Not copyable, the searches are deleted by the destructor
+  LocalVoronoiNeighborSearcher3D(const LocalVoronoiNeighborSearcher3D&);
+  void operator=(const LocalVoronoiNeighborSearcher3D&);
+
+  vtkSmartPointer<vtkPoints> Points;
+
+  // Exactly one of these is set, depending on the type of the points
+  SmartNeighbors::VoronoiNeighborSearch<float, 3>* FloatSearch;
+  SmartNeighbors::VoronoiNeighborSearch<double, 3>* DoubleSearch;
+
+  // A double copy of points that are neither float nor double
+  std::vector<double> Coordinates;
+};
+
+#endif
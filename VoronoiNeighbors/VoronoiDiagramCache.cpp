@@ -0,0 +1,173 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "VoronoiDiagramCache.h"
+
+// STL
+#include <algorithm>
+
+// VTK
+#include <vtkTimerLog.h>
+
+// ITK
+#include "itkVoronoiDiagram2DGenerator.h"
+
+namespace
+{
+typedef itk::VoronoiDiagram2DGenerator<double> VoronoiGeneratorType;
+typedef VoronoiDiagramType::PointType PointType;
+
+struct ParallelSortObject
+{
+  PointType point;
+  unsigned int id;
+};
+
+/* Compare point coordinates in the y direction, then x. Coincident points are
+   ordered by id, std::sort needs a strict weak ordering. */
+bool pointSorter(ParallelSortObject arg1, ParallelSortObject arg2)
+{
+  if ( arg1.point[1] < arg2.point[1] ) { return 1; }
+  else if ( arg1.point[1] > arg2.point[1] )
+    {
+    return 0;
+    }
+  else if ( arg1.point[0] < arg2.point[0] )
+    {
+    return 1;
+    }
+  else if ( arg1.point[0] > arg2.point[0] )
+    {
+    return 0;
+    }
+  else { return arg1.id < arg2.id; }
+}
+}
+
+VoronoiDiagramCache::VoronoiDiagramCache() : PointsMTime(0)
+{
+}
+
+void VoronoiDiagramCache::Clear()
+{
+  this->Points = 0;
+  this->PointsMTime = 0;
+  this->Diagram = 0;
+  this->SeedIds.clear();
+  this->PointIds.clear();
+}
+
+void VoronoiDiagramCache::Update(vtkPoints* points, SmartNeighbors::NeighborSearchStats* stats)
+{
+  if(this->Diagram && this->Points == points && this->PointsMTime == points->GetMTime())
+    {
+    return;
+    }
+
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  VoronoiGeneratorType::Pointer voronoiGenerator = VoronoiGeneratorType::New();
+
+  double bounds[6];
+  points->GetBounds(bounds);
+
+  PointType boudingSize;
+  boudingSize[0] = bounds[1];
+  boudingSize[1] = bounds[3];
+  voronoiGenerator->SetBoundary(boudingSize);
+
+  PointType origin;
+  origin[0] = bounds[0];
+  origin[1] = bounds[2];
+  voronoiGenerator->SetOrigin(origin);
+
+  // Create a list of seeds
+  std::vector<ParallelSortObject> seedSortObjects;
+  seedSortObjects.reserve(points->GetNumberOfPoints());
+
+  for(vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+    {
+    double p[3];
+    points->GetPoint(i,p);
+
+    PointType seed;
+    seed[0] = p[0];
+    seed[1] = p[1];
+    ParallelSortObject parallelSortObject;
+    parallelSortObject.point = seed;
+    parallelSortObject.id = i;
+    seedSortObjects.push_back(parallelSortObject);
+    }
+
+  std::sort(seedSortObjects.begin(), seedSortObjects.end(), pointSorter);
+
+  this->PointIds.resize(seedSortObjects.size());
+  this->SeedIds.resize(seedSortObjects.size());
+  for(unsigned int i = 0; i < seedSortObjects.size(); ++i)
+    {
+    voronoiGenerator->AddOneSeed(seedSortObjects[i].point);
+    this->PointIds[i] = seedSortObjects[i].id;
+    this->SeedIds[seedSortObjects[i].id] = i;
+    }
+
+  if(stats)
+    {
+    double time = vtkTimerLog::GetUniversalTime();
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::CopyPhase] += time - startTime;
+    startTime = time;
+    }
+
+  voronoiGenerator->Update();
+  this->Diagram = voronoiGenerator->GetOutput();
+
+  this->Points = points;
+  this->PointsMTime = points->GetMTime();
+
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::VoronoiGenerationPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    }
+}
+
+void VoronoiDiagramCache::GetNeighborIds(vtkIdType pointId, vtkIdList* neighborIds)
+{
+  typedef VoronoiDiagramType::NeighborIdIterator NeighborIdIterator;
+
+  neighborIds->Reset();
+  unsigned int seedId = this->SeedIds[pointId];
+  for(NeighborIdIterator neighbors = this->Diagram->NeighborIdsBegin(seedId);
+      neighbors != this->Diagram->NeighborIdsEnd(seedId); ++neighbors)
+    {
+    neighborIds->InsertNextId(this->PointIds[*neighbors]);
+    }
+}
+
+VoronoiDiagramType* VoronoiDiagramCache::GetDiagram()
+{
+  return this->Diagram;
+}
+
+unsigned int VoronoiDiagramCache::GetSeedId(vtkIdType pointId) const
+{
+  return this->SeedIds[pointId];
+}
+
+vtkIdType VoronoiDiagramCache::GetPointId(unsigned int seedId) const
+{
+  return this->PointIds[seedId];
+}
@@ -0,0 +1,69 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef VORONOIDIAGRAMCACHE_H
+#define VORONOIDIAGRAMCACHE_H
+
+// STL
+#include <vector>
+
+// VTK
+#include <vtkIdList.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+
+// Custom
+#include "NeighborSearchStats.h"
+#include "VoronoiNeighborsDebugSink.h"
+
+// Keeps the Voronoi diagram of a point set between queries. The generator needs its
+// seeds sorted, so the cache also keeps the maps between input point ids and seed ids.
+// The diagram is only regenerated when a different point set is given or the
+// modification time of the points changes, so repeated VoronoiNeighbors() queries on
+// the same points only walk the neighbors of one cell.
+class VoronoiDiagramCache
+{
+public:
+  VoronoiDiagramCache();
+
+  // Make sure the cached diagram is the diagram of 'points'. The points are referenced,
+  // not copied. Timings are only recorded into 'stats' if the diagram is regenerated.
+  void Update(vtkPoints* points, SmartNeighbors::NeighborSearchStats* stats = 0);
+
+  // Discard the diagram, so the next Update() regenerates it
+  void Clear();
+
+  // The input point ids of the Voronoi neighbors of the input point 'pointId'
+  void GetNeighborIds(vtkIdType pointId, vtkIdList* neighborIds);
+
+  VoronoiDiagramType* GetDiagram();
+
+  // Map between the ids of the input points and the ids of the seeds of the diagram
+  unsigned int GetSeedId(vtkIdType pointId) const;
+  vtkIdType GetPointId(unsigned int seedId) const;
+
+private:
+  vtkSmartPointer<vtkPoints> Points;
+  unsigned long PointsMTime;
+
+  VoronoiDiagramType::Pointer Diagram;
+  std::vector<unsigned int> SeedIds;  // point id -> seed id
+  std::vector<vtkIdType> PointIds;    // seed id -> point id
+};
+
+#endif
@@ -0,0 +1,237 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "VoronoiNeighborGraph.h"
+
+// STL
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// VTK
+#include <vtkCellArray.h>
+#include <vtkDelaunay2D.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkIdList.h>
+#include <vtkTimerLog.h>
+
+// Custom
+#include "BuildNeighborGraph.h"
+#include "LocalVoronoiNeighborSearcher3D.h"
+
+namespace
+{
+// Interleave the low 16 bits of x and y
+vtkTypeUInt32 InterleaveBits(vtkTypeUInt32 x, vtkTypeUInt32 y)
+{
+  vtkTypeUInt32 key = 0;
+  for(unsigned int bit = 0; bit < 16; ++bit)
+    {
+    key |= ((x >> bit) & 1u) << (2 * bit);
+    key |= ((y >> bit) & 1u) << (2 * bit + 1);
+    }
+  return key;
+}
+
+// Order the points along a Morton curve. vtkDelaunay2D locates each new point by
+// walking from the last triangle it created, so inserting the points in a spatially
+// coherent order keeps those walks short.
+void SpatialOrder(vtkPoints* points, std::vector<vtkIdType>& order)
+{
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  double bounds[6];
+  points->GetBounds(bounds);
+  double scale[2];
+  for(unsigned int d = 0; d < 2; ++d)
+    {
+    double extent = bounds[2*d + 1] - bounds[2*d];
+    scale[d] = extent > 0.0 ? 65535.0 / extent : 0.0;
+    }
+
+  std::vector<std::pair<vtkTypeUInt32, vtkIdType> > keys(numberOfPoints);
+  for(vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    double p[3];
+    points->GetPoint(i, p);
+    vtkTypeUInt32 x = static_cast<vtkTypeUInt32>((p[0] - bounds[0]) * scale[0]);
+    vtkTypeUInt32 y = static_cast<vtkTypeUInt32>((p[1] - bounds[2]) * scale[1]);
+    keys[i] = std::make_pair(InterleaveBits(x, y), i);
+    }
+  std::sort(keys.begin(), keys.end());
+
+  order.resize(numberOfPoints);
+  for(vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    order[i] = keys[i].second;
+    }
+}
+}
+
+void AllVoronoiNeighbors(vtkPoints* points, VoronoiNeighborGraph* graph,
+                         SmartNeighbors::NeighborSearchStats* stats)
+{
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
+
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+
+  // order[i] is the input id of the ith point given to the triangulation
+  std::vector<vtkIdType> order;
+  SpatialOrder(points, order);
+
+  vtkSmartPointer<vtkPoints> sortedPoints =
+    vtkSmartPointer<vtkPoints>::New();
+  sortedPoints->SetNumberOfPoints(numberOfPoints);
+  for(vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    double p[3];
+    points->GetPoint(order[i], p);
+    sortedPoints->SetPoint(i, p);
+    }
+
+  vtkSmartPointer<vtkPolyData> sortedPolydata =
+    vtkSmartPointer<vtkPolyData>::New();
+  sortedPolydata->SetPoints(sortedPoints);
+
+  if(stats)
+    {
+    double time = vtkTimerLog::GetUniversalTime();
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::CopyPhase] += time - startTime;
+    startTime = time;
+    }
+
+  // Only exactly coincident points should be merged
+  vtkSmartPointer<vtkDelaunay2D> delaunay =
+    vtkSmartPointer<vtkDelaunay2D>::New();
+  delaunay->SetInput(sortedPolydata);
+  delaunay->SetTolerance(0.0);
+  delaunay->Update();
+
+  vtkCellArray* triangles = delaunay->GetOutput()->GetPolys();
+
+  // Every triangle gives each of its corners two neighbors. Shared edges are
+  // listed once from each side, so the rows are deduplicated below.
+  graph->Allocate(numberOfPoints, 0);
+  std::vector<std::size_t>& offsets = graph->Offsets;
+  std::fill(offsets.begin(), offsets.end(), 0);
+
+  vtkIdType numberOfCorners;
+  vtkIdType* corners;
+  for(triangles->InitTraversal(); triangles->GetNextCell(numberOfCorners, corners); )
+    {
+    for(vtkIdType i = 0; i < numberOfCorners; ++i)
+      {
+      offsets[order[corners[i]] + 1] += 2;
+      }
+    }
+  for(vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    offsets[i + 1] += offsets[i];
+    }
+
+  std::vector<vtkIdType>& neighborIds = graph->NeighborIds;
+  neighborIds.resize(offsets[numberOfPoints]);
+  std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+  for(triangles->InitTraversal(); triangles->GetNextCell(numberOfCorners, corners); )
+    {
+    for(vtkIdType i = 0; i < numberOfCorners; ++i)
+      {
+      vtkIdType pointId = order[corners[i]];
+      neighborIds[fill[pointId]++] = order[corners[(i + 1) % numberOfCorners]];
+      neighborIds[fill[pointId]++] = order[corners[(i + numberOfCorners - 1) % numberOfCorners]];
+      }
+    }
+
+  // Sort and deduplicate each row, compacting the rows towards the front
+  std::size_t end = 0;
+  for(vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    std::vector<vtkIdType>::iterator rowBegin = neighborIds.begin() + offsets[i];
+    std::vector<vtkIdType>::iterator rowEnd = neighborIds.begin() + offsets[i + 1];
+    std::sort(rowBegin, rowEnd);
+    rowEnd = std::unique(rowBegin, rowEnd);
+
+    offsets[i] = end;
+    end = std::copy(rowBegin, rowEnd, neighborIds.begin() + end) - neighborIds.begin();
+    }
+  offsets[numberOfPoints] = end;
+  neighborIds.resize(end);
+
+  if(stats)
+    {
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::VoronoiGenerationPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    stats->NumberOfQueries += numberOfPoints;
+    stats->NumberOfCandidates += end;
+    stats->NumberOfAccepted += end;
+    }
+}
+
+namespace
+{
+// One local 3D Voronoi cell per point, see BuildNeighborGraph.h
+class VoronoiNeighbor3DQuery
+{
+public:
+  VoronoiNeighbor3DQuery(LocalVoronoiNeighborSearcher3D* searcher, SmartNeighbors::NeighborSearchStats* stats)
+    : Searcher(searcher), Stats(stats), NeighborIds(vtkSmartPointer<vtkIdList>::New())
+  {
+  }
+
+  // Every thread gets its own scratch storage, the searcher is shared read-only
+  VoronoiNeighbor3DQuery(const VoronoiNeighbor3DQuery& other)
+    : Searcher(other.Searcher), Stats(other.Stats), NeighborIds(vtkSmartPointer<vtkIdList>::New())
+  {
+  }
+
+  void operator()(std::size_t pointId, std::vector<vtkIdType>& neighborIds)
+  {
+    this->Searcher->Query(pointId, this->NeighborIds, 32, this->Stats ? &this->ThreadStats : 0);
+    vtkIdType* ids = this->NeighborIds->GetPointer(0);
+    neighborIds.insert(neighborIds.end(), ids, ids + this->NeighborIds->GetNumberOfIds());
+  }
+
+  void Finish()
+  {
+    if(this->Stats)
+      {
+      this->Stats->Accumulate(this->ThreadStats);
+      }
+  }
+
+private:
+  LocalVoronoiNeighborSearcher3D* Searcher;
+  SmartNeighbors::NeighborSearchStats* Stats;
+
+  vtkSmartPointer<vtkIdList> NeighborIds;
+  SmartNeighbors::NeighborSearchStats ThreadStats;
+};
+}
+
+void AllVoronoiNeighbors3D(vtkPoints* points, VoronoiNeighborGraph* graph, int numberOfThreads,
+                           SmartNeighbors::NeighborSearchStats* stats)
+{
+  LocalVoronoiNeighborSearcher3D searcher(points, stats);
+  AllVoronoiNeighbors3D(&searcher, graph, numberOfThreads, stats);
+}
+
+void AllVoronoiNeighbors3D(LocalVoronoiNeighborSearcher3D* searcher, VoronoiNeighborGraph* graph,
+                           int numberOfThreads, SmartNeighbors::NeighborSearchStats* stats)
+{
+  VoronoiNeighbor3DQuery query(searcher, stats);
+  SmartNeighbors::BuildNeighborGraph(searcher->GetPoints()->GetNumberOfPoints(), query, graph, numberOfThreads);
+}
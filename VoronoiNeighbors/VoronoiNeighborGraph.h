@@ -0,0 +1,59 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef VORONOINEIGHBORGRAPH_H
+#define VORONOINEIGHBORGRAPH_H
+
+// VTK
+#include <vtkPoints.h>
+
+// Custom
+#include "NeighborGraph.h"
+#include "NeighborSearchStats.h"
+
+class LocalVoronoiNeighborSearcher3D;
+
+// The Voronoi neighbors of every point of a cloud, see NeighborGraph.h for the layout
+typedef SmartNeighbors::NeighborGraph<vtkIdType> VoronoiNeighborGraph;
+
+// Compute the Voronoi neighbors of every point at once. Two points are Voronoi
+// neighbors exactly when they share an edge of the Delaunay triangulation, so one
+// triangulation of the whole cloud gives the complete adjacency in O(N log N)
+// instead of one Voronoi diagram per point. Like VoronoiNeighbors() only x and y
+// are used. The neighbors of each point are sorted by id.
+//
+// The result is the adjacency of the unbounded diagram. VoronoiNeighbors() clips its
+// diagram to the bounding box of the points, so for points on the convex hull it
+// can miss a neighbor whose shared edge lies entirely outside of the box. Where four
+// or more points are cocircular, the triangulation picks one diagonal, which
+// corresponds to a Voronoi edge of zero length. Exactly coincident points are
+// merged by the triangulation, and all but one of them get no neighbors.
+void AllVoronoiNeighbors(vtkPoints* points, VoronoiNeighborGraph* graph,
+                         SmartNeighbors::NeighborSearchStats* stats = 0);
+
+// Compute the 3D Voronoi neighbors of every point. Each cell is built locally by a
+// LocalVoronoiNeighborSearcher3D, so there is no global tetrahedralization and the
+// queries are split across 'numberOfThreads' threads (0 means use all available
+// cores). The neighbors of each point are sorted by id and the result does not
+// depend on the number of threads. Phase times in 'stats' are summed over threads.
+void AllVoronoiNeighbors3D(vtkPoints* points, VoronoiNeighborGraph* graph, int numberOfThreads = 0,
+                           SmartNeighbors::NeighborSearchStats* stats = 0);
+void AllVoronoiNeighbors3D(LocalVoronoiNeighborSearcher3D* searcher, VoronoiNeighborGraph* graph,
+                           int numberOfThreads = 0, SmartNeighbors::NeighborSearchStats* stats = 0);
+
+#endif
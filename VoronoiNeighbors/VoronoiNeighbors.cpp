@@ -28,51 +28,45 @@
 
 // VTK
 #include <vtkIdList.h>
-#include <vtkKdTree.h>
-#include <vtkMath.h>
-#include <vtkPolyData.h>
 #include <vtkPoints.h>
 #include <vtkSmartPointer.h>
-#include <vtkVertexGlyphFilter.h>
+#include <vtkTimerLog.h>
 
-// ITK
-#include "itkVoronoiDiagram2DGenerator.h"
-#include "itkImageFileWriter.h"
-#include "itkVTKPolyDataWriter.h"
-
-typedef itk::VoronoiDiagram2DGenerator<double> VoronoiGeneratorType;
-typedef itk::VoronoiDiagram2D<double> VoronoiDiagramType;
-typedef VoronoiDiagramType::PointType PointType;
+void VoronoiNeighbors(vtkPoints* points, unsigned int centerPointId, vtkPoints* neighborPoints,
+                      SmartNeighbors::NeighborSearchStats* stats, VoronoiNeighborsDebugSink* debugSink)
+{
+  VoronoiDiagramCache cache;
+  VoronoiNeighbors(&cache, points, centerPointId, neighborPoints, stats, debugSink);
+}
 
-struct ParallelSortObject
+void VoronoiNeighbors(vtkPoints* points, unsigned int centerPointId, vtkIdList* neighborIds,
+                      SmartNeighbors::NeighborSearchStats* stats, VoronoiNeighborsDebugSink* debugSink)
 {
-  PointType point;
-  unsigned int id;
-};
+  VoronoiDiagramCache cache;
+  VoronoiNeighbors(&cache, points, centerPointId, neighborIds, stats, debugSink);
+}
 
-/* Compare point coordinates  in the y direction. */
-bool pointSorter(ParallelSortObject arg1, ParallelSortObject arg2)
+void VoronoiNeighbors(VoronoiDiagramCache* cache, vtkPoints* points, unsigned int centerPointId, vtkPoints* neighborPoints,
+                      SmartNeighbors::NeighborSearchStats* stats, VoronoiNeighborsDebugSink* debugSink)
 {
-  if ( arg1.point[1] < arg2.point[1] ) { return 1; }
-  else if ( arg1.point[1] > arg2.point[1] )
-    {
-    return 0;
-    }
-  else if ( arg1.point[0] < arg2.point[0] )
-    {
-    return 1;
-    }
-  else if ( arg1.point[0] > arg2.point[0] )
+  // This function takes in a point cloud, 'points', and produces a point cloud, 'neighbors',
+  // of the 'centerPointId's Voronoi Neighbors
+  vtkSmartPointer<vtkIdList> neighborIds =
+    vtkSmartPointer<vtkIdList>::New();
+  VoronoiNeighbors(cache, points, centerPointId, neighborIds, stats, debugSink);
+
+  for(vtkIdType i = 0; i < neighborIds->GetNumberOfIds(); ++i)
     {
-    return 0;
+    double p[3];
+    points->GetPoint(neighborIds->GetId(i), p);
+    neighborPoints->InsertNextPoint(p);
     }
-  else { return 1; }
 }
 
-void VoronoiNeighbors(vtkPoints* points, unsigned int centerPointId, vtkPoints* neighborPoints)
+void VoronoiNeighbors(VoronoiDiagramCache* cache, vtkPoints* points, unsigned int centerPointId, vtkIdList* neighborIds,
+                      SmartNeighbors::NeighborSearchStats* stats, VoronoiNeighborsDebugSink* debugSink)
 {
-  // This function takes in a point cloud, 'points', and produces a point cloud, 'neighbors',
-  // of the 'centerPointId's Voronoi Neighbors
+  neighborIds->Reset();
   
   if(centerPointId > points->GetNumberOfPoints() - 1)
     {
@@ -80,114 +74,24 @@ void VoronoiNeighbors(vtkPoints* points, unsigned int centerPointId, vtkPoints*
 	      << " but the input only has " << points->GetNumberOfPoints() << " points!" << std::endl;
     exit(-1);
     }
-  
-  typedef VoronoiDiagramType::CellType CellType;
-  typedef VoronoiDiagramType::CellAutoPointer CellAutoPointer;
-  typedef CellType::PointIdIterator PointIdIterator;
-  typedef VoronoiDiagramType::NeighborIdIterator NeighborIdIterator;
 
-  VoronoiDiagramType::Pointer voronoiDiagram = VoronoiDiagramType::New();
-  VoronoiGeneratorType::Pointer voronoiGenerator = VoronoiGeneratorType::New();
+  // Only regenerates the diagram if the points have changed
+  cache->Update(points, stats);
 
-  double bounds[6];
-  points->GetBounds(bounds);
-  
-  PointType boudingSize;
-  boudingSize[0] = bounds[1];
-  boudingSize[1] = bounds[3];
-  //boudingSize[0] = width;
-  //boudingSize[1] = height;
-  voronoiGenerator->SetBoundary(boudingSize);
-  std::cout << "Boundary size set to " << boudingSize << std::endl;
-  
-  PointType origin;
-  origin[0] = bounds[0];
-  origin[1] = bounds[2];
-  voronoiGenerator->SetOrigin(origin);
-  std::cout << "Origin set to " << origin << std::endl;
+  double startTime = stats ? vtkTimerLog::GetUniversalTime() : 0.0;
 
-  // Create a list of seeds
-  std::vector<ParallelSortObject> seedSortObjects;
-  
-  std::cout << "There are " << points->GetNumberOfPoints() << " points" << std::endl;
-  
-  
-  for(vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
-    {
-    double p[3];
-    points->GetPoint(i,p);
-  
-    PointType seed;
-    seed[0] = p[0];
-    seed[1] = p[1];
-    std::cout << "Adding seed " << seed << std::endl;
-    ParallelSortObject parallelSortObject;
-    parallelSortObject.point = seed;
-    parallelSortObject.id = i;
-    seedSortObjects.push_back(parallelSortObject);
-    
-    }
-    
-  std::sort(seedSortObjects.begin(), seedSortObjects.end(), pointSorter);
-  
-  std::vector<unsigned int> newIds; // this will be a map from new id -> old id
-  for(unsigned int i = 0; i < seedSortObjects.size(); ++i)
-    {
-    voronoiGenerator->AddOneSeed(seedSortObjects[i].point);
-    newIds.push_back(seedSortObjects[i].id);
-    }
-  
-  voronoiGenerator->Update();
-  voronoiDiagram = voronoiGenerator->GetOutput();
-  
-  // Find the new id of the center point
-  unsigned int newCenterPointId = 0;
-  for(unsigned int i = 0; i < seedSortObjects.size(); ++i)
-    {
-    if(seedSortObjects[i].id == centerPointId)
-      {
-      newCenterPointId = i;
-      break;
-      }
-    }
-  std::cout << "New center point id: " << newCenterPointId << std::endl;
-  
-  // Construct the output points
-  for(NeighborIdIterator neighbors = voronoiDiagram->NeighborIdsBegin(newCenterPointId); neighbors != voronoiDiagram->NeighborIdsEnd(newCenterPointId); ++neighbors)
+  cache->GetNeighborIds(centerPointId, neighborIds);
+
+  if(stats)
     {
-    double p[3];
-    points->GetPoint(newIds[*neighbors], p);
-    neighborPoints->InsertNextPoint(p);
-  
-    // This also works
-    /*
-    PointType seed = voronoiGenerator->GetOutput()->GetSeed(*neighbors);
-    double p[3];
-    p[0] = seed[0];
-    p[1] = seed[1];
-    p[2] = 0;
-    neighborPoints->InsertNextPoint(p);
-    */
+    stats->PhaseTime[SmartNeighbors::NeighborSearchStats::NeighborLookupPhase] += vtkTimerLog::GetUniversalTime() - startTime;
+    stats->NumberOfQueries++;
+    stats->NumberOfCandidates += neighborIds->GetNumberOfIds();
+    stats->NumberOfAccepted += neighborIds->GetNumberOfIds();
     }
 
-  {
-  // Create a mesh of the Voronoi diagram
-  // This code is not necessary after the commit: Ie6fa45dab69cb6b3df26896546d3962af172b035
-  {
-  VoronoiDiagramType::VertexIterator allVerts;
-  int j = 0;
-  for(allVerts = voronoiDiagram->VertexBegin(); allVerts != voronoiDiagram->VertexEnd(); ++allVerts)
+  if(debugSink)
     {
-    voronoiDiagram->SetPoint(j, *allVerts);
-    j++;
+    debugSink->VoronoiDiagram(cache->GetDiagram(), cache->GetSeedId(centerPointId));
     }
-  }
-
-  // Write the resulting mesh
-  typedef itk::VTKPolyDataWriter<VoronoiDiagramType::Superclass> WriterType;
-  WriterType::Pointer writer = WriterType::New();
-  writer->SetInput(voronoiDiagram);
-  writer->SetFileName("voronoi.vtk");
-  writer->Update();
-  }
 }
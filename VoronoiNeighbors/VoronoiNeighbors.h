@@ -19,8 +19,31 @@
 #ifndef VORONOINEIGHBORS_H
 #define VORONOINEIGHBORS_H
 
+#include <vtkIdList.h>
 #include <vtkPoints.h>
 
-void VoronoiNeighbors(vtkPoints* points, unsigned int centerPointId, vtkPoints* neighbors);
+// Custom
+#include "NeighborSearchStats.h"
+#include "VoronoiDiagramCache.h"
+#include "VoronoiNeighborsDebugSink.h"
+
+// Find the Voronoi neighbors of the point 'centerPointId'.
+// The first version copies the neighbor coordinates, the second returns the neighbor ids.
+// Timings and counts are recorded into 'stats' and the generated diagram is
+// passed to 'debugSink' only if they are given.
+// LocalVoronoiNeighborSearcher::QueryNaturalNeighbors() also returns the shared edge
+// lengths and the cell area that natural neighbor interpolation needs.
+void VoronoiNeighbors(vtkPoints* points, unsigned int centerPointId, vtkPoints* neighbors,
+                      SmartNeighbors::NeighborSearchStats* stats = 0, VoronoiNeighborsDebugSink* debugSink = 0);
+void VoronoiNeighbors(vtkPoints* points, unsigned int centerPointId, vtkIdList* neighborIds,
+                      SmartNeighbors::NeighborSearchStats* stats = 0, VoronoiNeighborsDebugSink* debugSink = 0);
+
+// The same queries, reusing the diagram in 'cache' when it was generated from the
+// same, unmodified points. Querying many points of one cloud through one cache
+// generates the diagram only once.
+void VoronoiNeighbors(VoronoiDiagramCache* cache, vtkPoints* points, unsigned int centerPointId, vtkPoints* neighbors,
+                      SmartNeighbors::NeighborSearchStats* stats = 0, VoronoiNeighborsDebugSink* debugSink = 0);
+void VoronoiNeighbors(VoronoiDiagramCache* cache, vtkPoints* points, unsigned int centerPointId, vtkIdList* neighborIds,
+                      SmartNeighbors::NeighborSearchStats* stats = 0, VoronoiNeighborsDebugSink* debugSink = 0);
 
 #endif
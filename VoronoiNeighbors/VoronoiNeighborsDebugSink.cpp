@@ -0,0 +1,49 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "VoronoiNeighborsDebugSink.h"
+
+// ITK
+#include "itkVTKPolyDataWriter.h"
+
+VoronoiNeighborsFileDebugSink::VoronoiNeighborsFileDebugSink(const std::string& diagramFileName)
+  : DiagramFileName(diagramFileName)
+{
+}
+
+void VoronoiNeighborsFileDebugSink::VoronoiDiagram(VoronoiDiagramType* voronoiDiagram, unsigned int)
+{
+  // Create a mesh of the Voronoi diagram
+  // This code is not necessary after the commit: Ie6fa45dab69cb6b3df26896546d3962af172b035
+  {
+  VoronoiDiagramType::VertexIterator allVerts;
+  int j = 0;
+  for(allVerts = voronoiDiagram->VertexBegin(); allVerts != voronoiDiagram->VertexEnd(); ++allVerts)
+    {
+    voronoiDiagram->SetPoint(j, *allVerts);
+    j++;
+    }
+  }
+
+  // Write the resulting mesh
+  typedef itk::VTKPolyDataWriter<VoronoiDiagramType::Superclass> WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(voronoiDiagram);
+  writer->SetFileName(this->DiagramFileName.c_str());
+  writer->Update();
+}
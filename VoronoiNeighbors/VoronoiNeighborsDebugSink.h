@@ -0,0 +1,56 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef VORONOINEIGHBORSDEBUGSINK_H
+#define VORONOINEIGHBORSDEBUGSINK_H
+
+// STL
+#include <string>
+
+// ITK
+#include "itkVoronoiDiagram2D.h"
+
+typedef itk::VoronoiDiagram2D<double> VoronoiDiagramType;
+
+// Receives the intermediate geometry of Voronoi neighbor searches. Nothing is
+// produced unless a sink is given to the search.
+class VoronoiNeighborsDebugSink
+{
+public:
+  virtual ~VoronoiNeighborsDebugSink() {}
+
+  // Called with the diagram that was generated to answer a query. 'centerSeedId'
+  // is the id of the query point among the seeds of the diagram, which are sorted
+  // and so are not in the order of the input points.
+  virtual void VoronoiDiagram(VoronoiDiagramType* voronoiDiagram, unsigned int centerSeedId) = 0;
+};
+
+// Writes every generated diagram to a legacy .vtk file, as the demo does.
+// Each diagram overwrites the file.
+class VoronoiNeighborsFileDebugSink : public VoronoiNeighborsDebugSink
+{
+public:
+  VoronoiNeighborsFileDebugSink(const std::string& diagramFileName = "voronoi.vtk");
+
+  void VoronoiDiagram(VoronoiDiagramType* voronoiDiagram, unsigned int centerSeedId);
+
+private:
+  std::string DiagramFileName;
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "VoronoiTileNeighborQuery.h"
+#include "LocalVoronoiNeighborSearcher.h"
+#include "LocalVoronoiNeighborSearcher3D.h"
+
+// VTK
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+
+VoronoiTileNeighborQuery::VoronoiTileNeighborQuery(unsigned int dimension)
+  : Dimension(dimension == 3 ? 3 : 2), Searcher2D(0), Searcher3D(0)
+{
+}
+
+VoronoiTileNeighborQuery::~VoronoiTileNeighborQuery()
+{
+  delete this->Searcher2D;
+  delete this->Searcher3D;
+}
+
+unsigned int VoronoiTileNeighborQuery::GetDimension() const
+{
+  return this->Dimension;
+}
+
+std::size_t VoronoiTileNeighborQuery::GetBytesPerPoint() const
+{
+  // The kd-tree, plus the flattened copy of the points the 2D searcher may make
+  return this->Dimension == 2 ? 96 : 64;
+}
+
+void VoronoiTileNeighborQuery::SetTilePoints(const std::vector<double>& xyz, const double bounds[6])
+{
+  delete this->Searcher2D;
+  delete this->Searcher3D;
+  this->Searcher2D = 0;
+  this->Searcher3D = 0;
+
+  // The array only borrows the coordinates, it does not free them
+  vtkSmartPointer<vtkDoubleArray> coordinates =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  coordinates->SetNumberOfComponents(3);
+  if(!xyz.empty())
+    {
+    coordinates->SetArray(const_cast<double*>(&xyz[0]), static_cast<vtkIdType>(xyz.size()), 1);
+    }
+
+  this->Points = vtkSmartPointer<vtkPoints>::New();
+  this->Points->SetData(coordinates);
+  if(this->Dimension == 2)
+    {
+    this->Searcher2D = new LocalVoronoiNeighborSearcher(this->Points);
+    this->Searcher2D->SetBounds(bounds);
+    }
+  else
+    {
+    this->Searcher3D = new LocalVoronoiNeighborSearcher3D(this->Points);
+    this->Searcher3D->SetBounds(bounds);
+    }
+}
+
+double VoronoiTileNeighborQuery::Query(std::size_t pointIndex, std::vector<std::size_t>& neighborIndices) const
+{
+  vtkSmartPointer<vtkIdList> neighborIds =
+    vtkSmartPointer<vtkIdList>::New();
+  double securityRadius;
+  if(this->Searcher2D)
+    {
+    this->Searcher2D->Query(static_cast<vtkIdType>(pointIndex), neighborIds, 16, 0, &securityRadius);
+    }
+  else
+    {
+    this->Searcher3D->Query(static_cast<vtkIdType>(pointIndex), neighborIds, 32, 0, &securityRadius);
+    }
+
+  neighborIndices.resize(neighborIds->GetNumberOfIds());
+  for(vtkIdType i = 0; i < neighborIds->GetNumberOfIds(); ++i)
+    {
+    neighborIndices[i] = static_cast<std::size_t>(neighborIds->GetId(i));
+    }
+  return securityRadius;
+}
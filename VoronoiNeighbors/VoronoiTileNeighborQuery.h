@@ -0,0 +1,66 @@
+/*=========================================================================
+ *
+ *  Copyright David Doria 2011 daviddoria@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef VORONOITILENEIGHBORQUERY_H
+#define VORONOITILENEIGHBORQUERY_H
+
+// STL
+#include <vector>
+
+// VTK
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+
+// Custom
+#include "TiledNeighborSearch.h"
+
+class LocalVoronoiNeighborSearcher;
+class LocalVoronoiNeighborSearcher3D;
+
+// The Voronoi neighbor search run on each tile by TiledNeighborSearch, with
+// LocalVoronoiNeighborSearcher in 2D or LocalVoronoiNeighborSearcher3D in 3D. The
+// cells are clipped to the bounds of the whole cloud, and the cell of a point is
+// exact when the ball of its security radius lies inside the loaded region. The halo
+// width should be about twice the largest distance from a point to its cell's vertices.
+class VoronoiTileNeighborQuery : public SmartNeighbors::TileNeighborQuery
+{
+public:
+  // 'dimension' is 2 or 3
+  VoronoiTileNeighborQuery(unsigned int dimension = 2);
+  ~VoronoiTileNeighborQuery();
+
+  unsigned int GetDimension() const;
+  std::size_t GetBytesPerPoint() const;
+
+  // The coordinates are wrapped rather than copied, so 'xyz' must outlive the queries
+  void SetTilePoints(const std::vector<double>& xyz, const double bounds[6]);
+
+  double Query(std::size_t pointIndex, std::vector<std::size_t>& neighborIndices) const;
+
+private:
+  // Not copyable, the searchers are deleted by the destructor
+  VoronoiTileNeighborQuery(const VoronoiTileNeighborQuery&);
+  void operator=(const VoronoiTileNeighborQuery&);
+
+  unsigned int Dimension;
+  vtkSmartPointer<vtkPoints> Points;
+  LocalVoronoiNeighborSearcher* Searcher2D;
+  LocalVoronoiNeighborSearcher3D* Searcher3D;
+};
+
+#endif